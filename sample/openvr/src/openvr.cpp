@@ -346,7 +346,7 @@ int main(int argc, char **argv) {
 				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
 			VkAttachmentDescription{ 0, VK_FORMAT_D16_UNORM,
 			VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR,
-			VK_ATTACHMENT_STORE_OP_STORE, VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 			VK_ATTACHMENT_STORE_OP_DONT_CARE,
 			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
 			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL }
@@ -431,10 +431,11 @@ int main(int argc, char **argv) {
 			std::ref(device), 0, VK_IMAGE_TYPE_2D, VK_FORMAT_D16_UNORM,
 			{ extent.width, extent.height, 1 }, 1, 1,
 			VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+				| VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
 			VK_SHARING_MODE_EXCLUSIVE, {}, VK_IMAGE_LAYOUT_UNDEFINED)));
 	vcc::memory::bind(std::ref(device),
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, *depth_image);
+		vcc::memory::transient, *depth_image);
 
 	{
 		vcc::command_buffer::command_buffer_type command_buffer(
@@ -420,9 +420,10 @@ int main(int argc, const char **argv) {
 				std::ref(device), 0, VK_IMAGE_TYPE_2D, depth_format,
 				{ extent.width, extent.height, 1 }, 1, 1,
 				VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
-				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+					| VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
 				VK_SHARING_MODE_EXCLUSIVE, {}, VK_IMAGE_LAYOUT_UNDEFINED)));
-		vcc::memory::bind(std::ref(device), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, *depth_image);
+		vcc::memory::bind(std::ref(device), vcc::memory::transient, *depth_image);
 
 		vcc::command_buffer::command_buffer_type command_buffer(std::move(
 			vcc::command_buffer::allocate(std::ref(device), std::ref(cmd_pool),
@@ -21,6 +21,7 @@
 #include <vcc/internal/loader.h>
 #include <vcc/memory.h>
 #include <vcc/queue.h>
+#include <vcc/transient.h>
 
 namespace vcc {
 namespace image {
@@ -86,18 +87,15 @@ image::image_type gli_loader_type::load(
 		usage, sharingMode, queueFamilyIndices, VK_IMAGE_LAYOUT_UNDEFINED));
 	memory::bind(device, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image);
 
-	command_pool::command_pool_type command_pool(command_pool::create(device,
-		VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-		queue::get_family_index(*queue)));
-	command_buffer::command_buffer_type command_buffer(std::move(command_buffer::allocate(
-		device, std::ref(command_pool), VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1).front()));
+	transient::command_type command(transient::acquire(*queue));
+	command_buffer::command_buffer_type &command_buffer(
+		transient::get_command_buffer(command));
 	image::image_type staging_image(image::create(device, 0, VK_IMAGE_TYPE_2D,
 		format, VkExtent3D{ extent.width, extent.height, 1 }, 1, 1,
 		VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_LINEAR,
 		VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE,
 		{ queue::get_family_index(*queue) }, VK_IMAGE_LAYOUT_PREINITIALIZED));
-	memory::bind(device, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, staging_image);
-	vcc::fence::fence_type fence(vcc::fence::create(device));
+	memory::bind(device, memory::cpu_only, staging_image);
 
 	for (std::size_t layer = 0; layer < texture.layers(); ++layer) {
 		for (std::size_t face = 0; face < texture.faces(); ++face) {
@@ -127,9 +125,7 @@ image::image_type gli_loader_type::load(
 						VK_QUEUE_FAMILY_IGNORED,
 						std::ref(staging_image),
 						{ aspect_mask, 0, 1, 0, 1 } } }));
-					fence::reset(*device, { fence });
-					queue::submit(*queue, {}, { command_buffer }, {}, fence);
-					fence::wait(*device, { fence }, true);
+					transient::submit_and_wait(*queue, command);
 
 					copy_to_linear_image(format, aspect_mask,
 						VkExtent2D{ uint32_t(copy_extent.x), uint32_t(copy_extent.y) },
@@ -173,9 +169,7 @@ image::image_type gli_loader_type::load(
 							{ 0, 0, int32_t(z) },
 							{ uint32_t(extent.x), uint32_t(extent.y), 1 }
 					} } });
-					fence::reset(*device, { fence });
-					queue::submit(*queue, {}, { command_buffer }, {}, fence);
-					fence::wait(*device, { fence }, true);
+					transient::submit_and_wait(*queue, command);
 				}
 			}
 		}
@@ -0,0 +1,43 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <vcc/bindless.h>
+
+#if defined(VK_EXT_descriptor_indexing)
+
+using vcc::bindless::internal::slot_allocator_type;
+
+TEST(BindlessTest, ReleasedSlotsAreReused) {
+	slot_allocator_type slots(2);
+	EXPECT_EQ(0u, vcc::bindless::internal::acquire(slots));
+	EXPECT_EQ(1u, vcc::bindless::internal::acquire(slots));
+	EXPECT_THROW(vcc::bindless::internal::acquire(slots), vcc::vcc_exception);
+	vcc::bindless::internal::release(slots, 0);
+	EXPECT_EQ(0u, vcc::bindless::internal::acquire(slots));
+}
+
+TEST(BindlessTest, ReleaseRejectsSlotsNotInUse) {
+	slot_allocator_type slots(2);
+	const uint32_t slot(vcc::bindless::internal::acquire(slots));
+	vcc::bindless::internal::release(slots, slot);
+	EXPECT_THROW(vcc::bindless::internal::release(slots, slot), vcc::vcc_exception);
+	EXPECT_THROW(vcc::bindless::internal::release(slots, 1), vcc::vcc_exception);
+	EXPECT_THROW(vcc::bindless::internal::release(slots, 2), vcc::vcc_exception);
+	EXPECT_EQ(slot, vcc::bindless::internal::acquire(slots));
+	EXPECT_EQ(1u, vcc::bindless::internal::acquire(slots));
+}
+
+#endif // VK_EXT_descriptor_indexing
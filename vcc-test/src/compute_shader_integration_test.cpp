@@ -29,6 +29,7 @@
 #include <vcc/physical_device.h>
 #include <vcc/pipeline_layout.h>
 #include <vcc/queue.h>
+#include <vcc/readback.h>
 #include <vcc/shader_module.h>
 
 TEST(ComputeShaderIntegrationTest, ComputeShaderIntegrationTest1) {
@@ -85,9 +86,10 @@ TEST(ComputeShaderIntegrationTest, ComputeShaderIntegrationTest1) {
 	vcc::buffer::buffer_type output_buffer(
 		vcc::buffer::create(std::ref(device), 0,
 			num_elements * sizeof(decltype(input_array)::value_type),
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, {}));
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_SHARING_MODE_EXCLUSIVE, {}));
 	const type::supplier<const vcc::memory::memory_type> output_memory(
-		vcc::memory::bind(std::ref(device), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, output_buffer));
+		vcc::memory::bind(std::ref(device), vcc::memory::gpu_to_cpu, output_buffer));
 
 	vcc::descriptor_set::update(device,
 		vcc::descriptor_set::write_buffer(desc_set, 0, 0,
@@ -146,6 +148,8 @@ TEST(ComputeShaderIntegrationTest, ComputeShaderIntegrationTest1) {
 
 	{
 		vcc::memory::map_type map(vcc::memory::map(output_memory));
+		vcc::memory::invalidate({ vcc::memory::mapped_range_type{ output_memory, 0,
+			VK_WHOLE_SIZE } });
 		const auto output_ptr(
 			reinterpret_cast<decltype(input_array)::value_type *>(map.data));
 		auto read_input_array(type::read(input_array));
@@ -153,4 +157,17 @@ TEST(ComputeShaderIntegrationTest, ComputeShaderIntegrationTest1) {
 			ASSERT_FLOAT_EQ(2 * read_input_array[i], output_ptr[i]);
 		}
 	}
+
+	{
+		type::float_array result_array(num_elements);
+		vcc::readback::readback_type readback(vcc::readback::create(std::ref(device)));
+		vcc::readback::read(readback, queue,
+			type::make_supplier<const vcc::buffer::buffer_type>(output_buffer), 0,
+			std::ref(result_array)).get();
+		auto read_input_array(type::read(input_array));
+		auto read_result_array(type::read(result_array));
+		for (int i = 0; i < num_elements; ++i) {
+			ASSERT_FLOAT_EQ(2 * read_input_array[i], read_result_array[i]);
+		}
+	}
 }
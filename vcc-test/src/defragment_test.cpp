@@ -0,0 +1,75 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <vcc/defragment.h>
+
+using vcc::defragment::internal::candidate_type;
+
+candidate_type candidate(VkDeviceSize size, VkDeviceSize used, VkDeviceSize bound,
+		VkMemoryPropertyFlags propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+	return candidate_type{ nullptr, propertyFlags, size, used, bound, {} };
+}
+
+TEST(DefragmentTest, SelectsSparseFullyRegisteredAllocations) {
+	std::vector<candidate_type> candidates{
+		candidate(1024, 256, 256),
+		// Half used is not below the default utilization.
+		candidate(1024, 512, 512),
+		// A resource that is not registered is still bound.
+		candidate(1024, 128, 384),
+		candidate(1024, 64, 64)
+	};
+	vcc::defragment::internal::select(candidates, .5f);
+	ASSERT_EQ(2u, candidates.size());
+	EXPECT_EQ(64u, candidates[0].used);
+	EXPECT_EQ(256u, candidates[1].used);
+}
+
+TEST(DefragmentTest, DestroyedResourcesMakeAllocationsCandidates) {
+	// Everything bound when allocated, then all but one buffer destroyed.
+	std::vector<candidate_type> candidates{ candidate(1024, 1024, 1024) };
+	vcc::defragment::internal::select(candidates, .5f);
+	EXPECT_TRUE(candidates.empty());
+	candidates.push_back(candidate(1024, 128, 128));
+	vcc::defragment::internal::select(candidates, .5f);
+	EXPECT_EQ(1u, candidates.size());
+}
+
+TEST(DefragmentTest, BatchesShareFlagsAndFitTheBlock) {
+	std::vector<candidate_type> candidates{
+		candidate(1024, 300, 300),
+		candidate(1024, 300, 300, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT),
+		candidate(1024, 300, 300),
+		candidate(1024, 500, 500)
+	};
+	const std::vector<candidate_type> batch(
+		vcc::defragment::internal::next_batch(candidates, 700));
+	ASSERT_EQ(2u, batch.size());
+	EXPECT_EQ(VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+		batch[1].propertyFlags);
+	ASSERT_EQ(2u, candidates.size());
+	EXPECT_EQ(VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT),
+		candidates[0].propertyFlags);
+	EXPECT_EQ(500u, candidates[1].used);
+}
+
+TEST(DefragmentTest, OversizedCandidateFormsItsOwnBatch) {
+	std::vector<candidate_type> candidates{ candidate(4096, 2000, 2000),
+		candidate(4096, 100, 100) };
+	EXPECT_EQ(1u, vcc::defragment::internal::next_batch(candidates, 1024).size());
+	EXPECT_EQ(1u, vcc::defragment::internal::next_batch(candidates, 1024).size());
+	EXPECT_TRUE(vcc::defragment::internal::next_batch(candidates, 1024).empty());
+}
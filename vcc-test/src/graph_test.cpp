@@ -0,0 +1,136 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <vcc/graph.h>
+
+using vcc::graph::internal::access_type;
+using vcc::graph::internal::pass_info_type;
+using vcc::graph::internal::placement_type;
+using vcc::graph::internal::resource_info_type;
+using vcc::graph::internal::usage_type;
+
+resource_info_type transient_resource(bool is_image) {
+	resource_info_type resource = {};
+	resource.is_image = is_image;
+	return resource;
+}
+
+pass_info_type pass(const std::vector<access_type> &accesses,
+		vcc::graph::pass_flags flags = 0) {
+	return pass_info_type{ "", accesses, vcc::graph::record_callback_type(), flags };
+}
+
+access_type read(vcc::graph::resource_type resource,
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED) {
+	return access_type{ resource, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT, layout, layout, false };
+}
+
+access_type write(vcc::graph::resource_type resource,
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED) {
+	return access_type{ resource, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, layout, layout, true };
+}
+
+usage_type usage(int first, int last) {
+	return usage_type{ -1, -1, first, last, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, 0, 0 };
+}
+
+TEST(GraphTest, CullsPassesWithoutEffects) {
+	std::vector<resource_info_type> resources{ transient_resource(false),
+		transient_resource(false), transient_resource(true) };
+	resources[2].imported = true;
+	const std::vector<pass_info_type> passes{
+		// Nothing reads what it writes.
+		pass({ write(0) }),
+		// Overwritten before it is read.
+		pass({ write(1) }),
+		pass({ write(1) }),
+		pass({ read(1), write(2) }),
+		pass({}, vcc::graph::pass_side_effect_bit) };
+	ASSERT_EQ(std::vector<bool>({ false, false, true, true, true }),
+		vcc::graph::internal::cull(resources, passes));
+}
+
+TEST(GraphTest, WritesWaitForReads) {
+	const std::vector<resource_info_type> resources{ transient_resource(false),
+		transient_resource(false) };
+	const std::vector<pass_info_type> passes{
+		pass({ write(0) }),
+		pass({ read(0) }),
+		pass({ read(0) }),
+		pass({ write(0) }),
+		pass({ write(1) }) };
+	std::vector<usage_type> usages;
+	ASSERT_EQ(std::vector<int>({ 0, 1, 1, 2, 0 }), vcc::graph::internal::assign_levels(
+		resources, passes, std::vector<bool>(passes.size(), true), usages));
+	ASSERT_EQ(0, usages[0].first);
+	ASSERT_EQ(2, usages[0].last);
+}
+
+TEST(GraphTest, LayoutChangesWaitForReads) {
+	const std::vector<resource_info_type> resources{ transient_resource(true),
+		transient_resource(false) };
+	const std::vector<pass_info_type> passes{
+		pass({ write(0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL), write(1) }),
+		pass({ read(0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) }),
+		// Layouts are ignored for buffers.
+		pass({ read(1, VK_IMAGE_LAYOUT_GENERAL) }),
+		// A transition is a write, so it waits for the read before it.
+		pass({ read(0, VK_IMAGE_LAYOUT_GENERAL) }) };
+	std::vector<usage_type> usages;
+	ASSERT_EQ(std::vector<int>({ 0, 1, 1, 2 }), vcc::graph::internal::assign_levels(
+		resources, passes, std::vector<bool>(passes.size(), true), usages));
+	ASSERT_EQ(VK_IMAGE_LAYOUT_GENERAL, usages[0].layout);
+}
+
+TEST(GraphTest, CulledPassesGetNoLevel) {
+	const std::vector<resource_info_type> resources{ transient_resource(false) };
+	const std::vector<pass_info_type> passes{ pass({ write(0) }), pass({ read(0) }) };
+	std::vector<usage_type> usages;
+	ASSERT_EQ(std::vector<int>({ -1, 0 }), vcc::graph::internal::assign_levels(
+		resources, passes, { false, true }, usages));
+}
+
+TEST(GraphTest, AliasesResourcesWithDisjointLifetimes) {
+	const VkDeviceSize granularity(1024);
+	const std::vector<usage_type> usages{ usage(0, 1), usage(2, 3), usage(0, 3) };
+	const std::vector<VkMemoryRequirements> requirements{
+		VkMemoryRequirements{ 4096, 256, ~0u },
+		VkMemoryRequirements{ 4096, 256, ~0u },
+		VkMemoryRequirements{ 1000, 256, ~0u } };
+	std::vector<placement_type> placements{ placement_type{ 0, 0, 0 },
+		placement_type{ 1, 0, 0 }, placement_type{ 2, 0, 0 } };
+	ASSERT_EQ(5120u, vcc::graph::internal::place(usages, requirements, granularity,
+		placements));
+
+	std::vector<placement_type> by_resource(placements.size());
+	for (const placement_type &placement : placements) {
+		ASSERT_EQ(0u, placement.offset % granularity);
+		by_resource[placement.resource] = placement;
+	}
+	ASSERT_EQ(by_resource[0].offset, by_resource[1].offset);
+	for (const placement_type &lhs : placements) {
+		for (const placement_type &rhs : placements) {
+			const usage_type &lhs_usage(usages[lhs.resource]), &rhs_usage(usages[rhs.resource]);
+			if (lhs.resource != rhs.resource && lhs_usage.first <= rhs_usage.last
+					&& rhs_usage.first <= lhs_usage.last) {
+				ASSERT_TRUE(lhs.offset + lhs.size <= rhs.offset
+					|| rhs.offset + rhs.size <= lhs.offset);
+			}
+		}
+	}
+}
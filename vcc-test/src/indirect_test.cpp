@@ -0,0 +1,51 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vcc/indirect.h>
+
+template<type::memory_layout Layout>
+std::vector<VkDrawIndexedIndirectCommand> serialize(
+		vcc::indirect::draw_indexed_command_array &commands) {
+	const type::serialize_type serialize(type::make_serialize<Layout>(
+		type::make_supplier(std::ref(commands))));
+	std::vector<uint8_t> bytes(type::size(serialize));
+	type::flush(serialize, bytes.data());
+	std::vector<VkDrawIndexedIndirectCommand> serialized(
+		bytes.size() / sizeof(VkDrawIndexedIndirectCommand));
+	std::memcpy(serialized.data(), bytes.data(), bytes.size());
+	return serialized;
+}
+
+void expect_commands(const std::vector<VkDrawIndexedIndirectCommand> &serialized) {
+	ASSERT_EQ(2u, serialized.size());
+	EXPECT_EQ(36u, serialized[0].indexCount);
+	EXPECT_EQ(-4, serialized[0].vertexOffset);
+	EXPECT_EQ(6u, serialized[1].indexCount);
+	EXPECT_EQ(7u, serialized[1].instanceCount);
+	EXPECT_EQ(8u, serialized[1].firstIndex);
+	EXPECT_EQ(9, serialized[1].vertexOffset);
+	EXPECT_EQ(10u, serialized[1].firstInstance);
+}
+
+// Commands must be packed like the device reads them, whether written by
+// the host or by a culling shader.
+TEST(IndirectTest, DrawIndexedCommandsArePacked) {
+	vcc::indirect::draw_indexed_command_array commands{ {
+		{ 36, 1, 0, -4, 0 }, { 6, 7, 8, 9, 10 } } };
+	expect_commands(serialize<type::linear>(commands));
+	expect_commands(serialize<type::linear_std430>(commands));
+}
@@ -0,0 +1,56 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <vcc/memory.h>
+
+VkPhysicalDeviceMemoryProperties memory_types(
+		const std::vector<VkMemoryPropertyFlags> &flags) {
+	VkPhysicalDeviceMemoryProperties properties = {};
+	properties.memoryTypeCount = uint32_t(flags.size());
+	for (std::size_t i = 0; i < flags.size(); ++i) {
+		properties.memoryTypes[i].propertyFlags = flags[i];
+	}
+	properties.memoryHeapCount = 1;
+	return properties;
+}
+
+TEST(MemoryTypeTest, ReadbackPrefersCachedOverCoherent) {
+	const VkPhysicalDeviceMemoryProperties properties(memory_types({
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT }));
+	ASSERT_EQ(2u, vcc::memory::internal::find_memory_type(properties, ~0u,
+		vcc::memory::gpu_to_cpu));
+	ASSERT_EQ(1u, vcc::memory::internal::find_memory_type(properties, ~0u,
+		vcc::memory::cpu_to_gpu));
+}
+
+TEST(MemoryTypeTest, RanksFallbacksBestFirst) {
+	const VkPhysicalDeviceMemoryProperties properties(memory_types({
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT }));
+	ASSERT_EQ(std::vector<uint32_t>({ 1, 2, 0 }), vcc::memory::internal::rank_memory_types(
+		properties, ~0u, vcc::memory::gpu_only));
+	ASSERT_EQ(std::vector<uint32_t>({ 2, 0 }), vcc::memory::internal::rank_memory_types(
+		properties, ~0u, vcc::memory::cpu_to_gpu));
+	// Types outside memoryTypeBits are never candidates.
+	ASSERT_EQ(std::vector<uint32_t>({ 0 }), vcc::memory::internal::rank_memory_types(
+		properties, 1u, vcc::memory::cpu_to_gpu));
+	ASSERT_THROW(vcc::memory::internal::find_memory_type(properties, 2u,
+		vcc::memory::cpu_to_gpu), vcc::vcc_exception);
+}
@@ -0,0 +1,45 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <vcc/physical_device.h>
+
+VkQueueFamilyProperties queue_family(VkQueueFlags flags) {
+	VkQueueFamilyProperties properties = {};
+	properties.queueFlags = flags;
+	properties.queueCount = 1;
+	return properties;
+}
+
+TEST(QueueFamilyTest, PrefersDedicatedFamilies) {
+	const std::vector<VkQueueFamilyProperties> properties{
+		queue_family(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT),
+		queue_family(VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT),
+		queue_family(VK_QUEUE_TRANSFER_BIT | VK_QUEUE_SPARSE_BINDING_BIT) };
+	ASSERT_EQ(2u, vcc::physical_device::get_transfer_queue_family(properties));
+	ASSERT_EQ(1u, vcc::physical_device::get_compute_queue_family(properties));
+	ASSERT_EQ(0u, vcc::physical_device::get_dedicated_queue_family(properties,
+		VK_QUEUE_GRAPHICS_BIT, 0));
+}
+
+TEST(QueueFamilyTest, FallsBackToSharedFamilies) {
+	// Graphics families support transfers without reporting it.
+	const std::vector<VkQueueFamilyProperties> properties{
+		queue_family(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT) };
+	ASSERT_EQ(0u, vcc::physical_device::get_transfer_queue_family(properties));
+	ASSERT_EQ(0u, vcc::physical_device::get_compute_queue_family(properties));
+	ASSERT_THROW(vcc::physical_device::get_dedicated_queue_family(properties,
+		VK_QUEUE_SPARSE_BINDING_BIT, 0), vcc::vcc_exception);
+}
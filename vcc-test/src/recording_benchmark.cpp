@@ -0,0 +1,137 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#define NOMINMAX
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include <vcc/command.h>
+#include <vcc/command_pool.h>
+#include <vcc/descriptor_pool.h>
+#include <vcc/descriptor_set.h>
+#include <vcc/device.h>
+#include <vcc/instance.h>
+#include <vcc/physical_device.h>
+#include <vcc/pipeline.h>
+#include <vcc/pipeline_layout.h>
+#include <vcc/queue.h>
+#include <vcc/shader_module.h>
+
+// Replacing the global allocation functions affects the whole binary, which
+// is why the benchmarks are a target of their own.
+std::atomic<bool> count_allocations(false);
+std::atomic<std::size_t> allocations(0);
+
+void *operator new(std::size_t size) {
+	if (count_allocations) {
+		++allocations;
+	}
+	if (void *const memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+	std::free(memory);
+}
+
+// Records a dispatch binding a descriptor set per draw into the same command
+// buffer a few times. Only the first recording may allocate, later ones reuse
+// the memory of the references and pre-execute hooks.
+TEST(RecordingBenchmark, AllocationsPerDraw) {
+	const uint32_t draws(20000);
+	vcc::instance::instance_type instance(vcc::instance::create({}, {}));
+	const VkPhysicalDevice physical_device(
+		vcc::physical_device::enumerate(instance).front());
+	vcc::device::device_type device(vcc::device::create(physical_device,
+		{ vcc::device::queue_create_info_type{
+			vcc::physical_device::get_queue_family_properties_with_flag(
+				vcc::physical_device::queue_famility_properties(physical_device),
+				VK_QUEUE_COMPUTE_BIT), { 0 } } }, {}, {}, {}));
+	vcc::queue::queue_type queue(vcc::queue::get_queue(std::ref(device),
+		VK_QUEUE_COMPUTE_BIT));
+
+	vcc::descriptor_set_layout::descriptor_set_layout_type descriptor_set_layout(
+		vcc::descriptor_set_layout::create(std::ref(device), {
+			vcc::descriptor_set_layout::descriptor_set_layout_binding{ 0,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, {} },
+			vcc::descriptor_set_layout::descriptor_set_layout_binding{ 1,
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, {} } }));
+	vcc::pipeline_layout::pipeline_layout_type pipeline_layout(vcc::pipeline_layout::create(
+		std::ref(device), { std::ref(descriptor_set_layout) }));
+	vcc::descriptor_pool::descriptor_pool_type descriptor_pool(
+		vcc::descriptor_pool::create(std::ref(device), 0, 1, {
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 } }));
+	vcc::descriptor_set::descriptor_set_type descriptor_set(std::move(
+		vcc::descriptor_set::create(std::ref(device), std::ref(descriptor_pool),
+			{ std::ref(descriptor_set_layout) }).front()));
+
+	// Compiled by the vcc-test target.
+	vcc::shader_module::shader_module_type shader_module(
+		vcc::shader_module::create(std::ref(device), std::ifstream("integration-test-1.spv",
+			std::ios_base::binary | std::ios_base::in)));
+	vcc::pipeline_cache::pipeline_cache_type pipeline_cache(
+		vcc::pipeline_cache::create(std::ref(device)));
+	vcc::pipeline::pipeline_type pipeline(vcc::pipeline::create_compute(std::ref(device),
+		pipeline_cache, 0, vcc::pipeline::shader_stage(VK_SHADER_STAGE_COMPUTE_BIT,
+			std::ref(shader_module), "main"), std::ref(pipeline_layout)));
+
+	vcc::command_pool::command_pool_type command_pool(vcc::command_pool::create(
+		std::ref(device), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+		vcc::queue::get_family_index(queue)));
+	vcc::command_buffer::command_buffer_type command_buffer(std::move(
+		vcc::command_buffer::allocate(std::ref(device), std::ref(command_pool),
+			VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1).front()));
+
+	// Built once, like the commands of a scene kept between frames.
+	const vcc::command::bind_pipeline bind_pipeline{ VK_PIPELINE_BIND_POINT_COMPUTE,
+		std::ref(pipeline) };
+	const vcc::command::bind_descriptor_sets bind_descriptor_sets{
+		VK_PIPELINE_BIND_POINT_COMPUTE, std::ref(pipeline_layout), 0,
+		{ std::ref(descriptor_set) }, {} };
+	const vcc::command::dispatch dispatch{ 1, 1, 1 };
+
+	for (int recording = 0; recording < 3; ++recording) {
+		allocations = 0;
+		count_allocations = true;
+		const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+		{
+			vcc::command::build_type build(vcc::command::build(std::ref(command_buffer),
+				0, VK_FALSE, 0, 0));
+			vcc::command::internal::cmd(build, bind_pipeline);
+			for (uint32_t draw = 0; draw < draws; ++draw) {
+				vcc::command::internal::cmd(build, bind_descriptor_sets);
+				vcc::command::internal::cmd(build, dispatch);
+			}
+		}
+		const std::chrono::nanoseconds elapsed(std::chrono::steady_clock::now() - start);
+		count_allocations = false;
+
+		RecordProperty("ns_per_draw_" + std::to_string(recording),
+			int(elapsed.count() / draws));
+		if (recording) {
+			ASSERT_EQ(0u, allocations.load());
+		} else {
+			// The arenas grow geometrically, a handful of blocks each.
+			ASSERT_LT(allocations.load(), 64u);
+		}
+	}
+}
@@ -0,0 +1,90 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <vcc/command.h>
+#include <vcc/internal/hook.h>
+
+TEST(RecordingTest, KeyedHooksOncePerSubmit) {
+	int descriptor_set, input_buffer, checks(0), flushes(0);
+	vcc::internal::hook_container_type<const int &> secondary, primary1, primary2;
+	for (int draw = 0; draw < 1000; ++draw) {
+		secondary.add(&descriptor_set, [&checks](const int &queue) {
+			++checks;
+		});
+		primary1.add(&input_buffer, [&flushes](const int &queue) {
+			++flushes;
+		});
+	}
+	primary1.add_nested(secondary);
+	primary2.add_nested(secondary);
+	primary2.add(&input_buffer, [&flushes](const int &queue) {
+		++flushes;
+	});
+
+	// Like queue::submit with both primary command buffers.
+	vcc::internal::key_set_type called;
+	primary1(called, 0);
+	primary2(called, 0);
+	ASSERT_EQ(1, checks);
+	ASSERT_EQ(1, flushes);
+}
+
+TEST(RecordingTest, LocalHooksOncePerContainer) {
+	int layout, checks(0);
+	vcc::internal::hook_container_type<const int &> secondary, primary1, primary2;
+	for (int draw = 0; draw < 1000; ++draw) {
+		secondary.add_local(&layout, [&checks](const int &queue) {
+			++checks;
+		});
+		primary1.add_local(&layout, [&checks](const int &queue) {
+			++checks;
+		});
+	}
+	primary1.add_nested(secondary);
+	primary2.add_nested(secondary);
+	primary2.add_local(&layout, [&checks](const int &queue) {
+		++checks;
+	});
+
+	// Each command buffer checks what it recorded, the secondary only once.
+	vcc::internal::key_set_type called;
+	primary1(called, 0);
+	primary2(called, 0);
+	ASSERT_EQ(3, checks);
+}
+
+// compile_cached records again only when the content hash changes.
+TEST(RecordingTest, ContentHashFollowsCommands) {
+	const std::size_t draws(100);
+	const vcc::command::set_viewport viewport{ 0,
+		std::vector<VkViewport>(1, VkViewport{ 0, 0, 640, 480, 0, 1 }) };
+	const uint32_t constants[] = { 1, 2, 3, 4 };
+	const vcc::command::push_constants_type push_constants{
+		type::supplier<const vcc::pipeline_layout::pipeline_layout_type>(),
+		VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), constants };
+	const auto hash = [&](uint32_t firstVertex) {
+		vcc::command::internal::hash_type content;
+		for (std::size_t draw = 0; draw < draws; ++draw) {
+			vcc::command::internal::hash_all(content, viewport, push_constants,
+				vcc::command::draw{ 3, 1, firstVertex, 0 });
+		}
+		return content.value;
+	};
+
+	const uint64_t value(hash(0));
+	ASSERT_EQ(value, hash(0));
+	ASSERT_NE(value, hash(1));
+}
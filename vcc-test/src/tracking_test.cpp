@@ -0,0 +1,190 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <vcc/tracking.h>
+
+using vcc::tracking::internal::access_state_type;
+using vcc::tracking::internal::buffer_piece_type;
+using vcc::tracking::internal::tracker_type;
+
+const access_state_type idle = { 0, 0, 0, 0, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+
+// Handles are never dereferenced, any distinct value will do.
+template<typename T>
+T handle(uintptr_t value) {
+	return (T) value;
+}
+
+struct barrier_masks_type {
+	barrier_masks_type() : src_stages(0), src_access(0), dst_access(0) {}
+
+	VkPipelineStageFlags src_stages;
+	VkAccessFlags src_access, dst_access;
+};
+
+bool prepare(access_state_type &state, VkPipelineStageFlags stage, VkAccessFlags access,
+		barrier_masks_type &masks, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED) {
+	return vcc::tracking::internal::prepare(state, stage, access, layout, masks.src_stages,
+		masks.src_access, masks.dst_access);
+}
+
+TEST(TrackingTest, ReadAfterWriteMakesTheWriteVisible) {
+	access_state_type state(idle);
+	barrier_masks_type masks;
+	EXPECT_FALSE(prepare(state, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		masks));
+	EXPECT_TRUE(prepare(state, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, masks));
+	EXPECT_EQ(VkPipelineStageFlags(VK_PIPELINE_STAGE_TRANSFER_BIT), masks.src_stages);
+	EXPECT_EQ(VkAccessFlags(VK_ACCESS_TRANSFER_WRITE_BIT), masks.src_access);
+	EXPECT_EQ(VkAccessFlags(VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT), masks.dst_access);
+	barrier_masks_type again;
+	EXPECT_FALSE(prepare(state, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, again));
+}
+
+TEST(TrackingTest, WriteAfterReadOnlyNeedsExecutionDependency) {
+	access_state_type state(idle);
+	barrier_masks_type masks;
+	EXPECT_FALSE(prepare(state, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT, masks));
+	EXPECT_TRUE(prepare(state, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		masks));
+	EXPECT_EQ(VkPipelineStageFlags(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT), masks.src_stages);
+	EXPECT_EQ(0u, masks.src_access);
+	EXPECT_EQ(0u, masks.dst_access);
+}
+
+TEST(TrackingTest, AppliedBarriersChainThroughOrderedStages) {
+	access_state_type state(idle);
+	barrier_masks_type masks;
+	prepare(state, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, masks);
+	EXPECT_TRUE(vcc::tracking::internal::apply(state, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_SHADER_READ_BIT));
+	// Redundant, already ordered and visible.
+	EXPECT_FALSE(vcc::tracking::internal::apply(state, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_SHADER_READ_BIT));
+	// Chains from the compute stage on to the fragment stage.
+	EXPECT_TRUE(vcc::tracking::internal::apply(state, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_ACCESS_SHADER_READ_BIT));
+	EXPECT_FALSE(prepare(state, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT, masks));
+}
+
+TEST(TrackingTest, LayoutChangesTransition) {
+	access_state_type state(idle);
+	barrier_masks_type masks;
+	EXPECT_TRUE(prepare(state, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		masks, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+	EXPECT_EQ(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, state.layout);
+	barrier_masks_type sample;
+	EXPECT_TRUE(prepare(state, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT, sample, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+	EXPECT_EQ(VkPipelineStageFlags(VK_PIPELINE_STAGE_TRANSFER_BIT), sample.src_stages);
+	EXPECT_EQ(VkAccessFlags(VK_ACCESS_TRANSFER_WRITE_BIT), sample.src_access);
+	EXPECT_EQ(VkAccessFlags(VK_ACCESS_SHADER_READ_BIT), sample.dst_access);
+	EXPECT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, state.layout);
+}
+
+TEST(TrackingTest, PiecesSplitAndMergeBack) {
+	std::map<VkDeviceSize, buffer_piece_type> pieces;
+	pieces.emplace(0, buffer_piece_type{ 100, idle });
+	vcc::tracking::internal::split(pieces, 40);
+	vcc::tracking::internal::split(pieces, 60);
+	// Splitting at an existing boundary changes nothing.
+	vcc::tracking::internal::split(pieces, 60);
+	ASSERT_EQ(3u, pieces.size());
+	EXPECT_EQ(40u, pieces.at(0).end);
+	EXPECT_EQ(60u, pieces.at(40).end);
+	EXPECT_EQ(100u, pieces.at(60).end);
+	pieces.at(40).state.read_stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+	vcc::tracking::internal::merge(pieces, 0, 100);
+	EXPECT_EQ(3u, pieces.size());
+	pieces.at(40).state = idle;
+	vcc::tracking::internal::merge(pieces, 0, 100);
+	ASSERT_EQ(1u, pieces.size());
+	EXPECT_EQ(100u, pieces.at(0).end);
+}
+
+TEST(TrackingTest, BufferRangesAreTrackedSeparately) {
+	tracker_type tracker(vcc::tracking::validate, vcc::tracking::report_callback_type());
+	const VkBuffer buffer(handle<VkBuffer>(1));
+	vcc::tracking::internal::access(tracker, buffer, 256, 0, 128,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	EXPECT_EQ(0u, tracker.dst_stages);
+	// The other half was never written.
+	vcc::tracking::internal::access(tracker, buffer, 256, 128, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	EXPECT_EQ(0u, tracker.dst_stages);
+	EXPECT_EQ(2u, tracker.buffers.at(buffer).size());
+	vcc::tracking::internal::access(tracker, buffer, 256, 64, 128,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	EXPECT_EQ(VkPipelineStageFlags(VK_PIPELINE_STAGE_TRANSFER_BIT), tracker.src_stages);
+	EXPECT_EQ(VkPipelineStageFlags(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT), tracker.dst_stages);
+}
+
+TEST(TrackingTest, ImageBarriersMergeIntoRanges) {
+	const VkImage image(handle<VkImage>(1));
+	std::vector<VkImageMemoryBarrier> barriers;
+	for (uint32_t level = 0; level < 2; ++level) {
+		for (uint32_t layer = 0; layer < 3; ++layer) {
+			barriers.push_back(VkImageMemoryBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+				NULL, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_QUEUE_FAMILY_IGNORED,
+				VK_QUEUE_FAMILY_IGNORED, image,
+				VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, level, 1, layer, 1 } });
+		}
+	}
+	// A different layout can not be merged.
+	barriers.push_back(barriers.back());
+	barriers.back().subresourceRange.baseMipLevel = 2;
+	barriers.back().oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	vcc::tracking::internal::merge(barriers);
+	ASSERT_EQ(2u, barriers.size());
+	EXPECT_EQ(0u, barriers[0].subresourceRange.baseMipLevel);
+	EXPECT_EQ(2u, barriers[0].subresourceRange.levelCount);
+	EXPECT_EQ(0u, barriers[0].subresourceRange.baseArrayLayer);
+	EXPECT_EQ(3u, barriers[0].subresourceRange.layerCount);
+	EXPECT_EQ(VK_IMAGE_LAYOUT_GENERAL, barriers[1].oldLayout);
+}
+
+TEST(TrackingTest, MissingBarriersAreReported) {
+	std::vector<std::string> reports;
+	tracker_type tracker(vcc::tracking::automatic, [&reports](const std::string &message) {
+		reports.push_back(message);
+	});
+	const VkBuffer buffer(handle<VkBuffer>(1));
+	vcc::tracking::internal::access(tracker, buffer, 256, 0, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	tracker.render_pass = true;
+	vcc::tracking::internal::access(tracker, buffer, 256, 0, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	vcc::tracking::internal::flush(tracker, VK_NULL_HANDLE, "vkCmdDraw");
+	ASSERT_EQ(1u, reports.size());
+	EXPECT_NE(std::string::npos, reports[0].find("inside a render pass before vkCmdDraw"));
+	EXPECT_EQ(0u, tracker.dst_stages);
+	// Nothing pending, nothing reported.
+	vcc::tracking::internal::flush(tracker, VK_NULL_HANDLE, "vkCmdDraw");
+	tracker.mode = vcc::tracking::validate;
+	tracker.render_pass = false;
+	vcc::tracking::internal::access(tracker, buffer, 256, 0, 16,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	vcc::tracking::internal::flush(tracker, VK_NULL_HANDLE, "vkCmdUpdateBuffer");
+	ASSERT_EQ(2u, reports.size());
+	EXPECT_NE(std::string::npos, reports[1].find("missing barrier before vkCmdUpdateBuffer"));
+}
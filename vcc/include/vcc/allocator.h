@@ -0,0 +1,95 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_ALLOCATOR_H_
+#define _VCC_ALLOCATOR_H_
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <vcc/util.h>
+
+namespace vcc {
+namespace allocator {
+
+struct scope_statistics_type {
+	// Bytes requested by the driver, excluding allocator overhead.
+	std::size_t bytes, peak_bytes, allocations;
+	// Reported through pfnInternalAllocation, allocated by the driver itself.
+	std::size_t internal_bytes;
+};
+
+// Indexed by VkSystemAllocationScope.
+typedef std::array<scope_statistics_type, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1>
+	statistics_type;
+
+namespace internal {
+
+struct scope_counters_type {
+	scope_counters_type() : bytes(0), peak_bytes(0), allocations(0), internal_bytes(0) {}
+
+	std::atomic<std::size_t> bytes, peak_bytes, allocations, internal_bytes;
+};
+
+// Freed blocks of one power of two size, reused before asking the system.
+struct size_class_type {
+	std::mutex mutex;
+	std::vector<void *> blocks;
+};
+
+// Smallest and largest size class is 64 bytes and 64 KiB, larger blocks
+// go straight to the system.
+const std::size_t min_size_class_shift = 6, size_class_count = 11;
+
+struct heap_type {
+	std::array<scope_counters_type, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1> scopes;
+	std::array<size_class_type, size_class_count> size_classes;
+};
+
+}  // namespace internal
+
+/*
+ * Host allocator for the driver, passed to instance::create and
+ * device::create. Small blocks are recycled per size class, each class with
+ * its own lock, so short lived command scope allocations rarely reach the
+ * system allocator. Must outlive every instance and device using it.
+ */
+struct allocator_type {
+	friend const VkAllocationCallbacks *get_callbacks(const allocator_type &allocator);
+	friend VCC_LIBRARY statistics_type statistics(const allocator_type &allocator);
+
+	VCC_LIBRARY allocator_type();
+	allocator_type(const allocator_type &) = delete;
+	allocator_type(allocator_type &&) = delete;
+	allocator_type &operator=(const allocator_type &) = delete;
+	allocator_type &operator=(allocator_type &&) = delete;
+	VCC_LIBRARY ~allocator_type();
+
+private:
+	VkAllocationCallbacks callbacks;
+	internal::heap_type heap;
+};
+
+inline const VkAllocationCallbacks *get_callbacks(const allocator_type &allocator) {
+	return &allocator.callbacks;
+}
+
+VCC_LIBRARY statistics_type statistics(const allocator_type &allocator);
+
+}  // namespace allocator
+}  // namespace vcc
+
+#endif // _VCC_ALLOCATOR_H_
@@ -0,0 +1,146 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_BINDLESS_H_
+#define _VCC_BINDLESS_H_
+
+#include <vcc/command.h>
+
+namespace vcc {
+namespace bindless {
+
+#if defined(VK_EXT_descriptor_indexing)
+
+// The bindings of the global set, arrays indexed by the slots handed out.
+const uint32_t image_binding = 0;
+const uint32_t buffer_binding = 1;
+
+namespace internal {
+
+// Hands out the lowest never used slot, or a released one.
+struct slot_allocator_type {
+	explicit slot_allocator_type(uint32_t capacity)
+		: capacity(capacity), next(0), live(capacity) {}
+
+	uint32_t capacity, next;
+	std::vector<uint32_t> released;
+	// Whether each slot is handed out, releasing twice would hand it out twice.
+	std::vector<bool> live;
+};
+
+VCC_LIBRARY uint32_t acquire(slot_allocator_type &slots);
+// Throws if slot is not handed out.
+VCC_LIBRARY void release(slot_allocator_type &slots, uint32_t slot);
+
+struct state_type {
+	state_type(uint32_t max_images, uint32_t max_buffers)
+		: images(max_images), buffers(max_buffers) {}
+
+	// Guards the slots and the references of the set.
+	std::mutex mutex;
+	slot_allocator_type images, buffers;
+};
+
+}  // namespace internal
+
+/*
+ * A single descriptor set holding arrays of sampled images and storage
+ * buffers, written as resources are added and bound once per frame.
+ * Shaders index the arrays with slots passed in push constants or buffers
+ * instead of binding a set per material. Slots not written are left
+ * unbound, and adding resources does not disturb command buffers using the
+ * set. The device must enable VK_EXT_descriptor_indexing with the
+ * descriptorBindingPartiallyBound, descriptorBindingUpdateUnusedWhilePending,
+ * descriptorBindingSampledImageUpdateAfterBind and
+ * descriptorBindingStorageBufferUpdateAfterBind features, by passing a
+ * VkPhysicalDeviceDescriptorIndexingFeaturesEXT as next to device::create.
+ */
+struct bindless_type {
+	friend VCC_LIBRARY bindless_type create(
+		const type::supplier<const device::device_type> &device, uint32_t max_images,
+		uint32_t max_buffers, VkShaderStageFlags stages);
+	friend VCC_LIBRARY const type::supplier<const descriptor_set_layout::descriptor_set_layout_type>
+		&get_layout(const bindless_type &bindless);
+	friend VCC_LIBRARY uint32_t add_image(bindless_type &bindless,
+		const type::supplier<const image_view::image_view_type> &image_view,
+		VkImageLayout image_layout);
+	friend VCC_LIBRARY uint32_t add_buffer(bindless_type &bindless,
+		const type::supplier<const buffer::buffer_type> &buffer, VkDeviceSize offset,
+		VkDeviceSize range);
+	friend VCC_LIBRARY void remove_image(bindless_type &bindless, uint32_t slot);
+	friend VCC_LIBRARY void remove_buffer(bindless_type &bindless, uint32_t slot);
+	friend VCC_LIBRARY command::bind_descriptor_sets bind(const bindless_type &bindless,
+		VkPipelineBindPoint pipeline_bind_point,
+		const type::supplier<const pipeline_layout::pipeline_layout_type> &layout,
+		uint32_t set);
+
+	bindless_type() = default;
+	bindless_type(const bindless_type &) = delete;
+	bindless_type(bindless_type &&) = default;
+	bindless_type &operator=(const bindless_type &) = delete;
+	bindless_type &operator=(bindless_type &&) = default;
+
+private:
+	bindless_type(const type::supplier<const device::device_type> &device,
+		const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout,
+		const std::shared_ptr<descriptor_set::descriptor_set_type> &descriptor_set,
+		std::unique_ptr<internal::state_type> &&state)
+		: device(device), layout(layout), descriptor_set(descriptor_set),
+		state(std::move(state)) {}
+
+	type::supplier<const device::device_type> device;
+	type::supplier<const descriptor_set_layout::descriptor_set_layout_type> layout;
+	std::shared_ptr<descriptor_set::descriptor_set_type> descriptor_set;
+	std::unique_ptr<internal::state_type> state;
+};
+
+VCC_LIBRARY bindless_type create(const type::supplier<const device::device_type> &device,
+	uint32_t max_images, uint32_t max_buffers,
+	VkShaderStageFlags stages = VK_SHADER_STAGE_ALL);
+
+// For the pipeline layouts of pipelines indexing the arrays.
+VCC_LIBRARY const type::supplier<const descriptor_set_layout::descriptor_set_layout_type>
+	&get_layout(const bindless_type &bindless);
+
+// Writes image_view to a free slot of image_binding and returns the slot,
+// the set keeps it alive until removed.
+VCC_LIBRARY uint32_t add_image(bindless_type &bindless,
+	const type::supplier<const image_view::image_view_type> &image_view,
+	VkImageLayout image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+// Writes the range of buffer to a free slot of buffer_binding and returns
+// the slot.
+VCC_LIBRARY uint32_t add_buffer(bindless_type &bindless,
+	const type::supplier<const buffer::buffer_type> &buffer, VkDeviceSize offset = 0,
+	VkDeviceSize range = VK_WHOLE_SIZE);
+
+// Frees the slot for another resource. Command buffers indexing it must
+// have completed, like when retiring the resource with deletion_queue::retire.
+// Throws if slot is not in use, like when removed twice.
+VCC_LIBRARY void remove_image(bindless_type &bindless, uint32_t slot);
+VCC_LIBRARY void remove_buffer(bindless_type &bindless, uint32_t slot);
+
+// Binds the set as set of layout, once per frame and pipeline layout.
+VCC_LIBRARY command::bind_descriptor_sets bind(const bindless_type &bindless,
+	VkPipelineBindPoint pipeline_bind_point,
+	const type::supplier<const pipeline_layout::pipeline_layout_type> &layout,
+	uint32_t set);
+
+#endif // VK_EXT_descriptor_indexing
+
+}  // namespace bindless
+}  // namespace vcc
+
+#endif // _VCC_BINDLESS_H_
@@ -16,6 +16,7 @@
 #ifndef BUFFER_H_
 #define BUFFER_H_
 
+#include <algorithm>
 #include <vcc/device.h>
 
 namespace vcc {
@@ -25,24 +26,63 @@ namespace memory {
 
 namespace buffer {
 
+namespace internal {
+
+template<typename T>
+uint64_t get_revision(const T &value) {
+	return value.revision;
+}
+
+}  // namespace internal
+
 struct buffer_type
-	: public internal::movable_destructible_with_parent_and_memory<VkBuffer,
+	: public vcc::internal::movable_destructible_with_parent_and_memory<VkBuffer,
 		const device::device_type, const memory::memory_type, vkDestroyBuffer> {
 	friend VCC_LIBRARY buffer_type create(
 		const type::supplier<const device::device_type> &device,
 		VkBufferCreateFlags flags, VkDeviceSize size,
 		VkBufferUsageFlags usage, VkSharingMode sharingMode,
 		const std::vector<uint32_t> &queueFamilyIndices);
+	friend VkBufferCreateFlags get_flags(const buffer_type &buffer);
+	friend VkDeviceSize get_size(const buffer_type &buffer);
+	friend VkBufferUsageFlags get_usage(const buffer_type &buffer);
+	friend VkSharingMode get_sharing_mode(const buffer_type &buffer);
+	friend const std::vector<uint32_t> &get_queue_family_indices(const buffer_type &buffer);
+	template<typename T>
+	friend uint64_t internal::get_revision(const T &value);
 
 	buffer_type() = default;
 	buffer_type(buffer_type &&) = default;
 	buffer_type(const buffer_type &) = delete;
-	buffer_type &operator=(buffer_type &&) = default;
+	// Moving a buffer into another one replaces its handle, the revision is
+	// bumped so command buffers recorded with the old handle are recorded again.
+	buffer_type &operator=(buffer_type &&buffer) {
+		const uint64_t previous(revision);
+		movable_destructible_with_parent_and_memory::operator=(std::move(buffer));
+		flags = buffer.flags;
+		size = buffer.size;
+		usage = buffer.usage;
+		sharingMode = buffer.sharingMode;
+		queueFamilyIndices = std::move(buffer.queueFamilyIndices);
+		revision = std::max(previous, buffer.revision) + 1;
+		return *this;
+	}
 	buffer_type &operator=(const buffer_type &) = delete;
 
 private:
-	buffer_type(VkBuffer instance, const type::supplier<const device::device_type> &parent)
-		: movable_destructible_with_parent_and_memory(instance, parent) {}
+	buffer_type(VkBuffer instance, const type::supplier<const device::device_type> &parent,
+		VkBufferCreateFlags flags, VkDeviceSize size, VkBufferUsageFlags usage,
+		VkSharingMode sharingMode, const std::vector<uint32_t> &queueFamilyIndices)
+		: movable_destructible_with_parent_and_memory(instance, parent), flags(flags)
+		, size(size), usage(usage), sharingMode(sharingMode)
+		, queueFamilyIndices(queueFamilyIndices) {}
+
+	VkBufferCreateFlags flags;
+	VkDeviceSize size;
+	VkBufferUsageFlags usage;
+	VkSharingMode sharingMode;
+	std::vector<uint32_t> queueFamilyIndices;
+	uint64_t revision = 0;
 };
 
 VCC_LIBRARY buffer_type create(
@@ -51,6 +91,26 @@ VCC_LIBRARY buffer_type create(
 	VkBufferUsageFlags usage, VkSharingMode sharingMode,
 	const std::vector<uint32_t> &queueFamilyIndices);
 
+inline VkBufferCreateFlags get_flags(const buffer_type &buffer) {
+	return buffer.flags;
+}
+
+inline VkDeviceSize get_size(const buffer_type &buffer) {
+	return buffer.size;
+}
+
+inline VkBufferUsageFlags get_usage(const buffer_type &buffer) {
+	return buffer.usage;
+}
+
+inline VkSharingMode get_sharing_mode(const buffer_type &buffer) {
+	return buffer.sharingMode;
+}
+
+inline const std::vector<uint32_t> &get_queue_family_indices(const buffer_type &buffer) {
+	return buffer.queueFamilyIndices;
+}
+
 }  // namespace buffer
 }  // namespace vcc
 
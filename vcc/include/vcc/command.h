@@ -17,12 +17,14 @@
 #define _VCC_COMMAND_H_
 
 #include <array>
+#include <type_traits>
 #include <vcc/command_buffer.h>
 #include <vcc/descriptor_set.h>
 #include <vcc/event.h>
 #include <vcc/input_buffer.h>
 #include <vcc/pipeline.h>
 #include <vcc/query_pool.h>
+#include <vcc/tracking.h>
 
 namespace vcc {
 namespace command {
@@ -45,6 +47,11 @@ auto get_references(BuildT &build)->decltype(build.references)& {
 	return build.references;
 }
 
+template<typename BuildT>
+auto get_tracker(BuildT &build)->decltype(build.tracker)& {
+	return build.tracker;
+}
+
 }  // namespace internal
 
 struct build_type {
@@ -55,6 +62,8 @@ struct build_type {
 		->decltype(build.pre_execute_callbacks)&;
 	template<typename BuildT>
 	friend auto internal::get_references(BuildT &build)->decltype(build.references)&;
+	template<typename BuildT>
+	friend auto internal::get_tracker(BuildT &build)->decltype(build.tracker)&;
 
 	build_type() = default;
 	build_type(const build_type &) = delete;
@@ -70,6 +79,8 @@ private:
 	std::unique_lock<std::mutex> command_buffer_lock;
 	vcc::internal::hook_container_type<const queue::queue_type&> pre_execute_callbacks;
 	vcc::internal::reference_container_type references;
+	// Set by the track command, null when accesses are not tracked.
+	std::unique_ptr<tracking::internal::tracker_type> tracker;
 };
 
 VCC_LIBRARY build_type build(
@@ -253,6 +264,44 @@ inline draw_indexed_indirect_data_type draw_indexed_indirect_data(
 	return { buffer, offset, drawCount, stride };
 }
 
+#if defined(VK_KHR_draw_indirect_count)
+
+// Like draw_indirect, but draws as many commands as the uint32_t at
+// countBufferOffset of countBuffer says, at most maxDrawCount. Lets a
+// culling pass on the device write both the commands and their count. The
+// device must enable VK_KHR_draw_indirect_count or Vulkan 1.2.
+struct draw_indirect_count_type {
+	type::supplier<const buffer::buffer_type> buffer;
+	VkDeviceSize offset;
+	type::supplier<const buffer::buffer_type> countBuffer;
+	VkDeviceSize countBufferOffset;
+	uint32_t maxDrawCount, stride;
+};
+
+inline draw_indirect_count_type draw_indirect_count(
+		const type::supplier<const buffer::buffer_type> &buffer, VkDeviceSize offset,
+		const type::supplier<const buffer::buffer_type> &countBuffer,
+		VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride) {
+	return { buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride };
+}
+
+struct draw_indexed_indirect_count_type {
+	type::supplier<const buffer::buffer_type> buffer;
+	VkDeviceSize offset;
+	type::supplier<const buffer::buffer_type> countBuffer;
+	VkDeviceSize countBufferOffset;
+	uint32_t maxDrawCount, stride;
+};
+
+inline draw_indexed_indirect_count_type draw_indexed_indirect_count(
+		const type::supplier<const buffer::buffer_type> &buffer, VkDeviceSize offset,
+		const type::supplier<const buffer::buffer_type> &countBuffer,
+		VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride) {
+	return { buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride };
+}
+
+#endif // VK_KHR_draw_indirect_count
+
 struct dispatch {
 	uint32_t x, y, z;
 };
@@ -514,6 +563,134 @@ inline push_constants_type push_constants(
 	return { layout, stageFlags, offset, size, pValues };
 }
 
+// Records the typed push constants the layout was created with.
+// bind_descriptor_sets does this implicitly, use this for layouts without descriptor sets.
+struct push_layout_constants_type {
+	type::supplier<const pipeline_layout::pipeline_layout_type> layout;
+};
+
+inline push_layout_constants_type push_constants(
+		const type::supplier<const pipeline_layout::pipeline_layout_type> &layout) {
+	return { layout };
+}
+
+/*
+ * Tracks the accesses of the following commands in the command buffer and
+ * records, or in validate mode reports, the barriers they need. Only
+ * resources named by commands are tracked, resources read or written through
+ * descriptor sets must be declared with buffer_access and image_access.
+ */
+struct track_type {
+	tracking::mode_type mode;
+	tracking::report_callback_type report;
+};
+
+inline track_type track(tracking::mode_type mode,
+		const tracking::report_callback_type &report = tracking::report_callback_type()) {
+	return { mode, report };
+}
+
+// Declares an access to the buffer by the next command, like a shader
+// reading or writing it through a descriptor set. Accesses accumulate until
+// that command, so one barrier covers all of them. Accesses declared inside
+// a render pass get their barrier before the render pass begins.
+struct buffer_access_type {
+	type::supplier<const buffer::buffer_type> buffer;
+	VkPipelineStageFlags stage;
+	VkAccessFlags access;
+	VkDeviceSize offset, size;
+};
+
+inline buffer_access_type buffer_access(
+		const type::supplier<const buffer::buffer_type> &buffer,
+		VkPipelineStageFlags stage, VkAccessFlags access, VkDeviceSize offset = 0,
+		VkDeviceSize size = VK_WHOLE_SIZE) {
+	return { buffer, stage, access, offset, size };
+}
+
+// Declares an access to the image by the next command in layout,
+// transitioning the range to layout if needed. Like buffer_access the
+// barrier is recorded with the command.
+struct image_access_type {
+	type::supplier<const image::image_type> image;
+	VkImageSubresourceRange range;
+	VkPipelineStageFlags stage;
+	VkAccessFlags access;
+	VkImageLayout layout;
+};
+
+inline image_access_type image_access(const type::supplier<const image::image_type> &image,
+		const VkImageSubresourceRange &range, VkPipelineStageFlags stage,
+		VkAccessFlags access, VkImageLayout layout) {
+	return { image, range, stage, access, layout };
+}
+
+// Sets the tracked state of the image without a barrier, for layouts changed
+// by render passes or left by earlier command buffers.
+struct declare_image_type {
+	type::supplier<const image::image_type> image;
+	VkImageSubresourceRange range;
+	VkPipelineStageFlags stage;
+	VkAccessFlags access;
+	VkImageLayout layout;
+};
+
+inline declare_image_type declare_image(const type::supplier<const image::image_type> &image,
+		const VkImageSubresourceRange &range, VkPipelineStageFlags stage,
+		VkAccessFlags access, VkImageLayout layout) {
+	return { image, range, stage, access, layout };
+}
+
+struct owned_buffer_type {
+	type::supplier<const buffer::buffer_type> buffer;
+	VkDeviceSize offset, size;
+};
+
+// The layout transition is made once, by the release and acquire together.
+struct owned_image_type {
+	type::supplier<const image::image_type> image;
+	VkImageSubresourceRange subresourceRange;
+	VkImageLayout oldLayout, newLayout;
+};
+
+/*
+ * Moves resources created with VK_SHARING_MODE_EXCLUSIVE from one queue
+ * family to another, like uploads made on a dedicated transfer queue for the
+ * graphics queue. The release is recorded on the source queue and the
+ * acquire on the destination queue, submitted waiting for a semaphore
+ * signaled by the release, see queue::submit_release. Between queues of the
+ * same family nothing is released and the acquire only transitions layouts.
+ */
+struct ownership_transfer_type {
+	uint32_t srcQueueFamilyIndex, dstQueueFamilyIndex;
+	std::vector<owned_buffer_type> buffers;
+	std::vector<owned_image_type> images;
+};
+
+// srcStageMask and srcAccessMask are the accesses on the source queue.
+struct release_ownership_type {
+	ownership_transfer_type transfer;
+	VkPipelineStageFlags srcStageMask;
+	VkAccessFlags srcAccessMask;
+};
+
+inline release_ownership_type release_ownership(const ownership_transfer_type &transfer,
+		VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask) {
+	return { transfer, srcStageMask, srcAccessMask };
+}
+
+// dstStageMask and dstAccessMask are the accesses on the destination queue.
+struct acquire_ownership_type {
+	ownership_transfer_type transfer;
+	VkPipelineStageFlags dstStageMask;
+	VkAccessFlags dstAccessMask;
+};
+
+inline acquire_ownership_type acquire_ownership(const ownership_transfer_type &transfer,
+		VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask) {
+	return { transfer, dstStageMask, dstAccessMask };
+}
+
 template<typename... CommandsT>
 struct render_pass_type {
 	type::supplier<const vcc::render_pass::render_pass_type> renderPass;
@@ -571,6 +748,10 @@ VCC_LIBRARY void cmd(build_type &, const draw_indirect_type &);
 VCC_LIBRARY void cmd(build_type &, const draw_indexed_indirect_type &);
 VCC_LIBRARY void cmd(build_type &, const dispatch &);
 VCC_LIBRARY void cmd(build_type &, const dispatch_indirect_type &);
+#if defined(VK_KHR_draw_indirect_count)
+VCC_LIBRARY void cmd(build_type &, const draw_indirect_count_type &);
+VCC_LIBRARY void cmd(build_type &, const draw_indexed_indirect_count_type &);
+#endif // VK_KHR_draw_indirect_count
 VCC_LIBRARY void cmd(build_type &, const copy_buffer_type &);
 VCC_LIBRARY void cmd(build_type &, const copy_image &);
 VCC_LIBRARY void cmd(build_type &, const blit_image &);
@@ -592,6 +773,7 @@ VCC_LIBRARY void cmd(build_type &, const reset_query_pool &);
 VCC_LIBRARY void cmd(build_type &, const write_timestamp &);
 VCC_LIBRARY void cmd(build_type &, const copy_query_pool_results &);
 VCC_LIBRARY void cmd(build_type &, const push_constants_type &);
+VCC_LIBRARY void cmd(build_type &, const push_layout_constants_type &);
 VCC_LIBRARY void cmd(build_type &, const next_subpass &);
 VCC_LIBRARY void cmd(build_type &, const execute_commands &);
 VCC_LIBRARY void cmd(build_type &, const bind_index_data_buffer_type&);
@@ -601,6 +783,38 @@ VCC_LIBRARY void cmd(build_type &, const draw_indexed_indirect_data_type&);
 VCC_LIBRARY void cmd(build_type &, const dispatch_indirect_data_type&);
 VCC_LIBRARY void cmd(build_type &, const copy_data_buffer_type&);
 VCC_LIBRARY void cmd(build_type &, const copy_data_buffer_to_image_type&);
+VCC_LIBRARY void cmd(build_type &, const track_type &);
+VCC_LIBRARY void cmd(build_type &, const buffer_access_type &);
+VCC_LIBRARY void cmd(build_type &, const image_access_type &);
+VCC_LIBRARY void cmd(build_type &, const declare_image_type &);
+VCC_LIBRARY void cmd(build_type &, const release_ownership_type &);
+VCC_LIBRARY void cmd(build_type &, const acquire_ownership_type &);
+
+// Records the barrier the tracked accesses before command need.
+VCC_LIBRARY void track_flush(build_type &build, const char *command);
+
+// Barriers can not be recorded inside a render pass, so the vertex, index
+// and indirect buffers and the declared accesses of its commands are
+// tracked before it begins. Other commands access nothing tracked there.
+template<typename T>
+void track_before_render_pass(build_type &, const T &) {}
+VCC_LIBRARY void track_before_render_pass(build_type &, const bind_index_buffer_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &, const bind_vertex_buffers_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &, const draw_indirect_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &, const draw_indexed_indirect_type &);
+#if defined(VK_KHR_draw_indirect_count)
+VCC_LIBRARY void track_before_render_pass(build_type &, const draw_indirect_count_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &,
+	const draw_indexed_indirect_count_type &);
+#endif // VK_KHR_draw_indirect_count
+VCC_LIBRARY void track_before_render_pass(build_type &, const bind_index_data_buffer_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &,
+	const bind_vertex_data_buffers_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &, const draw_indirect_data_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &,
+	const draw_indexed_indirect_data_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &, const buffer_access_type &);
+VCC_LIBRARY void track_before_render_pass(build_type &, const image_access_type &);
 
 // Need C++14 to do auto argument lambdas.
 struct call_cmd_type {
@@ -612,6 +826,15 @@ struct call_cmd_type {
 	};
 };
 
+struct call_track_before_render_pass_type {
+	build_type &build;
+
+	template<typename T>
+	void operator()(T &value) {
+		track_before_render_pass(build, value);
+	};
+};
+
 template<typename... CommandsT>
 void cmd(build_type &build, render_pass_type<CommandsT...> &&render_pass) {
 	VkRenderPassBeginInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO, NULL };
@@ -620,13 +843,155 @@ void cmd(build_type &build, render_pass_type<CommandsT...> &&render_pass) {
 	info.renderArea = render_pass.renderArea;
 	info.clearValueCount = (uint32_t)render_pass.clearValues.size();
 	info.pClearValues = render_pass.clearValues.data();
+	if (get_tracker(build)) {
+		util::tuple_foreach(call_track_before_render_pass_type{ build },
+			render_pass.commands);
+		track_flush(build, "vkCmdBeginRenderPass");
+	}
 	VKTRACE(vkCmdBeginRenderPass(vcc::internal::get_instance(get_command_buffer(build)), &info,
 		render_pass.contents));
+	if (get_tracker(build)) {
+		get_tracker(build)->render_pass = true;
+	}
 	util::tuple_foreach(call_cmd_type{ build }, render_pass.commands);
 	VKTRACE(vkCmdEndRenderPass(vcc::internal::get_instance(get_command_buffer(build))));
+	if (get_tracker(build)) {
+		get_tracker(build)->render_pass = false;
+	}
 	get_references(build).add(render_pass.renderPass, render_pass.framebuffer);
 }
 
+// 64-bit FNV-1a over the content of commands, see compile_cached.
+struct hash_type {
+	hash_type() : value(14695981039346656037ull) {}
+
+	void add(const void *data, std::size_t size) {
+		const unsigned char *const bytes(static_cast<const unsigned char *>(data));
+		for (std::size_t i = 0; i < size; ++i) {
+			value = (value ^ bytes[i]) * 1099511628211ull;
+		}
+	}
+
+	uint64_t value;
+};
+
+// Parameters, Vulkan structs and the commands made of nothing else.
+template<typename T>
+typename std::enable_if<std::is_pod<T>::value>::type hash(hash_type &content,
+		const T &value) {
+	content.add(&value, sizeof(value));
+}
+
+// Objects that can change in place have a revision hashed next to their
+// identity, buffers get a new handle when moved into by defragment and
+// descriptor sets get new descriptors when updated.
+template<typename T>
+void hash_revision(hash_type &content, const T &value) {}
+
+inline void hash_revision(hash_type &content, const buffer::buffer_type &buffer) {
+	hash(content, buffer::internal::get_revision(buffer));
+}
+
+inline void hash_revision(hash_type &content,
+		const descriptor_set::descriptor_set_type &descriptor_set) {
+	hash(content, descriptor_set.revision);
+}
+
+// Objects are hashed by identity, they are kept alive by the command buffer
+// so no other object can take their address while it is cached.
+template<typename T>
+void hash(hash_type &content, const type::supplier<T> &value) {
+	const void *const object(value ? &*value : nullptr);
+	content.add(&object, sizeof(object));
+	if (value) {
+		hash_revision(content, *value);
+	}
+}
+
+template<typename T>
+void hash(hash_type &content, const std::vector<T> &values) {
+	hash(content, values.size());
+	for (const T &value : values) {
+		hash(content, value);
+	}
+}
+
+inline void hash_all(hash_type &content) {}
+
+template<typename T, typename... ArgsT>
+void hash_all(hash_type &content, const T &value, const ArgsT&... args) {
+	hash(content, value);
+	hash_all(content, args...);
+}
+
+VCC_LIBRARY void hash(hash_type &, const bind_pipeline &);
+VCC_LIBRARY void hash(hash_type &, const set_viewport &);
+VCC_LIBRARY void hash(hash_type &, const set_scissor &);
+VCC_LIBRARY void hash(hash_type &, const bind_descriptor_sets &);
+VCC_LIBRARY void hash(hash_type &, const bind_index_buffer_type &);
+VCC_LIBRARY void hash(hash_type &, const bind_vertex_buffers_type &);
+VCC_LIBRARY void hash(hash_type &, const draw_indirect_type &);
+VCC_LIBRARY void hash(hash_type &, const draw_indexed_indirect_type &);
+VCC_LIBRARY void hash(hash_type &, const dispatch_indirect_type &);
+#if defined(VK_KHR_draw_indirect_count)
+VCC_LIBRARY void hash(hash_type &, const draw_indirect_count_type &);
+VCC_LIBRARY void hash(hash_type &, const draw_indexed_indirect_count_type &);
+#endif // VK_KHR_draw_indirect_count
+VCC_LIBRARY void hash(hash_type &, const copy_buffer_type &);
+VCC_LIBRARY void hash(hash_type &, const copy_image &);
+VCC_LIBRARY void hash(hash_type &, const blit_image &);
+VCC_LIBRARY void hash(hash_type &, const copy_buffer_to_image_type &);
+VCC_LIBRARY void hash(hash_type &, const copy_image_to_buffer &);
+VCC_LIBRARY void hash(hash_type &, const update_buffer &);
+VCC_LIBRARY void hash(hash_type &, const fill_buffer &);
+VCC_LIBRARY void hash(hash_type &, const clear_color_image &);
+VCC_LIBRARY void hash(hash_type &, const clear_depth_stencil_image &);
+VCC_LIBRARY void hash(hash_type &, const clear_attachments &);
+VCC_LIBRARY void hash(hash_type &, const resolve_image &);
+VCC_LIBRARY void hash(hash_type &, const set_event &);
+VCC_LIBRARY void hash(hash_type &, const reset_event &);
+VCC_LIBRARY void hash(hash_type &, const wait_events &);
+VCC_LIBRARY void hash(hash_type &, const buffer_memory_barrier_type &);
+VCC_LIBRARY void hash(hash_type &, const image_memory_barrier &);
+VCC_LIBRARY void hash(hash_type &, const pipeline_barrier &);
+VCC_LIBRARY void hash(hash_type &, const begin_query &);
+VCC_LIBRARY void hash(hash_type &, const end_query &);
+VCC_LIBRARY void hash(hash_type &, const reset_query_pool &);
+VCC_LIBRARY void hash(hash_type &, const write_timestamp &);
+VCC_LIBRARY void hash(hash_type &, const copy_query_pool_results &);
+VCC_LIBRARY void hash(hash_type &, const push_constants_type &);
+VCC_LIBRARY void hash(hash_type &, const push_layout_constants_type &);
+VCC_LIBRARY void hash(hash_type &, const execute_commands &);
+VCC_LIBRARY void hash(hash_type &, const bind_index_data_buffer_type &);
+VCC_LIBRARY void hash(hash_type &, const bind_vertex_data_buffers_type &);
+VCC_LIBRARY void hash(hash_type &, const draw_indirect_data_type &);
+VCC_LIBRARY void hash(hash_type &, const draw_indexed_indirect_data_type &);
+VCC_LIBRARY void hash(hash_type &, const dispatch_indirect_data_type &);
+VCC_LIBRARY void hash(hash_type &, const copy_data_buffer_type &);
+VCC_LIBRARY void hash(hash_type &, const copy_data_buffer_to_image_type &);
+VCC_LIBRARY void hash(hash_type &, const track_type &);
+VCC_LIBRARY void hash(hash_type &, const buffer_access_type &);
+VCC_LIBRARY void hash(hash_type &, const image_access_type &);
+VCC_LIBRARY void hash(hash_type &, const declare_image_type &);
+VCC_LIBRARY void hash(hash_type &, const release_ownership_type &);
+VCC_LIBRARY void hash(hash_type &, const acquire_ownership_type &);
+
+struct hash_command_type {
+	hash_type &content;
+
+	template<typename T>
+	void operator()(const T &value) {
+		hash(content, value);
+	};
+};
+
+template<typename... CommandsT>
+void hash(hash_type &content, const render_pass_type<CommandsT...> &render_pass) {
+	hash_all(content, render_pass.renderPass, render_pass.framebuffer, render_pass.renderArea,
+		render_pass.clearValues, render_pass.contents);
+	util::tuple_foreach(hash_command_type{ content }, render_pass.commands);
+}
+
 }  // namespace internal
 
 template<typename... CommandsT>
@@ -641,6 +1006,34 @@ void compile(build_type &&begin, CommandsT&&... commands) {
 	const int dummy[] = { (internal::cmd(begin, std::forward<CommandsT>(commands)), 0)... };
 }
 
+/*
+ * Records the commands into the primary command buffer like compile, unless
+ * it was last recorded by compile_cached with the same flags and commands,
+ * which leaves it as is to be submitted again. Returns whether it recorded.
+ * Commands are compared by their parameters, the objects they name and the
+ * revision of typed push constants, executed secondary command buffers,
+ * buffers and descriptor sets. Moving a buffer into a named one, as
+ * defragment does, or updating a named descriptor set records it again.
+ * The content of buffers and images is not compared.
+ * Command buffers reset other than by recording them must not be cached.
+ */
+template<typename... CommandsT>
+bool compile_cached(const type::supplier<command_buffer::command_buffer_type> &command_buffer,
+		VkCommandBufferUsageFlags flags, CommandsT&&... commands) {
+	internal::hash_type content;
+	internal::hash_all(content, flags, commands...);
+	uint64_t &recorded(command_buffer::internal::get_content_hash(*command_buffer));
+	if (recorded && recorded == content.value) {
+		return false;
+	}
+	compile(build(command_buffer, flags, VK_FALSE, 0, 0), std::forward<CommandsT>(commands)...);
+	// One time submit command buffers can not be submitted again.
+	if (!(flags & VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)) {
+		recorded = content.value;
+	}
+	return true;
+}
+
 }  // namespace command
 }  // namespace vcc
 
@@ -55,6 +55,21 @@ const vcc::internal::hook_container_type<const queue::queue_type &> &get_pre_exe
 	return value.pre_execute_hook;
 }
 
+template<typename T>
+vcc::internal::reference_container_type &get_references(T &value) {
+	return value.references;
+}
+
+template<typename T>
+uint64_t &get_content_hash(T &value) {
+	return value.content_hash;
+}
+
+template<typename T>
+uint64_t get_revision(const T &value) {
+	return value.revision;
+}
+
 }  // namespace internal
 
 struct command_buffer_type
@@ -86,9 +101,15 @@ struct command_buffer_type
 	template<typename T>
 	friend const vcc::internal::hook_container_type<const queue::queue_type &>
 		&internal::get_pre_execute_hook(const T &value);
+	template<typename T>
+	friend vcc::internal::reference_container_type &internal::get_references(T &value);
+	template<typename T>
+	friend uint64_t &internal::get_content_hash(T &value);
+	template<typename T>
+	friend uint64_t internal::get_revision(const T &value);
 	friend struct command::build_type;
 
-	command_buffer_type() = default;
+	command_buffer_type() : content_hash(0), revision(0) {}
 	command_buffer_type(command_buffer_type &&) = default;
 	command_buffer_type &operator=(command_buffer_type &&) = default;
 	command_buffer_type &operator=(const command_buffer_type &) = default;
@@ -97,10 +118,16 @@ private:
 	command_buffer_type(VkCommandBuffer instance,
 		const type::supplier<const command_pool::command_pool_type> &pool,
 		const type::supplier<const device::device_type> &parent)
-		: movable_allocated_with_pool_parent1(instance, pool, parent) {}
+		: movable_allocated_with_pool_parent1(instance, pool, parent), content_hash(0),
+		revision(0) {}
 
 	vcc::internal::hook_container_type<const queue::queue_type&> pre_execute_hook;
 	vcc::internal::reference_container_type references;
+	// Set by command::compile_cached, zero if recorded otherwise.
+	uint64_t content_hash;
+	// Bumped by every recording, primary command buffers executing this one
+	// must be recorded again when it changes.
+	uint64_t revision;
 };
 
 VCC_LIBRARY std::vector<command_buffer_type> allocate(
@@ -58,7 +58,7 @@ struct debug_type {
 	~debug_type() {
 		if (msg_callback && dbgDestroyMsgCallback) {
 			dbgDestroyMsgCallback(internal::get_instance(*instance),
-				msg_callback, NULL);
+				msg_callback, internal::get_allocator(*instance));
 		}
 	}
 
@@ -0,0 +1,136 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_DEFRAGMENT_H_
+#define _VCC_DEFRAGMENT_H_
+
+#include <chrono>
+#include <vcc/buffer.h>
+#include <vcc/descriptor_set.h>
+#include <vcc/memory.h>
+#include <vcc/queue.h>
+
+namespace vcc {
+namespace defragment {
+
+namespace internal {
+
+// A descriptor written with the buffer, rewritten when the buffer moves.
+struct descriptor_type {
+	type::supplier<descriptor_set::descriptor_set_type> set;
+	uint32_t binding, array_element;
+	VkDescriptorType descriptor_type;
+	VkDeviceSize offset, range;
+};
+
+struct buffer_entry_type {
+	type::supplier<buffer::buffer_type> buffer;
+	std::vector<descriptor_type> descriptors;
+};
+
+// An allocation the registered buffers are bound to.
+struct candidate_type {
+	const memory::memory_type *memory;
+	VkMemoryPropertyFlags propertyFlags;
+	// used is what the registered buffers take, bound what every resource
+	// bound to the allocation takes right now.
+	VkDeviceSize size, used, bound;
+	std::vector<buffer_entry_type *> entries;
+};
+
+// Keeps the candidates that only have registered buffers bound and use less
+// than max_utilization of their size, emptiest first.
+VCC_LIBRARY void select(std::vector<candidate_type> &candidates, float max_utilization);
+
+// Removes the first candidate and those with the same property flags that
+// fit block_size bytes along with it, and returns them.
+VCC_LIBRARY std::vector<candidate_type> next_batch(std::vector<candidate_type> &candidates,
+	VkDeviceSize block_size);
+
+}  // namespace internal
+
+struct result_type {
+	// bytes_freed assumes the memory suppliers returned by memory::bind were
+	// not kept, they would hold on to the allocations.
+	VkDeviceSize bytes_moved, bytes_freed;
+	// Command buffers recorded with these buffers must be recorded again.
+	std::vector<type::supplier<buffer::buffer_type>> moved;
+};
+
+/*
+ * Moves buffers out of allocations that are mostly unused into compacted
+ * allocations, freeing the sparse allocations. Only allocations whose
+ * bound resources are all registered are compacted, as anything else
+ * bound to them would keep them alive. A buffer is moved by creating a new VkBuffer with the same
+ * parameters, copying the contents on the given queue and moving the new
+ * buffer into the registered buffer_type, so every holder of the supplier
+ * sees the new handle.
+ *
+ * Images are not handled, image views and framebuffers keep the VkImage.
+ */
+struct defragmenter_type {
+	friend VCC_LIBRARY void add(defragmenter_type &defragmenter,
+		const type::supplier<buffer::buffer_type> &buffer);
+	friend VCC_LIBRARY void add(defragmenter_type &defragmenter,
+		const type::supplier<buffer::buffer_type> &buffer,
+		const type::supplier<descriptor_set::descriptor_set_type> &set, uint32_t binding,
+		uint32_t array_element, VkDescriptorType descriptor_type, VkDeviceSize offset,
+		VkDeviceSize range);
+	friend VCC_LIBRARY void remove(defragmenter_type &defragmenter,
+		const buffer::buffer_type &buffer);
+	friend VCC_LIBRARY result_type step(defragmenter_type &defragmenter,
+		const queue::queue_type &queue, std::chrono::microseconds budget);
+
+	// Allocations using less than max_utilization of their size are compacted
+	// into new allocations of at most block_size bytes each.
+	explicit defragmenter_type(float max_utilization = .5f,
+			VkDeviceSize block_size = 64 * 1024 * 1024)
+		: max_utilization(max_utilization), block_size(block_size) {}
+	defragmenter_type(const defragmenter_type &) = delete;
+	defragmenter_type &operator=(const defragmenter_type &) = delete;
+
+private:
+	std::mutex mutex;
+	std::vector<internal::buffer_entry_type> buffers;
+	float max_utilization;
+	VkDeviceSize block_size;
+};
+
+// The buffer must have been created with VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+// and VK_BUFFER_USAGE_TRANSFER_DST_BIT.
+VCC_LIBRARY void add(defragmenter_type &defragmenter,
+	const type::supplier<buffer::buffer_type> &buffer);
+
+// Registers a descriptor referencing the buffer, also registers the buffer.
+VCC_LIBRARY void add(defragmenter_type &defragmenter,
+	const type::supplier<buffer::buffer_type> &buffer,
+	const type::supplier<descriptor_set::descriptor_set_type> &set, uint32_t binding,
+	uint32_t array_element, VkDescriptorType descriptor_type, VkDeviceSize offset,
+	VkDeviceSize range);
+
+VCC_LIBRARY void remove(defragmenter_type &defragmenter, const buffer::buffer_type &buffer);
+
+/*
+ * Compacts allocations, one block at a time, until budget is exceeded.
+ * Blocks until the copies have executed. None of the registered buffers or
+ * descriptor sets may be in use by the device while this runs.
+ */
+VCC_LIBRARY result_type step(defragmenter_type &defragmenter, const queue::queue_type &queue,
+	std::chrono::microseconds budget);
+
+}  // namespace defragment
+}  // namespace vcc
+
+#endif // _VCC_DEFRAGMENT_H_
@@ -0,0 +1,102 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_DELETION_QUEUE_H_
+#define _VCC_DELETION_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <type_traits>
+#include <vcc/progress.h>
+
+#if defined(VK_KHR_timeline_semaphore)
+
+namespace vcc {
+namespace deletion_queue {
+
+namespace internal {
+
+// Holds the last reference to object until progress reaches value.
+struct entry_type {
+	std::shared_ptr<void> object;
+	type::supplier<const progress::progress_type> progress;
+	uint64_t value;
+};
+
+struct state_type {
+	state_type() : stop(false) {}
+
+	std::mutex mutex;
+	std::condition_variable retired;
+	std::deque<entry_type> entries;
+	bool stop;
+};
+
+/*
+ * Owned by the device, see device::internal::get_deletion_queue. The thread
+ * is started by the first retire and shares the state, so it may drop the
+ * last reference to the device itself.
+ */
+struct queue_type {
+	queue_type() : state(std::make_shared<state_type>()) {}
+	queue_type(const queue_type &) = delete;
+	queue_type &operator=(const queue_type &) = delete;
+
+	// Waits for the device to be done with every retired object.
+	VCC_LIBRARY ~queue_type();
+
+	std::shared_ptr<state_type> state;
+	std::thread thread;
+};
+
+VCC_LIBRARY void retire(const device::device_type &device, entry_type &&entry);
+
+}  // namespace internal
+
+/*
+ * Destroys objects the device may still be using once it is done with them,
+ * on a thread of the device. Objects are retired with the progress value
+ * signaled by the last submit using them, instead of waiting for the device
+ * to idle before replacing them. object is anything owning a Vulkan object,
+ * like a supplier or a moved image_type, other references to it must be
+ * dropped by the caller. Only progress values are waited for, a fence may be
+ * reset and reused by its owner at any time. If waiting fails, as when the
+ * device is lost, the object is destroyed right away.
+ */
+template<typename T>
+void retire(const device::device_type &device, T &&object,
+		const type::supplier<const progress::progress_type> &progress, uint64_t value) {
+	internal::entry_type entry;
+	entry.object = std::make_shared<typename std::decay<T>::type>(std::forward<T>(object));
+	entry.progress = progress;
+	entry.value = value;
+	internal::retire(device, std::move(entry));
+}
+
+// Keeps object alive until the last value reserved from progress is reached,
+// the one signaled by the submit just made.
+template<typename T>
+void retire(const device::device_type &device, T &&object,
+		const type::supplier<const progress::progress_type> &progress) {
+	retire(device, std::forward<T>(object), progress, progress::get_issued(*progress));
+}
+
+}  // namespace deletion_queue
+}  // namespace vcc
+
+#endif // VK_KHR_timeline_semaphore
+
+#endif // _VCC_DELETION_QUEUE_H_
@@ -0,0 +1,127 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_DESCRIPTOR_ALLOCATOR_H_
+#define _VCC_DESCRIPTOR_ALLOCATOR_H_
+
+#include <map>
+#include <unordered_map>
+#include <vcc/descriptor_set.h>
+#include <vcc/progress.h>
+
+namespace vcc {
+namespace descriptor_allocator {
+
+namespace internal {
+
+// The descriptor types and counts of a layout, layouts with the same
+// signature share pools.
+typedef std::vector<uint64_t> signature_type;
+
+struct pool_list_type {
+	pool_list_type() : current(0), sets_per_pool(0) {}
+
+	std::vector<type::supplier<const descriptor_pool::descriptor_pool_type>> pools;
+	// Pools before current are full.
+	std::size_t current;
+	// Of the next pool created, doubled every time.
+	uint32_t sets_per_pool;
+};
+
+struct free_list_type {
+	// Kept alive so the handle the list is found by is not reused.
+	type::supplier<const descriptor_set_layout::descriptor_set_layout_type> layout;
+	std::vector<descriptor_set::descriptor_set_type> sets;
+};
+
+struct state_type {
+	state_type(const type::supplier<const device::device_type> &device,
+		uint32_t initial_sets_per_pool)
+		: device(device), initial_sets_per_pool(initial_sets_per_pool) {}
+
+	type::supplier<const device::device_type> device;
+	uint32_t initial_sets_per_pool;
+	std::mutex mutex;
+	std::map<signature_type, pool_list_type> pools, transient_pools;
+	std::unordered_map<VkDescriptorSetLayout, free_list_type> free_sets;
+};
+
+}  // namespace internal
+
+/*
+ * Allocates descriptor sets from pools it creates as they run out, one list
+ * of pools per layout signature. Sets are either recycled, returned to the
+ * allocator when no longer referenced and handed out again for the same
+ * layout, or transient, valid until the next reset.
+ */
+struct descriptor_allocator_type {
+	friend VCC_LIBRARY descriptor_allocator_type create(
+		const type::supplier<const device::device_type> &device,
+		uint32_t initial_sets_per_pool);
+	friend VCC_LIBRARY std::shared_ptr<descriptor_set::descriptor_set_type> allocate(
+		descriptor_allocator_type &allocator,
+		const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout);
+	friend VCC_LIBRARY descriptor_set::descriptor_set_type allocate_transient(
+		descriptor_allocator_type &allocator,
+		const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout);
+	friend VCC_LIBRARY void reset(descriptor_allocator_type &allocator);
+
+	descriptor_allocator_type() = default;
+	descriptor_allocator_type(const descriptor_allocator_type &) = delete;
+	descriptor_allocator_type(descriptor_allocator_type &&) = default;
+	descriptor_allocator_type &operator=(const descriptor_allocator_type &) = delete;
+	descriptor_allocator_type &operator=(descriptor_allocator_type &&) = default;
+
+private:
+	explicit descriptor_allocator_type(const std::shared_ptr<internal::state_type> &state)
+		: state(state) {}
+
+	// Shared with the recycled sets, which return to it when released.
+	std::shared_ptr<internal::state_type> state;
+};
+
+VCC_LIBRARY descriptor_allocator_type create(
+	const type::supplier<const device::device_type> &device,
+	uint32_t initial_sets_per_pool = 16);
+
+// A set returned to the allocator instead of freed once the last reference,
+// including those of command buffers, is dropped. Its writes are forgotten
+// when it is handed out again, it must be written before use.
+VCC_LIBRARY std::shared_ptr<descriptor_set::descriptor_set_type> allocate(
+	descriptor_allocator_type &allocator,
+	const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout);
+
+// A set for a single frame, like per-draw material sets. Valid until reset.
+VCC_LIBRARY descriptor_set::descriptor_set_type allocate_transient(
+	descriptor_allocator_type &allocator,
+	const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout);
+
+// Frees every transient set with vkResetDescriptorPool, keeping the pools.
+// The device must be done with them, use one allocator per frame in flight.
+VCC_LIBRARY void reset(descriptor_allocator_type &allocator);
+
+#if defined(VK_KHR_timeline_semaphore)
+
+// Like reset, once progress reached value, the value signaled by the last
+// submit using the transient sets. Blocks until then.
+VCC_LIBRARY void reset(descriptor_allocator_type &allocator,
+	const progress::progress_type &progress, uint64_t value);
+
+#endif // VK_KHR_timeline_semaphore
+
+}  // namespace descriptor_allocator
+}  // namespace vcc
+
+#endif // _VCC_DESCRIPTOR_ALLOCATOR_H_
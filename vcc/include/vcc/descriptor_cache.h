@@ -0,0 +1,155 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_DESCRIPTOR_CACHE_H_
+#define _VCC_DESCRIPTOR_CACHE_H_
+
+#include <unordered_map>
+#include <vcc/descriptor_allocator.h>
+
+namespace vcc {
+namespace descriptor_cache {
+
+/*
+ * What a binding of a cached set is written with, like the descriptor_set
+ * write_* types without a destination set. Only one of the lists is set.
+ */
+struct binding_type {
+	uint32_t binding, array_element;
+	VkDescriptorType descriptor_type;
+	std::vector<descriptor_set::image_info> images;
+	std::vector<descriptor_set::buffer_info_type> buffers;
+	std::vector<descriptor_set::buffer_info_data_type> data_buffers;
+	std::vector<type::supplier<const buffer_view::buffer_view_type>> buffer_views;
+};
+
+inline binding_type bind_images(uint32_t binding, uint32_t array_element,
+		VkDescriptorType descriptor_type,
+		const std::vector<descriptor_set::image_info> &images) {
+	return binding_type{ binding, array_element, descriptor_type, images, {}, {}, {} };
+}
+
+inline binding_type bind_buffers(uint32_t binding, uint32_t array_element,
+		VkDescriptorType descriptor_type,
+		const std::vector<descriptor_set::buffer_info_type> &buffers) {
+	return binding_type{ binding, array_element, descriptor_type, {}, buffers, {}, {} };
+}
+
+inline binding_type bind_data_buffers(uint32_t binding, uint32_t array_element,
+		VkDescriptorType descriptor_type,
+		const std::vector<descriptor_set::buffer_info_data_type> &buffers) {
+	return binding_type{ binding, array_element, descriptor_type, {}, {}, buffers, {} };
+}
+
+inline binding_type bind_buffer_views(uint32_t binding, uint32_t array_element,
+		VkDescriptorType descriptor_type,
+		const std::vector<type::supplier<const buffer_view::buffer_view_type>> &buffer_views) {
+	return binding_type{ binding, array_element, descriptor_type, {}, {}, {}, buffer_views };
+}
+
+namespace internal {
+
+// The layout and what every binding is written with, resources by address.
+// A cached set keeps its resources alive, so their addresses are not reused.
+typedef std::vector<uint64_t> key_type;
+
+struct key_hash_type {
+
+	std::size_t operator()(const key_type &key) const {
+		std::size_t value(0);
+		for (uint64_t word : key) {
+			value = value * 31 + hash(word);
+		}
+		return value;
+	}
+
+	std::hash<uint64_t> hash;
+};
+
+struct entry_type {
+	// Kept alive so the address in the key is not reused.
+	type::supplier<const descriptor_set_layout::descriptor_set_layout_type> layout;
+	std::shared_ptr<const descriptor_set::descriptor_set_type> descriptor_set;
+	// The frame the set was last returned in.
+	uint64_t last_used;
+};
+
+struct state_type {
+	state_type() : frame(0) {}
+
+	std::mutex mutex;
+	std::unordered_map<key_type, entry_type, key_hash_type> entries;
+	uint64_t frame;
+};
+
+}  // namespace internal
+
+/*
+ * Returns an already written set when a layout is requested with the same
+ * bindings again, instead of writing a new one every frame. Sets are
+ * allocated from an allocator of the cache and recycled once evicted and
+ * no longer used by command buffers.
+ */
+struct descriptor_cache_type {
+	friend VCC_LIBRARY descriptor_cache_type create(
+		const type::supplier<const device::device_type> &device,
+		uint32_t initial_sets_per_pool);
+	friend VCC_LIBRARY std::shared_ptr<const descriptor_set::descriptor_set_type> get(
+		descriptor_cache_type &cache,
+		const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout,
+		const std::vector<binding_type> &bindings);
+	friend VCC_LIBRARY void end_frame(descriptor_cache_type &cache,
+		uint32_t max_unused_frames);
+	friend VCC_LIBRARY void clear(descriptor_cache_type &cache);
+
+	descriptor_cache_type() = default;
+	descriptor_cache_type(const descriptor_cache_type &) = delete;
+	descriptor_cache_type(descriptor_cache_type &&) = default;
+	descriptor_cache_type &operator=(const descriptor_cache_type &) = delete;
+	descriptor_cache_type &operator=(descriptor_cache_type &&) = default;
+
+private:
+	descriptor_cache_type(const type::supplier<const device::device_type> &device,
+		descriptor_allocator::descriptor_allocator_type &&allocator,
+		std::unique_ptr<internal::state_type> &&state)
+		: device(device), allocator(std::move(allocator)), state(std::move(state)) {}
+
+	type::supplier<const device::device_type> device;
+	descriptor_allocator::descriptor_allocator_type allocator;
+	std::unique_ptr<internal::state_type> state;
+};
+
+VCC_LIBRARY descriptor_cache_type create(
+	const type::supplier<const device::device_type> &device,
+	uint32_t initial_sets_per_pool = 16);
+
+// A set of layout written with bindings, the cached one if the same layout
+// was requested with the same bindings, in the same order, before. The
+// resources of the bindings are kept alive until the set is evicted.
+VCC_LIBRARY std::shared_ptr<const descriptor_set::descriptor_set_type> get(
+	descriptor_cache_type &cache,
+	const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout,
+	const std::vector<binding_type> &bindings);
+
+// Evicts the sets not returned by get in the last max_unused_frames frames.
+VCC_LIBRARY void end_frame(descriptor_cache_type &cache, uint32_t max_unused_frames = 8);
+
+// Evicts every set, like when resources they use are replaced.
+VCC_LIBRARY void clear(descriptor_cache_type &cache);
+
+}  // namespace descriptor_cache
+}  // namespace vcc
+
+#endif // _VCC_DESCRIPTOR_CACHE_H_
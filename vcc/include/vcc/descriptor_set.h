@@ -53,6 +53,9 @@ struct descriptor_set_type : public internal::movable_allocated_with_pool_parent
 		util::hash_pair<uint32_t, uint32_t>, const queue::queue_type &> pre_execute_callbacks;
 	internal::reference_map_type<std::pair<uint32_t, uint32_t>,
 		util::hash_pair<uint32_t, uint32_t>> references;
+	// Bumped by every update, command buffers binding the set are recorded
+	// again by command::compile_cached when it changes.
+	uint64_t revision = 0;
 };
 
 VCC_LIBRARY std::vector<descriptor_set_type> create(
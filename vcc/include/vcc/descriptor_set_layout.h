@@ -22,6 +22,15 @@
 namespace vcc {
 namespace descriptor_set_layout {
 
+namespace internal {
+
+template<typename T>
+auto get_pool_sizes(const T &layout)->const decltype(layout.pool_sizes)& {
+	return layout.pool_sizes;
+}
+
+}  // namespace internal
+
 struct descriptor_set_layout_binding {
 	uint32_t binding;
 	VkDescriptorType descriptorType;
@@ -30,11 +39,20 @@ struct descriptor_set_layout_binding {
 	std::vector<type::supplier<const sampler::sampler_type>> immutableSamplers;
 };
 
-struct descriptor_set_layout_type : internal::movable_destructible_with_parent<
+struct descriptor_set_layout_type : vcc::internal::movable_destructible_with_parent<
 		VkDescriptorSetLayout, const device::device_type, vkDestroyDescriptorSetLayout> {
 	friend VCC_LIBRARY descriptor_set_layout_type create(
 		const type::supplier<const device::device_type> &device,
 		const std::vector<descriptor_set_layout_binding> &bindings);
+#if defined(VK_EXT_descriptor_indexing)
+	friend VCC_LIBRARY descriptor_set_layout_type create(
+		const type::supplier<const device::device_type> &device,
+		const std::vector<descriptor_set_layout_binding> &bindings,
+		VkDescriptorSetLayoutCreateFlags flags,
+		const std::vector<VkDescriptorBindingFlagsEXT> &binding_flags);
+#endif // VK_EXT_descriptor_indexing
+	template<typename T>
+	friend auto internal::get_pool_sizes(const T &layout)->const decltype(layout.pool_sizes)&;
 
 	descriptor_set_layout_type() = default;
 	descriptor_set_layout_type(descriptor_set_layout_type &&) = default;
@@ -44,14 +62,33 @@ struct descriptor_set_layout_type : internal::movable_destructible_with_parent<
 
 private:
 	descriptor_set_layout_type(VkDescriptorSetLayout instance,
-		const type::supplier<const device::device_type> &parent)
-		: movable_destructible_with_parent(instance, parent) {}
+		const type::supplier<const device::device_type> &parent,
+		std::vector<VkDescriptorPoolSize> &&pool_sizes)
+		: movable_destructible_with_parent(instance, parent),
+		pool_sizes(std::move(pool_sizes)) {}
+
+	// The descriptors of one set, sorted by type.
+	std::vector<VkDescriptorPoolSize> pool_sizes;
 };
 
 VCC_LIBRARY descriptor_set_layout_type create(
 		const type::supplier<const device::device_type> &device,
 		const std::vector<descriptor_set_layout_binding> &bindings);
 
+#if defined(VK_EXT_descriptor_indexing)
+
+// Like create, flags like VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT
+// and one VkDescriptorBindingFlagsEXT per binding, like
+// VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT. The device must enable
+// VK_EXT_descriptor_indexing and the features the flags need.
+VCC_LIBRARY descriptor_set_layout_type create(
+		const type::supplier<const device::device_type> &device,
+		const std::vector<descriptor_set_layout_binding> &bindings,
+		VkDescriptorSetLayoutCreateFlags flags,
+		const std::vector<VkDescriptorBindingFlagsEXT> &binding_flags);
+
+#endif // VK_EXT_descriptor_indexing
+
 }  // namespace descriptor_set_layout
 }  // namespace vcc
 
@@ -0,0 +1,103 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_DESCRIPTOR_UPDATE_TEMPLATE_H_
+#define _VCC_DESCRIPTOR_UPDATE_TEMPLATE_H_
+
+#include <vcc/descriptor_set.h>
+
+namespace vcc {
+namespace descriptor_update_template {
+
+#if defined(VK_KHR_descriptor_update_template)
+
+namespace internal {
+
+// Where update keeps the resources of the last template update alive.
+const std::pair<uint32_t, uint32_t> references_key(UINT32_MAX, UINT32_MAX);
+
+}  // namespace internal
+
+/*
+ * Writes a set of a layout from a packed struct in a single call, each entry
+ * reads descriptorCount VkDescriptorImageInfo, VkDescriptorBufferInfo or
+ * VkBufferView from offset in steps of stride. Unlike descriptor_set::update
+ * it builds nothing on the heap. The device must enable
+ * VK_KHR_descriptor_update_template or Vulkan 1.1.
+ */
+struct descriptor_update_template_type : vcc::internal::movable_with_parent<
+		VkDescriptorUpdateTemplateKHR, const device::device_type> {
+	friend VCC_LIBRARY descriptor_update_template_type create(
+		const type::supplier<const device::device_type> &device,
+		const descriptor_set_layout::descriptor_set_layout_type &layout,
+		const std::vector<VkDescriptorUpdateTemplateEntryKHR> &entries);
+	friend VCC_LIBRARY void update(const descriptor_update_template_type &update_template,
+		descriptor_set::descriptor_set_type &descriptor_set, const void *data);
+
+	descriptor_update_template_type() = default;
+	descriptor_update_template_type(descriptor_update_template_type &&) = default;
+	descriptor_update_template_type(const descriptor_update_template_type &) = delete;
+	VCC_LIBRARY descriptor_update_template_type &operator=(
+		descriptor_update_template_type &&copy);
+	descriptor_update_template_type &operator=(
+		const descriptor_update_template_type &) = delete;
+	VCC_LIBRARY ~descriptor_update_template_type();
+
+private:
+	descriptor_update_template_type(VkDescriptorUpdateTemplateKHR instance,
+		const type::supplier<const device::device_type> &parent,
+		PFN_vkDestroyDescriptorUpdateTemplateKHR destroy_template,
+		PFN_vkUpdateDescriptorSetWithTemplateKHR update_with_template)
+		: movable_with_parent(instance, parent), destroy_template(destroy_template),
+		update_with_template(update_with_template) {}
+
+	void destroy();
+
+	// Extension functions, loaded by create.
+	PFN_vkDestroyDescriptorUpdateTemplateKHR destroy_template;
+	PFN_vkUpdateDescriptorSetWithTemplateKHR update_with_template;
+};
+
+// A template writing sets of layout, offsets and strides of entries are
+// into the data passed to update.
+VCC_LIBRARY descriptor_update_template_type create(
+	const type::supplier<const device::device_type> &device,
+	const descriptor_set_layout::descriptor_set_layout_type &layout,
+	const std::vector<VkDescriptorUpdateTemplateEntryKHR> &entries);
+
+// Writes descriptor_set from data laid out as the entries of update_template
+// describe. The set does not know the resources of raw handles, keep them
+// alive or pass their suppliers to the overload below. Input buffers are
+// not flushed, use descriptor_set::update for those.
+VCC_LIBRARY void update(const descriptor_update_template_type &update_template,
+	descriptor_set::descriptor_set_type &descriptor_set, const void *data);
+
+// Like update, the set keeps resources alive in place of those of the
+// previous template update.
+template<typename... T>
+void update(const descriptor_update_template_type &update_template,
+		descriptor_set::descriptor_set_type &descriptor_set, const void *data,
+		const type::supplier<T> &... resources) {
+	update(update_template, descriptor_set, data);
+	descriptor_set.references.erase(internal::references_key);
+	descriptor_set.references.put(internal::references_key, resources...);
+}
+
+#endif // VK_KHR_descriptor_update_template
+
+}  // namespace descriptor_update_template
+}  // namespace vcc
+
+#endif // _VCC_DESCRIPTOR_UPDATE_TEMPLATE_H_
@@ -20,40 +20,137 @@
 #include <vcc/util.h>
 
 namespace vcc {
+namespace deletion_queue {
+namespace internal {
+
+struct queue_type;
+
+}  // namespace internal
+}  // namespace deletion_queue
+
+namespace memory {
+namespace internal {
+
+struct device_memory_type;
+
+}  // namespace internal
+}  // namespace memory
+
+namespace transient {
+namespace internal {
+
+struct device_pool_type;
+
+}  // namespace internal
+}  // namespace transient
+
 namespace device {
 
+namespace internal {
+
+// Device functions of extensions used while recording, loaded by create
+// rather than looked up per command.
+struct functions_type {
+	functions_type()
+#if defined(VK_KHR_draw_indirect_count)
+		: draw_indirect_count(nullptr), draw_indexed_indirect_count(nullptr)
+#endif // VK_KHR_draw_indirect_count
+	{}
+
+#if defined(VK_KHR_draw_indirect_count)
+	// The extension functions, or the core ones on Vulkan 1.2 devices.
+	PFN_vkCmdDrawIndirectCountKHR draw_indirect_count;
+	PFN_vkCmdDrawIndexedIndirectCountKHR draw_indexed_indirect_count;
+#endif // VK_KHR_draw_indirect_count
+};
+
+template<typename DeviceT>
+auto get_functions(const DeviceT &device)->const decltype(device.functions)& {
+	return device.functions;
+}
+
+template<typename DeviceT>
+auto get_transient_pool(const DeviceT &device)->const decltype(device.transient_pool)& {
+	return device.transient_pool;
+}
+
+template<typename DeviceT>
+auto get_memory_state(const DeviceT &device)->const decltype(device.memory_state)& {
+	return device.memory_state;
+}
+
+template<typename DeviceT>
+auto get_deletion_queue(const DeviceT &device)->const decltype(device.deletion_queue)& {
+	return device.deletion_queue;
+}
+
+}  // namespace internal
+
 struct queue_create_info_type {
 	uint32_t queueFamilyIndex;
 	std::vector<float> queuePriorities;
 };
 
 struct device_type
-	: public internal::movable_destructible<VkDevice, vkDestroyDevice> {
+	: public vcc::internal::movable_destructible<VkDevice, vkDestroyDevice> {
 	friend VCC_LIBRARY device_type create(VkPhysicalDevice physical_device,
 		const std::vector<queue_create_info_type> &queue_create_info,
 		const std::set<std::string> &layers,
 		const std::set<std::string> &extensions,
-		const VkPhysicalDeviceFeatures &features);
+		const VkPhysicalDeviceFeatures &features,
+		const VkAllocationCallbacks *allocator, const void *next);
 	friend VkPhysicalDevice get_physical_device(const device_type &device);
+	template<typename DeviceT>
+	friend auto internal::get_functions(const DeviceT &device)
+		->const decltype(device.functions)&;
+	template<typename DeviceT>
+	friend auto internal::get_transient_pool(const DeviceT &device)
+		->const decltype(device.transient_pool)&;
+	template<typename DeviceT>
+	friend auto internal::get_memory_state(const DeviceT &device)
+		->const decltype(device.memory_state)&;
+	template<typename DeviceT>
+	friend auto internal::get_deletion_queue(const DeviceT &device)
+		->const decltype(device.deletion_queue)&;
 
 	device_type() = default;
 	device_type(const device_type&) = delete;
-	device_type(device_type&&copy) = default;
+	// Transient objects refer to the device they were created from, so a
+	// device can not be moved once they are used.
+	VCC_LIBRARY device_type(device_type&&copy);
 	device_type &operator=(const device_type&) = delete;
-	device_type &operator=(device_type&&copy) = default;
+	VCC_LIBRARY device_type &operator=(device_type&&copy);
 
 private:
-	device_type(VkDevice device, VkPhysicalDevice physical_device)
-		: movable_destructible(device), physical_device(physical_device) {}
+	device_type(VkDevice device, const VkAllocationCallbacks *allocator,
+		VkPhysicalDevice physical_device, const internal::functions_type &functions,
+		const std::shared_ptr<transient::internal::device_pool_type> &transient_pool,
+		const std::shared_ptr<memory::internal::device_memory_type> &memory_state,
+		const std::shared_ptr<deletion_queue::internal::queue_type> &deletion_queue)
+		: movable_destructible(device, allocator), physical_device(physical_device)
+		, functions(functions), transient_pool(transient_pool), memory_state(memory_state)
+		, deletion_queue(deletion_queue) {}
 
-	internal::handle_type<VkPhysicalDevice> physical_device;
+	vcc::internal::handle_type<VkPhysicalDevice> physical_device;
+	internal::functions_type functions;
+	// Destroyed before the VkDevice, as members are destroyed before bases.
+	std::shared_ptr<transient::internal::device_pool_type> transient_pool;
+	std::shared_ptr<memory::internal::device_memory_type> memory_state;
+	// Declared last, retired objects are destroyed before anything else.
+	std::shared_ptr<deletion_queue::internal::queue_type> deletion_queue;
 };
 
+// allocator is used for the device and every object created from it, and must
+// outlive them. See allocator::get_callbacks.
+// next is chained to VkDeviceCreateInfo::pNext, to enable the features of
+// extensions like VkPhysicalDeviceTimelineSemaphoreFeaturesKHR. features is
+// passed as pEnabledFeatures, so next must not hold a VkPhysicalDeviceFeatures2.
 VCC_LIBRARY device_type create(VkPhysicalDevice physical_device,
 	const std::vector<queue_create_info_type> &queue_create_info,
 	const std::set<std::string> &layers,
 	const std::set<std::string> &extensions,
-	const VkPhysicalDeviceFeatures &features);
+	const VkPhysicalDeviceFeatures &features,
+	const VkAllocationCallbacks *allocator = nullptr, const void *next = nullptr);
 
 VCC_LIBRARY void wait_idle(const device_type &device);
 
@@ -0,0 +1,271 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_GRAPH_H_
+#define _VCC_GRAPH_H_
+
+#include <string>
+#include <vcc/command.h>
+#include <vcc/memory.h>
+#include <vcc/parallel.h>
+
+namespace vcc {
+namespace graph {
+
+// Identifies a buffer or image within the graph it was added to.
+typedef uint32_t resource_type;
+// Identifies a pass within the graph it was added to.
+typedef uint32_t pass_type;
+
+struct compiled_type;
+
+// Records the commands of a pass, graph gives access to transient resources,
+// like to create the framebuffer of a render pass begun by the callback.
+typedef std::function<void(command::build_type &build, const compiled_type &graph)>
+	record_callback_type;
+
+enum pass_flag_bits {
+	// Kept even if nothing it writes is read, like a readback.
+	pass_side_effect_bit = 1,
+	// Begins no render pass, so it can be recorded in a secondary command buffer.
+	pass_parallel_bit = 2
+};
+typedef uint32_t pass_flags;
+
+struct image_description_type {
+	VkImageType imageType;
+	VkFormat format;
+	VkExtent3D extent;
+	uint32_t mipLevels, arrayLayers;
+	VkSampleCountFlagBits samples;
+	VkImageUsageFlags usage;
+	VkImageAspectFlags aspectMask;
+};
+
+struct buffer_description_type {
+	VkDeviceSize size;
+	VkBufferUsageFlags usage;
+};
+
+namespace internal {
+
+struct resource_info_type {
+	// Set for imported resources, created by compile for transient ones.
+	type::supplier<const buffer::buffer_type> buffer;
+	type::supplier<const image::image_type> image;
+	bool is_image, imported;
+	image_description_type image_description;
+	buffer_description_type buffer_description;
+	// The state of imported images when the graph starts and the layout they
+	// are left in, VK_IMAGE_LAYOUT_UNDEFINED to leave them as the last pass did.
+	VkImageLayout initial_layout, final_layout;
+	VkPipelineStageFlags initial_stages;
+	VkAccessFlags initial_access;
+};
+
+struct access_type {
+	resource_type resource;
+	VkPipelineStageFlags stage;
+	VkAccessFlags access;
+	// final_layout is the layout the pass leaves the image in, like a render
+	// pass' finalLayout.
+	VkImageLayout layout, final_layout;
+	bool write;
+};
+
+struct pass_info_type {
+	std::string name;
+	std::vector<access_type> accesses;
+	record_callback_type callback;
+	pass_flags flags;
+};
+
+// The resources a transient resource is aliased with must be done before
+// its first use, merged into the barrier before that level.
+struct alias_barrier_type {
+	VkPipelineStageFlags src_stages, dst_stages;
+	VkAccessFlags src_access, dst_access;
+};
+
+struct level_type {
+	// Indices into compiled_type::passes.
+	std::vector<std::size_t> passes;
+	alias_barrier_type alias_barrier;
+};
+
+// What compile learns about a resource while leveling the passes, levels
+// are -1 until it is used.
+struct usage_type {
+	int last_write, last_read, first, last;
+	VkImageLayout layout;
+	// All stages and writes, and the accesses of the first level using it.
+	VkPipelineStageFlags stages, first_stages;
+	VkAccessFlags write_access, first_access;
+};
+
+struct placement_type {
+	resource_type resource;
+	VkDeviceSize offset, size;
+};
+
+// Walks back from the passes with effects outside the graph, keeping the
+// passes writing what kept passes read.
+VCC_LIBRARY std::vector<bool> cull(const std::vector<resource_info_type> &resources,
+	const std::vector<pass_info_type> &passes);
+
+// Returns the level of each kept pass, one after the passes it depends on,
+// and -1 for the others. A layout transition is a write.
+VCC_LIBRARY std::vector<int> assign_levels(const std::vector<resource_info_type> &resources,
+	const std::vector<pass_info_type> &passes, const std::vector<bool> &keep,
+	std::vector<usage_type> &usages);
+
+// Places each resource at the lowest offset not used by a resource alive at
+// the same time, largest first, and returns the size of the memory needed.
+VCC_LIBRARY VkDeviceSize place(const std::vector<usage_type> &usages,
+	const std::vector<VkMemoryRequirements> &requirements,
+	VkDeviceSize granularity, std::vector<placement_type> &placements);
+
+}  // namespace internal
+
+/*
+ * Describes a frame as passes declaring how they access buffers and images.
+ * A read sees the last write of a pass added before it, so passes are added
+ * in the order they would be recorded by hand.
+ */
+struct graph_type {
+	friend VCC_LIBRARY resource_type import_buffer(graph_type &graph,
+		const type::supplier<const buffer::buffer_type> &buffer);
+	friend VCC_LIBRARY resource_type import_image(graph_type &graph,
+		const type::supplier<const image::image_type> &image, VkImageAspectFlags aspectMask,
+		VkImageLayout initial_layout, VkPipelineStageFlags initial_stages,
+		VkAccessFlags initial_access, VkImageLayout final_layout);
+	friend VCC_LIBRARY resource_type create_buffer(graph_type &graph,
+		const buffer_description_type &description);
+	friend VCC_LIBRARY resource_type create_image(graph_type &graph,
+		const image_description_type &description);
+	friend VCC_LIBRARY pass_type add_pass(graph_type &graph, const std::string &name,
+		const record_callback_type &callback, pass_flags flags);
+	friend VCC_LIBRARY void read(graph_type &graph, pass_type pass, resource_type resource,
+		VkPipelineStageFlags stage, VkAccessFlags access, VkImageLayout layout);
+	friend VCC_LIBRARY void write(graph_type &graph, pass_type pass, resource_type resource,
+		VkPipelineStageFlags stage, VkAccessFlags access, VkImageLayout layout,
+		VkImageLayout final_layout);
+	friend VCC_LIBRARY compiled_type compile(
+		const type::supplier<const device::device_type> &device, const graph_type &graph);
+
+private:
+	std::vector<internal::resource_info_type> resources;
+	std::vector<internal::pass_info_type> passes;
+};
+
+// Imported buffers are assumed idle when the graph starts, and passes
+// writing them are never culled.
+VCC_LIBRARY resource_type import_buffer(graph_type &graph,
+	const type::supplier<const buffer::buffer_type> &buffer);
+
+// Like swapchain images or textures, passes writing them are never culled.
+VCC_LIBRARY resource_type import_image(graph_type &graph,
+	const type::supplier<const image::image_type> &image, VkImageAspectFlags aspectMask,
+	VkImageLayout initial_layout, VkPipelineStageFlags initial_stages,
+	VkAccessFlags initial_access, VkImageLayout final_layout);
+
+// Transient resources are created by compile and only live within the
+// graph, their memory is shared with transient resources of disjoint
+// lifetime.
+VCC_LIBRARY resource_type create_buffer(graph_type &graph,
+	const buffer_description_type &description);
+VCC_LIBRARY resource_type create_image(graph_type &graph,
+	const image_description_type &description);
+
+VCC_LIBRARY pass_type add_pass(graph_type &graph, const std::string &name,
+	const record_callback_type &callback, pass_flags flags = 0);
+
+// Declares an access of the pass to a whole resource, the graph makes sure
+// images are in layout when the pass starts. Layouts are ignored for buffers.
+VCC_LIBRARY void read(graph_type &graph, pass_type pass, resource_type resource,
+	VkPipelineStageFlags stage, VkAccessFlags access,
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+
+// A write not declared as read too overwrites the whole resource, earlier
+// passes only writing it are culled. Render pass attachments are written in
+// the attachment's initialLayout and left in its finalLayout, final_layout
+// defaults to layout.
+VCC_LIBRARY void write(graph_type &graph, pass_type pass, resource_type resource,
+	VkPipelineStageFlags stage, VkAccessFlags access,
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED,
+	VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED);
+
+namespace internal {
+
+VCC_LIBRARY void execute(const compiled_type &graph, command::build_type &build,
+	parallel::recorder_type *recorder);
+
+}  // namespace internal
+
+/*
+ * A graph with unused passes culled, the rest grouped into levels of
+ * independent passes and its transient resources created. Executing it
+ * records one barrier per level. Imported resources can not be replaced,
+ * compile one graph per swapchain image.
+ */
+struct compiled_type {
+	friend VCC_LIBRARY compiled_type compile(
+		const type::supplier<const device::device_type> &device, const graph_type &graph);
+	friend VCC_LIBRARY void internal::execute(const compiled_type &graph,
+		command::build_type &build, parallel::recorder_type *recorder);
+	friend VCC_LIBRARY std::vector<std::string> get_pass_names(const compiled_type &graph);
+	friend VCC_LIBRARY type::supplier<const buffer::buffer_type> get_buffer(
+		const compiled_type &graph, resource_type resource);
+	friend VCC_LIBRARY type::supplier<const image::image_type> get_image(
+		const compiled_type &graph, resource_type resource);
+
+	compiled_type() = default;
+	compiled_type(const compiled_type &) = delete;
+	compiled_type(compiled_type &&) = default;
+	compiled_type &operator=(const compiled_type &) = delete;
+	compiled_type &operator=(compiled_type &&) = default;
+
+private:
+	std::vector<internal::resource_info_type> resources;
+	std::vector<internal::pass_info_type> passes;
+	std::vector<internal::level_type> levels;
+	// Bound by the transient resources, null if there are none.
+	type::supplier<const memory::memory_type> memory;
+};
+
+VCC_LIBRARY compiled_type compile(const type::supplier<const device::device_type> &device,
+	const graph_type &graph);
+
+// Records the graph into build, tracking the accesses of build from then on.
+VCC_LIBRARY void execute(const compiled_type &graph, command::build_type &build);
+
+// Like execute, but the pass_parallel_bit passes of a level are recorded in
+// parallel into secondary command buffers of the recorder.
+VCC_LIBRARY void execute(const compiled_type &graph, command::build_type &build,
+	parallel::recorder_type &recorder);
+
+// The passes left after culling, in the order they are recorded.
+VCC_LIBRARY std::vector<std::string> get_pass_names(const compiled_type &graph);
+
+// Imported or transient resources, transient ones are null if culled.
+VCC_LIBRARY type::supplier<const buffer::buffer_type> get_buffer(const compiled_type &graph,
+	resource_type resource);
+VCC_LIBRARY type::supplier<const image::image_type> get_image(const compiled_type &graph,
+	resource_type resource);
+
+}  // namespace graph
+}  // namespace vcc
+
+#endif // _VCC_GRAPH_H_
@@ -0,0 +1,87 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_INDIRECT_H_
+#define _VCC_INDIRECT_H_
+
+#include <type/types.h>
+#include <vcc/command.h>
+
+namespace vcc {
+namespace indirect {
+
+/*
+ * The arguments of indirect commands as the types library serializes them.
+ * Arrays of them in an input_buffer created with type::linear or
+ * type::linear_std430 are tightly packed like the device reads them, and
+ * type::linear_std430 matches a culling shader writing them to a storage
+ * buffer. Pass sizeof the Vulkan struct as stride.
+ */
+struct draw_command_type {
+	uint32_t vertexCount, instanceCount, firstVertex, firstInstance;
+
+	VCC_STRUCT_SERIALIZABLE(vertexCount, instanceCount, firstVertex, firstInstance);
+};
+
+struct draw_indexed_command_type {
+	uint32_t indexCount, instanceCount, firstIndex;
+	int32_t vertexOffset;
+	uint32_t firstInstance;
+
+	VCC_STRUCT_SERIALIZABLE(indexCount, instanceCount, firstIndex, vertexOffset,
+		firstInstance);
+};
+
+struct dispatch_command_type {
+	uint32_t x, y, z;
+
+	VCC_STRUCT_SERIALIZABLE(x, y, z);
+};
+
+typedef type::t_array<draw_command_type> draw_command_array;
+typedef type::t_array<draw_indexed_command_type> draw_indexed_command_array;
+typedef type::t_array<dispatch_command_type> dispatch_command_array;
+
+static_assert(type::internal::primitive_type_information<type::linear,
+	draw_command_type>::size == sizeof(VkDrawIndirectCommand),
+	"draw_command_type must serialize like VkDrawIndirectCommand");
+static_assert(type::internal::primitive_type_information<type::linear,
+	draw_indexed_command_type>::size == sizeof(VkDrawIndexedIndirectCommand),
+	"draw_indexed_command_type must serialize like VkDrawIndexedIndirectCommand");
+static_assert(type::internal::primitive_type_information<type::linear,
+	dispatch_command_type>::size == sizeof(VkDispatchIndirectCommand),
+	"dispatch_command_type must serialize like VkDispatchIndirectCommand");
+
+// Draws every command of an input_buffer holding only commands.
+inline command::draw_indirect_data_type draw_indirect(
+		const type::supplier<const input_buffer::input_buffer_type> &buffer) {
+	return command::draw_indirect_data_type{ buffer, 0,
+		uint32_t(type::size(input_buffer::internal::get_serialize(*buffer))
+			/ sizeof(VkDrawIndirectCommand)),
+		sizeof(VkDrawIndirectCommand) };
+}
+
+inline command::draw_indexed_indirect_data_type draw_indexed_indirect(
+		const type::supplier<const input_buffer::input_buffer_type> &buffer) {
+	return command::draw_indexed_indirect_data_type{ buffer, 0,
+		uint32_t(type::size(input_buffer::internal::get_serialize(*buffer))
+			/ sizeof(VkDrawIndexedIndirectCommand)),
+		sizeof(VkDrawIndexedIndirectCommand) };
+}
+
+}  // namespace indirect
+}  // namespace vcc
+
+#endif // _VCC_INDIRECT_H_
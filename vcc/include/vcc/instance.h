@@ -26,7 +26,8 @@ namespace instance {
 struct instance_type : public internal::movable_destructible<VkInstance, vkDestroyInstance> {
 	friend VCC_LIBRARY instance_type create(
 		const std::set<std::string> &layers,
-		const std::set<std::string> &extensions);
+		const std::set<std::string> &extensions,
+		const VkAllocationCallbacks *allocator);
 
 	instance_type() = default;
 	instance_type(instance_type &&) = default;
@@ -35,13 +36,16 @@ struct instance_type : public internal::movable_destructible<VkInstance, vkDestr
 	instance_type &operator=(const instance_type &) = delete;
 
 private:
-	explicit instance_type(VkInstance instance)
-		: internal::movable_destructible<VkInstance, vkDestroyInstance>(instance) {}
+	instance_type(VkInstance instance, const VkAllocationCallbacks *allocator)
+		: internal::movable_destructible<VkInstance, vkDestroyInstance>(instance, allocator) {}
 };
 
+// allocator is used for the instance and everything created from it, and must
+// outlive them. See allocator::get_callbacks.
 VCC_LIBRARY instance_type create(
 	const std::set<std::string> &layers = std::set<std::string>(),
-	const std::set<std::string> &extensions = std::set<std::string>());
+	const std::set<std::string> &extensions = std::set<std::string>(),
+	const VkAllocationCallbacks *allocator = nullptr);
 
 }  // namespace instance
 }  // namespace vcc
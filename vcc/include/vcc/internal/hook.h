@@ -16,38 +16,275 @@
 #ifndef _VCC_INTERNAL_HOOK_H_
 #define _VCC_INTERNAL_HOOK_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <new>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace vcc {
 namespace internal {
 
+// Bump allocator for objects living as long as one recording. Blocks are
+// kept when cleared, so recording again into the same container reuses them.
+class arena_type {
+public:
+	arena_type() : block(0), offset(0) {}
+	arena_type(const arena_type &) = delete;
+	arena_type(arena_type &&copy) : blocks(std::move(copy.blocks)), block(copy.block),
+		offset(copy.offset) {
+		copy.blocks.clear();
+		copy.clear();
+	}
+	arena_type &operator=(const arena_type &) = delete;
+	arena_type &operator=(arena_type &&copy) {
+		blocks = std::move(copy.blocks);
+		block = copy.block;
+		offset = copy.offset;
+		copy.blocks.clear();
+		copy.clear();
+		return *this;
+	}
+
+	void *allocate(std::size_t size, std::size_t alignment) {
+		for (;; ++block, offset = 0) {
+			if (block == blocks.size()) {
+				// Grows geometrically, so a recording allocates a logarithmic
+				// number of blocks.
+				std::size_t capacity(blocks.empty() ? std::size_t(min_block_size)
+					: 2 * blocks.back().size);
+				if (capacity < size) {
+					capacity = size;
+				}
+				blocks.push_back(block_type{ std::unique_ptr<char[]>(new char[capacity]),
+					capacity });
+			}
+			const std::size_t begin((offset + alignment - 1) / alignment * alignment);
+			if (begin + size <= blocks[block].size) {
+				offset = begin + size;
+				return blocks[block].data.get() + begin;
+			}
+		}
+	}
+
+	void clear() {
+		block = 0;
+		offset = 0;
+	}
+
+	void swap(arena_type &other) {
+		std::swap(blocks, other.blocks);
+		std::swap(block, other.block);
+		std::swap(offset, other.offset);
+	}
+
+private:
+	static const std::size_t min_block_size = 4096;
+
+	struct block_type {
+		std::unique_ptr<char[]> data;
+		std::size_t size;
+	};
+	std::vector<block_type> blocks;
+	std::size_t block, offset;
+};
+
+template<typename InstanceT, typename... ArgsT>
+InstanceT *arena_new(arena_type &arena, ArgsT&&... args) {
+	static_assert(alignof(InstanceT) <= alignof(std::max_align_t),
+		"arena blocks are only aligned for fundamental types");
+	return new (arena.allocate(sizeof(InstanceT), alignof(InstanceT)))
+		InstanceT(std::forward<ArgsT>(args)...);
+}
+
+// Open addressing set of object addresses. Keeps its capacity when cleared,
+// so it stops allocating once grown.
+class key_set_type {
+public:
+	key_set_type() : count(0) {}
+
+	// Returns false if the key was already in the set.
+	bool insert(const void *key) {
+		if (2 * (count + 1) > keys.size()) {
+			grow();
+		}
+		return insert(keys, key);
+	}
+
+	void clear() {
+		if (count) {
+			std::fill(keys.begin(), keys.end(), nullptr);
+			count = 0;
+		}
+	}
+
+private:
+	bool insert(std::vector<const void *> &table, const void *key) {
+		const std::size_t mask(table.size() - 1);
+		// Addresses are aligned, mix in the higher bits.
+		const std::uintptr_t value(reinterpret_cast<std::uintptr_t>(key));
+		for (std::size_t index((value ^ (value >> 7) ^ (value >> 17)) & mask);;
+				index = (index + 1) & mask) {
+			if (!table[index]) {
+				table[index] = key;
+				++count;
+				return true;
+			} else if (table[index] == key) {
+				return false;
+			}
+		}
+	}
+
+	void grow() {
+		std::vector<const void *> grown(keys.empty() ? 16 : 2 * keys.size(), nullptr);
+		count = 0;
+		for (const void *key : keys) {
+			if (key) {
+				insert(grown, key);
+			}
+		}
+		keys.swap(grown);
+	}
+
+	std::vector<const void *> keys;
+	std::size_t count;
+};
+
+/*
+ * Callbacks are stored inline in an arena instead of as std::function in a
+ * vector, so adding a callback does not allocate once the arena has grown.
+ * Moving transfers the callbacks, assigning swaps the arenas so the blocks
+ * of the assigned-to container are reused by the moved-from one.
+ *
+ * Callbacks added with a key, the address of the object they check or
+ * flush, are added and called at most once per key. Calling with a shared
+ * key_set_type extends that across containers, like all command buffers of
+ * one submit.
+ */
 template<typename... T>
 class hook_container_type {
+private:
+	struct instance {
+		explicit instance(const void *key) : key(key), next(nullptr) {}
+		virtual ~instance() {}
+		virtual void call(key_set_type &called, T... value) const = 0;
+		const void *key;
+		instance *next;
+	};
+	template<typename CallbackT>
+	struct template_instance : public instance {
+		template<typename U>
+		template_instance(const void *key, U &&callback)
+			: instance(key), callback(std::forward<U>(callback)) {}
+		void call(key_set_type &called, T... value) const {
+			callback(value...);
+		}
+		CallbackT callback;
+	};
+	struct nested_instance : public instance {
+		explicit nested_instance(const hook_container_type &container)
+			: instance(&container), container(container) {}
+		void call(key_set_type &called, T... value) const {
+			container(called, value...);
+		}
+		const hook_container_type &container;
+	};
 public:
 	typedef std::function<void(T...)> callback_type;
-	hook_container_type() = default;
+	hook_container_type() : first(nullptr), last(nullptr) {}
 	hook_container_type(const hook_container_type&) = delete;
-	hook_container_type(hook_container_type&&) = default;
+	hook_container_type(hook_container_type &&copy)
+		: arena(std::move(copy.arena)), keys(std::move(copy.keys)), first(copy.first),
+		last(copy.last) {
+		copy.keys.clear();
+		copy.first = copy.last = nullptr;
+	}
 	hook_container_type &operator=(const hook_container_type&) = delete;
-	hook_container_type &operator=(hook_container_type&&) = default;
+	hook_container_type &operator=(hook_container_type &&copy) {
+		clear();
+		arena.swap(copy.arena);
+		std::swap(keys, copy.keys);
+		std::swap(first, copy.first);
+		std::swap(last, copy.last);
+		return *this;
+	}
+	~hook_container_type() {
+		clear();
+	}
 
-	void add(const callback_type &callback) {
-		callbacks.push_back(callback);
+	template<typename CallbackT>
+	void add(CallbackT &&callback) {
+		append(arena_new<template_instance<typename std::decay<CallbackT>::type>>(arena,
+			nullptr, std::forward<CallbackT>(callback)));
 	}
-	void add(callback_type &&callback) {
-		callbacks.push_back(std::forward<callback_type>(callback));
+
+	// Ignored if a callback with the same key was already added.
+	template<typename CallbackT>
+	void add(const void *key, CallbackT &&callback) {
+		if (keys.insert(key)) {
+			append(arena_new<template_instance<typename std::decay<CallbackT>::type>>(arena,
+				key, std::forward<CallbackT>(callback)));
+		}
+	}
+
+	// Like add with a key, but the key is only unique within this container.
+	// The callback is called even if another container called with the same
+	// key_set_type added the key, for checks of what this container recorded.
+	template<typename CallbackT>
+	void add_local(const void *key, CallbackT &&callback) {
+		if (keys.insert(key)) {
+			append(arena_new<template_instance<typename std::decay<CallbackT>::type>>(arena,
+				nullptr, std::forward<CallbackT>(callback)));
+		}
+	}
+
+	// Calls the callbacks of container, which must outlive this container,
+	// sharing the keys already called.
+	void add_nested(const hook_container_type &container) {
+		if (keys.insert(&container)) {
+			append(arena_new<nested_instance>(arena, container));
+		}
 	}
 
 	void operator() (T... value) const {
-		for (const callback_type &callback : callbacks) {
-			callback(value...);
+		key_set_type called;
+		(*this)(called, value...);
+	}
+
+	// Skips and adds to called the keys of the callbacks.
+	void operator() (key_set_type &called, T... value) const {
+		for (const instance *callback = first; callback; callback = callback->next) {
+			if (!callback->key || called.insert(callback->key)) {
+				callback->call(called, value...);
+			}
+		}
+	}
+
+	// Destroys the callbacks but keeps the memory for the next recording.
+	void clear() {
+		while (first) {
+			instance *const next(first->next);
+			first->~instance();
+			first = next;
 		}
+		last = nullptr;
+		keys.clear();
+		arena.clear();
 	}
 private:
-	std::vector<callback_type> callbacks;
+	void append(instance *added) {
+		(last ? last->next : first) = added;
+		last = added;
+	}
+
+	arena_type arena;
+	key_set_type keys;
+	instance *first, *last;
 };
 
 template<typename KeyT, typename Hash, typename... T>
@@ -70,15 +307,22 @@ public:
 			callback.second(value...);
 		}
 	}
+
+	void clear() {
+		callbacks.clear();
+	}
 private:
 	typedef std::unordered_map<KeyT, callback_type, Hash> callbacks_container_type;
 	callbacks_container_type callbacks;
 };
 
+// Keeps the values alive, stored inline in an arena like hook_container_type.
 class reference_container_type {
 private:
 	struct instance {
+		instance() : next(nullptr) {}
 		virtual ~instance() {}
+		instance *next;
 	};
 	template<typename... T>
 	struct template_instance : public instance {
@@ -87,18 +331,43 @@ private:
 		std::tuple<T...> value;
 	};
 public:
-	reference_container_type() = default;
+	reference_container_type() : first(nullptr) {}
 	reference_container_type(const reference_container_type &) = delete;
-	reference_container_type(reference_container_type &&) = default;
+	reference_container_type(reference_container_type &&copy)
+		: arena(std::move(copy.arena)), first(copy.first) {
+		copy.first = nullptr;
+	}
 	reference_container_type &operator=(const reference_container_type &) = delete;
-	reference_container_type &operator=(reference_container_type &&) = default;
+	reference_container_type &operator=(reference_container_type &&copy) {
+		clear();
+		arena.swap(copy.arena);
+		std::swap(first, copy.first);
+		return *this;
+	}
+	~reference_container_type() {
+		clear();
+	}
 
 	template<typename... T>
 	void add(T... value) {
-		instances.emplace_back(new template_instance<T...>(std::forward<T>(value)...));
+		instance *const added(arena_new<template_instance<T...>>(arena,
+			std::forward<T>(value)...));
+		added->next = first;
+		first = added;
+	}
+
+	// Releases the references but keeps the memory for the next recording.
+	void clear() {
+		while (first) {
+			instance *const next(first->next);
+			first->~instance();
+			first = next;
+		}
+		arena.clear();
 	}
 private:
-	std::vector<std::shared_ptr<instance>> instances;
+	arena_type arena;
+	instance *first;
 };
 
 template<typename KeyT, typename HashT = std::hash<KeyT>>
@@ -132,6 +401,14 @@ public:
 	void clone(const KeyT &key, const reference_map_type &map) {
 		put(key, map.instances.at(key)->clone());
 	}
+
+	void erase(const KeyT &key) {
+		instances.erase(key);
+	}
+
+	void clear() {
+		instances.clear();
+	}
 private:
 	std::unordered_map<KeyT, std::shared_ptr<instance>, HashT> instances;
 };
@@ -114,6 +114,13 @@ auto get_mutex(const T &value)->decltype(value.mutex)& {
 	return value.mutex;
 }
 
+// Host allocation callbacks of a VkInstance or VkDevice, also used for every
+// object created from it.
+template<typename T>
+const VkAllocationCallbacks *get_allocator(const T &value) {
+	return value.allocator;
+}
+
 template<typename T>
 auto get_parent(T &value)->decltype(value.parent)& {
 	return value.parent;
@@ -189,20 +196,24 @@ struct movable_destructible {
 	friend auto get_instance(const U &value)->const decltype(value.instance)&;
 	template<typename U>
 	friend auto get_mutex(const U &value)->decltype(value.mutex)&;
+	template<typename U>
+	friend const VkAllocationCallbacks *get_allocator(const U &value);
 	typedef T value_type;
 
 protected:
-	movable_destructible() : instance(VK_NULL_HANDLE) {};
+	movable_destructible() : instance(VK_NULL_HANDLE), allocator(nullptr) {};
 	movable_destructible(const movable_destructible &) = delete;
 	movable_destructible(movable_destructible &&copy) {
 		std::lock_guard<std::mutex> lock(copy.mutex);
 		instance = std::move(copy.instance);
+		allocator = copy.allocator;
 	}
 	movable_destructible &operator=(const movable_destructible &) = delete;
 	movable_destructible &operator=(movable_destructible &&copy) {
 		destroy();
 		std::lock_guard<std::mutex> lock(copy.mutex);
 		instance = std::move(copy.instance);
+		allocator = copy.allocator;
 		return *this;
 	}
 
@@ -210,15 +221,18 @@ protected:
 		destroy();
 	}
 
-	explicit movable_destructible(T instance) : instance(instance) {}
+	explicit movable_destructible(T instance,
+		const VkAllocationCallbacks *allocator = nullptr)
+		: instance(instance), allocator(allocator) {}
 private:
 	handle_type<T> instance;
+	const VkAllocationCallbacks *allocator;
 	mutable std::mutex mutex;
 
 	void destroy() {
 		if (instance) {
 			std::lock_guard<std::mutex> lock(mutex);
-			PFN_vkDestroy(instance, NULL);
+			PFN_vkDestroy(instance, allocator);
 		}
 	}
 };
@@ -279,7 +293,7 @@ private:
 	void destroy() {
 		if (instance && parent) {
 			std::lock_guard<std::mutex> lock(mutex);
-			PFN_vkDestroy(get_instance(*parent), instance, NULL);
+			PFN_vkDestroy(get_instance(*parent), instance, get_allocator(*parent));
 		}
 	}
 };
@@ -483,7 +497,7 @@ private:
 	void destroy() {
 		if (instance && parent) {
 			std::lock_guard<std::mutex> lock(mutex);
-			PFN_vkDestroy(get_instance(*parent), instance, NULL);
+			PFN_vkDestroy(get_instance(*parent), instance, get_allocator(*parent));
 		}
 	}
 };
@@ -556,7 +570,7 @@ private:
 	void destroy() {
 		if (destructible && instance && parent) {
 			std::lock_guard<std::mutex> lock(mutex);
-			PFN_vkDestroy(get_instance(*parent), instance, NULL);
+			PFN_vkDestroy(get_instance(*parent), instance, get_allocator(*parent));
 		}
 	}
 };
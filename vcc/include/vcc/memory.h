@@ -17,7 +17,9 @@
 #define MEMORY_H_
 
 #include <climits>
+#include <functional>
 #include <numeric>
+#include <unordered_map>
 #include <vcc/buffer.h>
 #include <vcc/input_buffer.h>
 #include <vcc/device.h>
@@ -27,33 +29,184 @@
 namespace vcc {
 namespace memory {
 
+struct usage_statistics_type {
+	// used_bytes is the size of the resources bound right now, while
+	// largest_free_block is the largest gap between the resources bound when
+	// each allocation was created and is not updated afterwards.
+	VkDeviceSize allocated_bytes, used_bytes, largest_free_block;
+	uint32_t allocation_count;
+	// 1 - largest_free_block / (allocated_bytes - used_bytes), 0 if nothing is free.
+	float fragmentation;
+};
+
+struct statistics_type {
+	// Indexed by memory heap and memory type index respectively.
+	std::vector<usage_statistics_type> heaps, types;
+	// Per heap, from VK_EXT_memory_budget if enable_memory_budget was called,
+	// otherwise the heap size and the bytes allocated through vcc.
+	std::vector<VkDeviceSize> heap_budget, heap_usage;
+};
+
+// Called when an allocation brings the usage of a heap above the threshold of its budget.
+typedef std::function<void(uint32_t heap_index, VkDeviceSize usage, VkDeviceSize budget)>
+	budget_callback_type;
+
+// Intended access pattern of the memory, used to pick the best memory type.
+enum usage_type {
+	// Only accessed by the device, e.g. textures and render targets.
+	gpu_only,
+	// Written by the host every frame and read by the device, e.g. uniforms.
+	cpu_to_gpu,
+	// Written by the device and read back by the host.
+	gpu_to_cpu,
+	// Host memory, e.g. staging buffers.
+	cpu_only,
+	// Attachments that only live within a render pass, created with
+	// VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and stored with
+	// VK_ATTACHMENT_STORE_OP_DONT_CARE. Lazily allocated where supported.
+	transient
+};
+
+struct memory_type;
+
+struct mapped_range_type {
+	type::supplier<const memory_type> memory;
+	VkDeviceSize offset, size;
+};
+
+namespace internal {
+
+template<typename SelectorT, typename... ArgsT>
+type::supplier<const memory_type> bind_memory(
+	const type::supplier<const device::device_type> &device, SelectorT selector,
+	ArgsT&... args);
+
+// Binds a number of buffers known only at runtime to a single allocation.
+VCC_LIBRARY type::supplier<const memory_type> bind_buffers(
+	const type::supplier<const device::device_type> &device,
+	VkMemoryPropertyFlags propertyFlags, const std::vector<buffer::buffer_type *> &buffers);
+
+// Allocates memory for resources the caller binds at offsets of its own
+// choosing, like transient resources aliasing each other.
+VCC_LIBRARY type::supplier<const memory_type> allocate(
+	const type::supplier<const device::device_type> &device, usage_type usage,
+	uint32_t memoryTypeBits, VkDeviceSize size);
+
+struct allocation_type {
+	uint32_t type_index, heap_index;
+	// used is the size of the resources bound right now, see make_binding.
+	// largest_free_block is computed at creation time only.
+	VkDeviceSize size, used, largest_free_block;
+};
+
+// Resources that should get an allocation of their own, null otherwise.
+struct dedicated_type {
+	VkImage image;
+	VkBuffer buffer;
+};
+
+struct device_memory_type {
+	device_memory_type() : threshold(1)
+#if defined(VK_KHR_dedicated_allocation) && defined(VK_KHR_get_memory_requirements2)
+		, get_image_memory_requirements2(nullptr), get_buffer_memory_requirements2(nullptr)
+#endif // VK_KHR_dedicated_allocation
+#if defined(VK_KHR_get_physical_device_properties2) && defined(VK_EXT_memory_budget)
+		, get_physical_device_memory_properties2(nullptr)
+#endif // VK_EXT_memory_budget
+	{}
+
+	std::mutex mutex;
+	std::unordered_map<VkDeviceMemory, allocation_type> allocations;
+	budget_callback_type budget_callback;
+	float threshold;
+	// Written through map_type on non-coherent memory, flushed by the next queue::submit.
+	std::vector<mapped_range_type> pending_flushes;
+#if defined(VK_KHR_dedicated_allocation) && defined(VK_KHR_get_memory_requirements2)
+	// Loaded by device::create when both extensions are enabled.
+	PFN_vkGetImageMemoryRequirements2KHR get_image_memory_requirements2;
+	PFN_vkGetBufferMemoryRequirements2KHR get_buffer_memory_requirements2;
+#endif // VK_KHR_dedicated_allocation
+#if defined(VK_KHR_get_physical_device_properties2) && defined(VK_EXT_memory_budget)
+	// Loaded by enable_memory_budget, the heap sizes are used while null.
+	PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_physical_device_memory_properties2;
+#endif // VK_EXT_memory_budget
+};
+
+template<typename MemoryT>
+VkDeviceSize get_size(const MemoryT &memory) {
+	return memory.size;
+}
+
+template<typename MemoryT>
+const VkMemoryType &get_type(const MemoryT &memory) {
+	return memory.type;
+}
+
+}  // namespace internal
+
 struct memory_type : vcc::internal::movable_destructible_with_parent<
 		VkDeviceMemory, const device::device_type, vkFreeMemory> {
 
-	template<typename... ArgsT>
-	friend type::supplier<const memory_type> bind(
+	template<typename SelectorT, typename... ArgsT>
+	friend type::supplier<const memory_type> internal::bind_memory(
+		const type::supplier<const device::device_type> &device, SelectorT selector,
+		ArgsT&... args);
+	friend VCC_LIBRARY type::supplier<const memory_type> internal::bind_buffers(
 		const type::supplier<const device::device_type> &device,
-		VkMemoryPropertyFlags propertyFlags, ArgsT&... args);
+		VkMemoryPropertyFlags propertyFlags, const std::vector<buffer::buffer_type *> &buffers);
+	friend VCC_LIBRARY type::supplier<const memory_type> internal::allocate(
+		const type::supplier<const device::device_type> &device, usage_type usage,
+		uint32_t memoryTypeBits, VkDeviceSize size);
 	friend struct map_type;
+	friend VCC_LIBRARY map_type map(const type::supplier<const memory_type> &memory,
+		VkDeviceSize offset, VkDeviceSize size);
+	template<typename MemoryT>
+	friend VkDeviceSize internal::get_size(const MemoryT &memory);
+	template<typename MemoryT>
+	friend const VkMemoryType &internal::get_type(const MemoryT &memory);
 
-	memory_type() = default;
+	memory_type() : mapped(nullptr) {}
 	memory_type(memory_type &&) = default;
+	VCC_LIBRARY ~memory_type();
 
 private:
+	// largest_free_block describes how the resources are packed, for statistics.
+	// Returns the error of vkAllocateMemory, memory is only tracked on success.
+	VCC_LIBRARY static VkResult try_allocate(
+		const type::supplier<const device::device_type> &device, VkDeviceSize allocationSize,
+		VkDeviceSize largest_free_block, uint32_t memoryTypeIndex, VkMemoryType type, const internal::dedicated_type &dedicated,
+		VkDeviceMemory &memory);
+	// Allocates from the first memory type that has all of propertyFlags.
+	VCC_LIBRARY static memory_type allocate(
+		const type::supplier<const device::device_type> &device, VkDeviceSize allocationSize,
+		VkDeviceSize largest_free_block, uint32_t memoryTypeBits,
+		VkMemoryPropertyFlags propertyFlags, const internal::dedicated_type &dedicated);
+	// Allocates from the best memory type for the usage, falling back to the
+	// next best one whenever a heap is out of device memory.
 	VCC_LIBRARY static memory_type allocate(
 		const type::supplier<const device::device_type> &device, VkDeviceSize allocationSize,
-		uint32_t memoryTypeIndex, VkMemoryType type);
+		VkDeviceSize largest_free_block, uint32_t memoryTypeBits,
+		usage_type usage, const internal::dedicated_type &dedicated);
 
 	memory_type(VkDeviceMemory instance, const type::supplier<const device::device_type> &parent,
 		VkDeviceSize size, VkMemoryType type)
-		: movable_destructible_with_parent(instance, parent), size(size), type(type) {}
+		: movable_destructible_with_parent(instance, parent), size(size), type(type)
+		, mapped(nullptr) {}
 
 	VkDeviceSize size;
 	VkMemoryType type;
+	// Host visible memory is mapped as a whole on first use and stays mapped,
+	// so flushes can be deferred.
+	mutable void *mapped;
 };
 
 namespace internal {
 
+// The supplier bound resources hold, counting size bytes of memory as used
+// until the resource is destroyed or bound elsewhere.
+VCC_LIBRARY type::supplier<const memory_type> make_binding(
+	const type::supplier<const memory_type> &memory, VkDeviceSize size);
+
 VCC_LIBRARY VkMemoryRequirements get_memory_requirements(const image::image_type &image);
 VCC_LIBRARY VkMemoryRequirements get_memory_requirements(const buffer::buffer_type &buffer);
 VCC_LIBRARY void bind(const type::supplier<const memory_type> &memory,
@@ -65,6 +218,18 @@ VCC_LIBRARY VkMemoryRequirements get_memory_requirements(
 VCC_LIBRARY void bind(const type::supplier<const memory_type> &memory,
 	VkDeviceSize offset, input_buffer::input_buffer_type &buffer);
 
+// A single image or buffer gets a dedicated allocation if the driver prefers
+// or requires it, which needs VK_KHR_dedicated_allocation.
+VCC_LIBRARY dedicated_type get_dedicated(const image::image_type &image);
+VCC_LIBRARY dedicated_type get_dedicated(const buffer::buffer_type &buffer);
+VCC_LIBRARY dedicated_type get_dedicated(const input_buffer::input_buffer_type &buffer);
+
+// Resources sharing one allocation never get a dedicated one.
+template<typename... ArgsT>
+dedicated_type get_dedicated(const ArgsT&... args) {
+	return dedicated_type{ VK_NULL_HANDLE, VK_NULL_HANDLE };
+}
+
 template<std::size_t Index>
 struct bind_t {
 	template<typename... ArgsT>
@@ -82,47 +247,63 @@ struct bind_t<0> {
 		std::tuple<ArgsT...>&& args) {}
 };
 
-}  // namespace internal
+// Returns the first memory type in memoryTypeBits that has all of propertyFlags.
+VCC_LIBRARY uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties &memory_properties,
+	uint32_t memoryTypeBits, VkMemoryPropertyFlags propertyFlags);
+// Returns the memory types in memoryTypeBits that fit the usage, best first.
+VCC_LIBRARY std::vector<uint32_t> rank_memory_types(
+	const VkPhysicalDeviceMemoryProperties &memory_properties, uint32_t memoryTypeBits,
+	usage_type usage);
+// Returns the memory type in memoryTypeBits that scores best for the usage.
+VCC_LIBRARY uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties &memory_properties,
+	uint32_t memoryTypeBits, usage_type usage);
 
-template<typename... ArgsT>
-type::supplier<const memory_type> bind(
-		const type::supplier<const device::device_type> &device,
-		VkMemoryPropertyFlags propertyFlags,
+template<typename SelectorT, typename... ArgsT>
+type::supplier<const memory_type> bind_memory(
+		const type::supplier<const device::device_type> &device, SelectorT selector,
 		ArgsT&... args) {
 	constexpr size_t num_args(sizeof...(ArgsT));
-	const VkMemoryRequirements memory_requirements[] = { internal::get_memory_requirements(args)... };
+	const VkMemoryRequirements memory_requirements[] = { get_memory_requirements(args)... };
 	VkDeviceSize offsets[num_args];
 	offsets[0] = 0;
 	uint32_t memoryTypeBits(memory_requirements[0].memoryTypeBits);
+	VkDeviceSize largest_free_block(0);
 	for (int i = 1; i < num_args; ++i) {
 		auto alignment(memory_requirements[i].alignment);
-		offsets[i] = offsets[i - 1] + memory_requirements[i - 1].size;
-		offsets[i] += (alignment - (offsets[i] % alignment)) % alignment;
+		const VkDeviceSize end(offsets[i - 1] + memory_requirements[i - 1].size);
+		offsets[i] = end + (alignment - (end % alignment)) % alignment;
 		memoryTypeBits &= memory_requirements[i].memoryTypeBits;
+		if (offsets[i] - end > largest_free_block) {
+			largest_free_block = offsets[i] - end;
+		}
 	}
 	const VkDeviceSize size = offsets[num_args - 1] + memory_requirements[num_args - 1].size;
 	if (!memoryTypeBits) {
 		throw vcc_exception("No memoryTypeBits for all given storage.");
 	}
-	uint32_t memoryTypeIndex;
-	const VkPhysicalDeviceMemoryProperties memory_properties(
-		vcc::physical_device::memory_properties(device::get_physical_device(*device)));
-	for (memoryTypeIndex = 0; memoryTypeIndex < memory_properties.memoryTypeCount; ++memoryTypeIndex) {
-		if ((memoryTypeBits & 1) == 1
-			&& (memory_properties.memoryTypes[memoryTypeIndex].propertyFlags & propertyFlags) == propertyFlags) {
-			break;
-		}
-		memoryTypeBits >>= 1;
-	}
-	if (memoryTypeIndex == memory_properties.memoryTypeCount) {
-		throw vcc_exception("Failed to find valid memoryTypeBits that fits the propertyFlags");
-	}
 	std::shared_ptr<memory_type> memory(std::make_shared<memory_type>(memory_type::allocate(device,
-		size, memoryTypeIndex, memory_properties.memoryTypes[memoryTypeIndex])));
-	internal::bind_t<num_args>::bind(memory, offsets, std::tie(args...));
+		size, largest_free_block, memoryTypeBits, selector, get_dedicated(args...))));
+	bind_t<num_args>::bind(memory, offsets, std::tie(args...));
 	return memory;
 }
 
+}  // namespace internal
+
+template<typename... ArgsT>
+type::supplier<const memory_type> bind(
+		const type::supplier<const device::device_type> &device,
+		VkMemoryPropertyFlags propertyFlags,
+		ArgsT&... args) {
+	return internal::bind_memory(device, propertyFlags, args...);
+}
+
+template<typename... ArgsT>
+type::supplier<const memory_type> bind(
+		const type::supplier<const device::device_type> &device,
+		usage_type usage, ArgsT&... args) {
+	return internal::bind_memory(device, usage, args...);
+}
+
 struct map_type {
 	map_type() = delete;
 	map_type(const map_type&) = delete;
@@ -141,16 +322,46 @@ struct map_type {
 	void *data;
 };
 
-// Returns a map_type which will automatically unmap the memory, RAII style.
+// Returns a map_type which will automatically flush non-coherent memory, RAII style.
+// The flush is deferred until the next queue::submit or flush_pending on the device.
+// Mapping does not invalidate, reading device writes from non-coherent memory
+// needs an invalidate of the range first.
 // map_type::data is the pointer to the area where the memory is mapped.
 VCC_LIBRARY map_type map(const type::supplier<const memory_type> &memory, VkDeviceSize offset = 0,
 	VkDeviceSize size = VK_WHOLE_SIZE);
 
 VCC_LIBRARY void flush(const memory_type &memory, VkDeviceSize offset = 0,
 	VkDeviceSize size = VK_WHOLE_SIZE);
+// Flushes the writes to memory still pending from map_type first, an
+// invalidate would otherwise discard them.
 VCC_LIBRARY void invalidate(const memory_type &memory, VkDeviceSize offset = 0,
 	VkDeviceSize size = VK_WHOLE_SIZE);
 
+// Rounds the ranges to nonCoherentAtomSize and merges overlapping and adjacent ranges,
+// then flushes or invalidates them with a single call per device. Coherent
+// memory is skipped.
+VCC_LIBRARY void flush(const std::vector<mapped_range_type> &ranges);
+VCC_LIBRARY void invalidate(const std::vector<mapped_range_type> &ranges);
+
+// Flushes all ranges written through map_type since the last call.
+VCC_LIBRARY void flush_pending(const device::device_type &device);
+
+#if defined(VK_KHR_get_physical_device_properties2) && defined(VK_EXT_memory_budget)
+// Makes statistics and the budget callback use VK_EXT_memory_budget. The
+// instance must have VK_KHR_get_physical_device_properties2 enabled, or be
+// created for Vulkan 1.1, and the device VK_EXT_memory_budget.
+VCC_LIBRARY void enable_memory_budget(const instance::instance_type &instance,
+	const device::device_type &device);
+#endif // VK_EXT_memory_budget
+
+// Reports what is currently allocated through memory::bind on the device.
+VCC_LIBRARY statistics_type statistics(const device::device_type &device);
+
+// threshold is a fraction of the heap budget, in [0, 1].
+// The callback is invoked on the allocating thread.
+VCC_LIBRARY void set_budget_callback(const device::device_type &device, float threshold,
+	const budget_callback_type &callback);
+
 }  // namespace memory
 }  // namespace vcc
 
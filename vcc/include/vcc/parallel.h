@@ -0,0 +1,137 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_PARALLEL_H_
+#define _VCC_PARALLEL_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vcc/command.h>
+
+namespace vcc {
+namespace parallel {
+
+// Records the draws in [first, last) into build, which is a secondary
+// command buffer continuing the render pass, if any.
+typedef std::function<void(command::build_type &build, std::size_t first, std::size_t last)>
+	record_callback_type;
+
+namespace internal {
+
+// Command pools are externally synchronized, so every recording thread has
+// its own pool and list of secondary command buffers ready to be reused.
+struct worker_type {
+	command_pool::command_pool_type command_pool;
+	std::mutex mutex;
+	std::vector<command_buffer::command_buffer_type> command_buffers;
+};
+
+struct job_type {
+	type::supplier<const render_pass::render_pass_type> render_pass;
+	uint32_t subpass;
+	type::supplier<const framebuffer::framebuffer_type> framebuffer;
+	std::size_t count;
+	record_callback_type callback;
+	// One per worker, empty if the worker had no draws.
+	std::vector<type::supplier<const command_buffer::command_buffer_type>> command_buffers;
+	std::exception_ptr exception;
+};
+
+struct state_type {
+	state_type() : generation(0), remaining(0), stop(false) {}
+
+	std::mutex mutex;
+	std::condition_variable start, done;
+	uint64_t generation;
+	std::size_t remaining;
+	job_type job;
+	bool stop;
+};
+
+}  // namespace internal
+
+/*
+ * Splits a draw list across a pool of threads, each recording a secondary
+ * command buffer from its own command pool. The calling thread records the
+ * first part itself. Secondary command buffers are returned to their worker
+ * once no primary command buffer references them anymore.
+ */
+struct recorder_type {
+	friend VCC_LIBRARY recorder_type create(
+		const type::supplier<const device::device_type> &device,
+		uint32_t queue_family_index, std::size_t thread_count);
+	friend VCC_LIBRARY command::execute_commands record(recorder_type &recorder,
+		const type::supplier<const render_pass::render_pass_type> &render_pass,
+		uint32_t subpass, const type::supplier<const framebuffer::framebuffer_type> &framebuffer,
+		std::size_t count, const record_callback_type &callback);
+
+	recorder_type() = default;
+	recorder_type(const recorder_type &) = delete;
+	recorder_type(recorder_type &&) = default;
+	recorder_type &operator=(const recorder_type &) = delete;
+	recorder_type &operator=(recorder_type &&) = delete;
+
+	VCC_LIBRARY ~recorder_type();
+
+private:
+	recorder_type(const type::supplier<const device::device_type> &device,
+		std::vector<std::shared_ptr<internal::worker_type>> &&workers,
+		std::unique_ptr<internal::state_type> &&state, std::vector<std::thread> &&threads)
+		: device(device), workers(std::move(workers)), state(std::move(state)),
+		mutex(new std::mutex), threads(std::move(threads)) {}
+
+	type::supplier<const device::device_type> device;
+	std::vector<std::shared_ptr<internal::worker_type>> workers;
+	std::unique_ptr<internal::state_type> state;
+	// Held while recording, one record call runs at a time.
+	std::unique_ptr<std::mutex> mutex;
+	std::vector<std::thread> threads;
+};
+
+// The command pools are created for queue_family_index, the secondary
+// command buffers may only be executed on queues of that family.
+VCC_LIBRARY recorder_type create(const type::supplier<const device::device_type> &device,
+	uint32_t queue_family_index,
+	std::size_t thread_count = std::thread::hardware_concurrency());
+
+/*
+ * Calls callback on every thread with a contiguous part of [0, count) and
+ * waits until all parts are recorded. Parts that recorded nothing are left
+ * out, so the execute_commands is empty if count is 0, recording it then is
+ * a no-op. The returned execute_commands must be recorded inside the render
+ * pass' subpass, begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+ * The callback must only record commands valid in a secondary command
+ * buffer and must not rely on state set by the primary command buffer, like
+ * bound pipelines.
+ */
+VCC_LIBRARY command::execute_commands record(recorder_type &recorder,
+	const type::supplier<const render_pass::render_pass_type> &render_pass,
+	uint32_t subpass, const type::supplier<const framebuffer::framebuffer_type> &framebuffer,
+	std::size_t count, const record_callback_type &callback);
+
+// Like record, but the secondary command buffers do not continue a render
+// pass, for transfer and compute work recorded outside of one.
+inline command::execute_commands record(recorder_type &recorder, std::size_t count,
+		const record_callback_type &callback) {
+	return record(recorder, type::supplier<const render_pass::render_pass_type>(), 0,
+		type::supplier<const framebuffer::framebuffer_type>(), count, callback);
+}
+
+}  // namespace parallel
+}  // namespace vcc
+
+#endif // _VCC_PARALLEL_H_
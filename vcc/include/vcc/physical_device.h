@@ -58,6 +58,27 @@ VCC_LIBRARY uint32_t get_queue_family_properties_with_flag(
 	const std::vector<VkQueueFamilyProperties> &properties,
 	VkQueueFlags flags);
 
+// Like get_queue_family_properties_with_flag, but prefers the family with the
+// fewest of the avoided flags. Graphics and compute families count as
+// supporting transfers, whether they report it or not.
+VCC_LIBRARY uint32_t get_dedicated_queue_family(
+	const std::vector<VkQueueFamilyProperties> &properties,
+	VkQueueFlags flags, VkQueueFlags avoided);
+
+// A transfer-only family if there is one, they are usually backed by DMA
+// engines working alongside graphics.
+inline uint32_t get_transfer_queue_family(
+		const std::vector<VkQueueFamilyProperties> &properties) {
+	return get_dedicated_queue_family(properties, VK_QUEUE_TRANSFER_BIT,
+		VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+}
+
+// A compute family without graphics if there is one, for async compute.
+inline uint32_t get_compute_queue_family(
+		const std::vector<VkQueueFamilyProperties> &properties) {
+	return get_dedicated_queue_family(properties, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+}
+
 }  // namespace physical_device
 }  // namespace vcc
 
@@ -16,31 +16,40 @@
 #ifndef PIPELINE_LAYOUT_H_
 #define PIPELINE_LAYOUT_H_
 
+#include <mutex>
 #include <type/serialize.h>
 #include <vcc/device.h>
 #include <vcc/descriptor_set_layout.h>
-#include <vcc/internal/hook.h>
 
 namespace vcc {
-namespace queue {
-
-struct queue_type;
-
-}  // namespace queue
-
 namespace pipeline_layout {
 
 namespace internal {
 
+// Typed push constants owned by a pipeline layout. The serialized bytes are
+// cached and the revision is bumped whenever the storages change, so command
+// buffers can tell if the constants they recorded are stale.
+struct push_constants_type {
+	push_constants_type(const type::supplier<const type::serialize_type> &constants,
+		const std::vector<VkPushConstantRange> &push_constant_ranges)
+		: constants(constants), push_constant_ranges(push_constant_ranges), revision(0) {}
+
+	type::supplier<const type::serialize_type> constants;
+	std::vector<VkPushConstantRange> push_constant_ranges;
+	std::mutex mutex;
+	std::string data;
+	uint64_t revision;
+};
+
 template<typename PipelineLayoutT>
-auto get_pre_execute_callbacks(PipelineLayoutT &layout)->decltype(layout.pre_execute_callbacks)& {
-	return layout.pre_execute_callbacks;
+auto get_push_constants(PipelineLayoutT &layout)->decltype(layout.push_constants)& {
+	return layout.push_constants;
 }
 
 template<typename PipelineLayoutT>
-auto get_pre_execute_callbacks(const PipelineLayoutT &layout)
-		->const decltype(layout.pre_execute_callbacks)& {
-	return layout.pre_execute_callbacks;
+auto get_push_constants(const PipelineLayoutT &layout)
+		->const decltype(layout.push_constants)& {
+	return layout.push_constants;
 }
 
 template<typename PipelineLayoutT>
@@ -54,12 +63,12 @@ auto get_set_layouts(const PipelineLayoutT &pipeline)
 struct pipeline_layout_type : vcc::internal::movable_destructible_with_parent<VkPipelineLayout,
 		const device::device_type, vkDestroyPipelineLayout> {
 	template<typename PipelineLayoutT>
-	friend auto internal::get_pre_execute_callbacks(PipelineLayoutT &layout)
-		->decltype(layout.pre_execute_callbacks)&;
+	friend auto internal::get_push_constants(PipelineLayoutT &layout)
+		->decltype(layout.push_constants)&;
 
 	template<typename PipelineLayoutT>
-	friend auto internal::get_pre_execute_callbacks(const PipelineLayoutT &layout)
-		->const decltype(layout.pre_execute_callbacks)&;
+	friend auto internal::get_push_constants(const PipelineLayoutT &layout)
+		->const decltype(layout.push_constants)&;
 	friend VCC_LIBRARY pipeline_layout_type create(
 		const type::supplier<const device::device_type> &,
 		const std::vector<type::supplier<const vcc::descriptor_set_layout::descriptor_set_layout_type>> &,
@@ -82,7 +91,7 @@ private:
 		: movable_destructible_with_parent(instance, type::supplier<const device::device_type>(parent))
 		, set_layouts(set_layouts) {}
 	std::vector<type::supplier<const descriptor_set_layout::descriptor_set_layout_type>> set_layouts;
-	vcc::internal::hook_container_type<const queue::queue_type &> pre_execute_callbacks;
+	std::unique_ptr<internal::push_constants_type> push_constants;
 };
 
 VCC_LIBRARY pipeline_layout_type create(const type::supplier<const device::device_type> &device,
@@ -91,10 +100,13 @@ VCC_LIBRARY pipeline_layout_type create(const type::supplier<const device::devic
 
 namespace internal {
 
-VCC_LIBRARY void flush(const type::supplier<const type::serialize_type> &constants,
-	VkPipelineLayout pipeline_layout,
-	const std::vector<VkPushConstantRange> &push_constant_ranges,
-	const queue::queue_type &queue);
+// Records the typed push constants of the layout into command_buffer, if it has any.
+// Returns the revision of the recorded constants.
+VCC_LIBRARY uint64_t push_constants(const pipeline_layout_type &layout,
+	VkCommandBuffer command_buffer);
+
+// Returns the current revision of the typed push constants of the layout.
+VCC_LIBRARY uint64_t push_constants_revision(const pipeline_layout_type &layout);
 
 }  // namespace internal
 
@@ -114,11 +126,10 @@ pipeline_layout_type create(const type::supplier<const device::device_type> &dev
 		const std::vector<VkPushConstantRange> &push_constant_ranges, StorageType... storages) {
 	pipeline_layout_type pipeline_layout(create(type::supplier<const device::device_type>(device),
 		set_layouts, push_constant_ranges));
-	pipeline_layout::internal::get_pre_execute_callbacks(pipeline_layout).add(
-		std::bind(&internal::flush, type::make_supplier(type::make_serialize<Layout>(
-			type::make_supplier(std::forward<StorageType>(storages)...))),
-			vcc::internal::get_instance(pipeline_layout), push_constant_ranges,
-			std::placeholders::_1));
+	pipeline_layout::internal::get_push_constants(pipeline_layout).reset(
+		new internal::push_constants_type(type::make_supplier(type::make_serialize<Layout>(
+			type::make_supplier(std::forward<StorageType>(storages))...)),
+			push_constant_ranges));
 	return std::move(pipeline_layout);
 }
 
@@ -0,0 +1,101 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_PROGRESS_H_
+#define _VCC_PROGRESS_H_
+
+#include <atomic>
+#include <vcc/queue.h>
+
+#if defined(VK_KHR_timeline_semaphore)
+
+namespace vcc {
+namespace progress {
+
+namespace internal {
+
+struct state_type {
+	state_type() : issued(0), completed(0) {}
+
+	std::atomic<uint64_t> issued;
+	// The highest value seen completed, saves asking the device again.
+	std::atomic<uint64_t> completed;
+};
+
+}  // namespace internal
+
+/*
+ * Counts the progress of the device on a timeline semaphore. Submits whose
+ * completion matters signal the value returned by signal, anything they use
+ * can be recycled once is_complete returns true for that value. Replaces a
+ * fence per frame or upload with one semaphore polled without blocking.
+ */
+struct progress_type {
+	friend VCC_LIBRARY progress_type create(
+		const type::supplier<const device::device_type> &device);
+	friend VCC_LIBRARY queue::timeline_signal_semaphore signal(progress_type &progress);
+	friend VCC_LIBRARY uint64_t get_issued(const progress_type &progress);
+	friend VCC_LIBRARY uint64_t get_completed(const progress_type &progress);
+	friend VCC_LIBRARY bool is_complete(const progress_type &progress, uint64_t value);
+	friend VCC_LIBRARY void wait(const progress_type &progress, uint64_t value);
+	friend VCC_LIBRARY VkResult wait(const progress_type &progress, uint64_t value,
+		std::chrono::nanoseconds timeout);
+	friend VCC_LIBRARY queue::timeline_wait_semaphore wait_semaphore(
+		const progress_type &progress, uint64_t value, VkPipelineStageFlags wait_dst_stage_mask);
+
+	progress_type() = default;
+	progress_type(const progress_type &) = delete;
+	progress_type(progress_type &&) = default;
+	progress_type &operator=(const progress_type &) = delete;
+	progress_type &operator=(progress_type &&) = default;
+
+private:
+	progress_type(const type::supplier<const semaphore::timeline_semaphore_type> &semaphore)
+		: semaphore(semaphore), state(new internal::state_type) {}
+
+	type::supplier<const semaphore::timeline_semaphore_type> semaphore;
+	std::unique_ptr<internal::state_type> state;
+};
+
+VCC_LIBRARY progress_type create(const type::supplier<const device::device_type> &device);
+
+// Reserves the next value, to be signaled by exactly one submit. Submits
+// must signal the values in the order they were reserved.
+VCC_LIBRARY queue::timeline_signal_semaphore signal(progress_type &progress);
+
+// The last value reserved by signal.
+VCC_LIBRARY uint64_t get_issued(const progress_type &progress);
+
+VCC_LIBRARY uint64_t get_completed(const progress_type &progress);
+
+// Only asks the device if value was not already seen completed.
+VCC_LIBRARY bool is_complete(const progress_type &progress, uint64_t value);
+
+VCC_LIBRARY void wait(const progress_type &progress, uint64_t value);
+
+// Returns VK_TIMEOUT if value was not reached within timeout.
+VCC_LIBRARY VkResult wait(const progress_type &progress, uint64_t value,
+	std::chrono::nanoseconds timeout);
+
+// Makes a submit on another queue wait for value, without the host.
+VCC_LIBRARY queue::timeline_wait_semaphore wait_semaphore(const progress_type &progress,
+	uint64_t value, VkPipelineStageFlags wait_dst_stage_mask);
+
+}  // namespace progress
+}  // namespace vcc
+
+#endif // VK_KHR_timeline_semaphore
+
+#endif // _VCC_PROGRESS_H_
@@ -56,6 +56,13 @@ inline queue_type get_graphics_queue(
 		const type::supplier<const device::device_type> &device) {
 	return get_queue(device, VK_QUEUE_GRAPHICS_BIT);
 }
+// The first queue of physical_device::get_transfer_queue_family, the device
+// must have been created with a queue of that family.
+VCC_LIBRARY queue_type get_transfer_queue(
+	const type::supplier<const device::device_type> &device);
+// The first queue of physical_device::get_compute_queue_family.
+VCC_LIBRARY queue_type get_compute_queue(
+	const type::supplier<const device::device_type> &device);
 VCC_LIBRARY queue_type get_present_queue(
 	const type::supplier<const device::device_type> &device,
 	const surface::surface_type &surface);
@@ -71,7 +78,6 @@ struct wait_semaphore {
 	VkPipelineStageFlags wait_dst_stage_mask;
 };
 
-// TODO(gardell): Support multiple submits
 VCC_LIBRARY void submit(const queue_type &queue,
 	const std::vector<wait_semaphore> &wait_semaphores,
 	const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>> &command_buffers,
@@ -83,6 +89,52 @@ VCC_LIBRARY void submit(const queue_type &queue,
 	const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>> &command_buffers,
 	const std::vector<std::reference_wrapper<const semaphore::semaphore_type>> &signal_semaphores);
 
+#if defined(VK_KHR_timeline_semaphore)
+struct timeline_wait_semaphore {
+	type::supplier<const semaphore::timeline_semaphore_type> semaphore;
+	uint64_t value;
+	VkPipelineStageFlags wait_dst_stage_mask;
+};
+
+struct timeline_signal_semaphore {
+	type::supplier<const semaphore::timeline_semaphore_type> semaphore;
+	uint64_t value;
+};
+#endif // VK_KHR_timeline_semaphore
+
+// One batch of a submit, a VkSubmitInfo.
+struct submit_info_type {
+	std::vector<wait_semaphore> wait_semaphores;
+	std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>> command_buffers;
+	std::vector<std::reference_wrapper<const semaphore::semaphore_type>> signal_semaphores;
+#if defined(VK_KHR_timeline_semaphore)
+	std::vector<timeline_wait_semaphore> timeline_wait_semaphores;
+	std::vector<timeline_signal_semaphore> timeline_signal_semaphores;
+#endif // VK_KHR_timeline_semaphore
+};
+
+// Submits all batches in a single vkQueueSubmit, in order.
+VCC_LIBRARY void submit(const queue_type &queue, const std::vector<submit_info_type> &submits,
+	const fence::fence_type &fence);
+
+VCC_LIBRARY void submit(const queue_type &queue, const std::vector<submit_info_type> &submits);
+
+/*
+ * Submits command buffers recording command::release_ownership, signaling
+ * semaphore. The returned wait_semaphore goes into the submit of the
+ * matching command::acquire_ownership on the other queue, dst_stage_mask
+ * being the stages of the acquire.
+ */
+VCC_LIBRARY wait_semaphore submit_release(const queue_type &queue,
+	const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>> &command_buffers,
+	const type::supplier<const semaphore::semaphore_type> &semaphore,
+	VkPipelineStageFlags dst_stage_mask, const fence::fence_type &fence);
+
+VCC_LIBRARY wait_semaphore submit_release(const queue_type &queue,
+	const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>> &command_buffers,
+	const type::supplier<const semaphore::semaphore_type> &semaphore,
+	VkPipelineStageFlags dst_stage_mask);
+
 VCC_LIBRARY void wait_idle(const queue_type &queue);
 
 VCC_LIBRARY VkResult present(const queue_type &queue,
@@ -0,0 +1,124 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_READBACK_H_
+#define _VCC_READBACK_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <thread>
+#include <type/storage.h>
+#include <vcc/buffer.h>
+#include <vcc/device.h>
+#include <vcc/queue.h>
+#include <vcc/transient.h>
+
+namespace vcc {
+namespace readback {
+
+// Called on the readback thread with the copied bytes, which are only valid
+// during the call.
+typedef std::function<void(const void *data, VkDeviceSize size)> callback_type;
+
+namespace internal {
+
+struct pending_type {
+	transient::command_type command;
+	std::shared_ptr<buffer::buffer_type> staging;
+	VkDeviceSize size;
+	callback_type callback;
+	std::promise<void> promise;
+};
+
+struct state_type {
+	state_type() : stop(false) {}
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	// In submission order, the thread waits for the front.
+	std::deque<pending_type> pending;
+	// Staging buffers of finished reads, reused by later reads that fit.
+	std::vector<std::shared_ptr<buffer::buffer_type>> staging_buffers;
+	bool stop;
+};
+
+}  // namespace internal
+
+/*
+ * Copies device buffers into host cached staging buffers without blocking
+ * the submitting thread. A background thread waits for the copies and
+ * resolves the returned futures in submission order.
+ */
+struct readback_type {
+	friend VCC_LIBRARY readback_type create(
+		const type::supplier<const device::device_type> &device);
+	friend VCC_LIBRARY std::future<void> read(readback_type &readback,
+		const queue::queue_type &queue, const type::supplier<const buffer::buffer_type> &buffer,
+		VkDeviceSize offset, VkDeviceSize size, const callback_type &callback);
+
+	readback_type() = default;
+	readback_type(const readback_type &) = delete;
+	readback_type(readback_type &&) = default;
+	readback_type &operator=(const readback_type &) = delete;
+	readback_type &operator=(readback_type &&) = delete;
+
+	// Blocks until all pending reads have completed.
+	VCC_LIBRARY ~readback_type();
+
+private:
+	readback_type(const type::supplier<const device::device_type> &device,
+		std::unique_ptr<internal::state_type> &&state, std::thread &&thread)
+		: device(device), state(std::move(state)), thread(std::move(thread)) {}
+
+	type::supplier<const device::device_type> device;
+	std::unique_ptr<internal::state_type> state;
+	std::thread thread;
+};
+
+VCC_LIBRARY readback_type create(const type::supplier<const device::device_type> &device);
+
+/*
+ * Records and submits a copy of size bytes at offset in buffer, which must
+ * have been created with VK_BUFFER_USAGE_TRANSFER_SRC_BIT. Writes made by
+ * earlier submissions to the same queue are visible to the copy.
+ */
+VCC_LIBRARY std::future<void> read(readback_type &readback, const queue::queue_type &queue,
+	const type::supplier<const buffer::buffer_type> &buffer, VkDeviceSize offset,
+	VkDeviceSize size, const callback_type &callback);
+
+/*
+ * Reads into every element of a type::t_array, bumping its revision. The
+ * buffer must hold the elements tightly packed, as std430 does for scalars
+ * and vec4.
+ */
+template<typename StorageT>
+std::future<void> read(readback_type &readback, const queue::queue_type &queue,
+		const type::supplier<const buffer::buffer_type> &buffer, VkDeviceSize offset,
+		StorageT &&storage) {
+	const auto array(type::make_supplier(std::forward<StorageT>(storage)));
+	typedef typename std::remove_reference<decltype(*array)>::type::value_type value_type;
+	return read(readback, queue, buffer, offset, array->size() * sizeof(value_type),
+		[array](const void *data, VkDeviceSize size) {
+			const auto mutate(type::write(*array));
+			std::copy_n(static_cast<const value_type *>(data), mutate.size(), mutate.begin());
+		});
+}
+
+}  // namespace readback
+}  // namespace vcc
+
+#endif // _VCC_READBACK_H_
@@ -16,6 +16,7 @@
 #ifndef SEMAPHORE_H_
 #define SEMAPHORE_H_
 
+#include <chrono>
 #include <vcc/device.h>
 
 namespace vcc {
@@ -38,6 +39,75 @@ private:
 
 VCC_LIBRARY semaphore_type create(const type::supplier<const device::device_type> &device);
 
+#if defined(VK_KHR_timeline_semaphore)
+
+struct timeline_semaphore_type;
+
+struct timeline_value_type {
+	std::reference_wrapper<const timeline_semaphore_type> semaphore;
+	uint64_t value;
+};
+
+/*
+ * A semaphore whose 64-bit counter only increases, signaled and waited for
+ * with values by queue submits and the host. Unlike binary semaphores, any
+ * number of submits and threads may wait for a value, even before the
+ * submit signaling it. The device must enable VK_KHR_timeline_semaphore and
+ * its timelineSemaphore feature, chained through device::create's next.
+ * Presents still need binary semaphores.
+ */
+struct timeline_semaphore_type : internal::movable_destructible_with_parent<VkSemaphore,
+		const device::device_type, vkDestroySemaphore> {
+	friend VCC_LIBRARY timeline_semaphore_type create_timeline(
+		const type::supplier<const device::device_type> &device, uint64_t initial_value);
+	friend VCC_LIBRARY uint64_t get_value(const timeline_semaphore_type &semaphore);
+	friend VCC_LIBRARY void signal(const timeline_semaphore_type &semaphore, uint64_t value);
+	friend VCC_LIBRARY VkResult wait(const std::vector<timeline_value_type> &values,
+		bool wait_all, std::chrono::nanoseconds timeout);
+
+	timeline_semaphore_type() = default;
+	timeline_semaphore_type(timeline_semaphore_type &&) = default;
+	timeline_semaphore_type(const timeline_semaphore_type &) = delete;
+	timeline_semaphore_type &operator=(timeline_semaphore_type &&) = default;
+	timeline_semaphore_type &operator=(const timeline_semaphore_type &) = delete;
+
+private:
+	timeline_semaphore_type(VkSemaphore instance,
+		const type::supplier<const device::device_type> &parent,
+		PFN_vkGetSemaphoreCounterValueKHR get_counter_value,
+		PFN_vkWaitSemaphoresKHR wait_semaphores, PFN_vkSignalSemaphoreKHR signal_semaphore)
+		: movable_destructible_with_parent(instance, parent),
+		get_counter_value(get_counter_value), wait_semaphores(wait_semaphores),
+		signal_semaphore(signal_semaphore) {}
+
+	// Extension functions, loaded by create_timeline.
+	PFN_vkGetSemaphoreCounterValueKHR get_counter_value;
+	PFN_vkWaitSemaphoresKHR wait_semaphores;
+	PFN_vkSignalSemaphoreKHR signal_semaphore;
+};
+
+VCC_LIBRARY timeline_semaphore_type create_timeline(
+	const type::supplier<const device::device_type> &device, uint64_t initial_value = 0);
+
+// The value of the last signal the device or host has completed.
+VCC_LIBRARY uint64_t get_value(const timeline_semaphore_type &semaphore);
+
+// Signals value from the host, it must be greater than the current value.
+VCC_LIBRARY void signal(const timeline_semaphore_type &semaphore, uint64_t value);
+
+// Waits until all, or any, of the semaphores reached their values. All
+// semaphores must belong to the same device.
+VCC_LIBRARY VkResult wait(const std::vector<timeline_value_type> &values, bool wait_all,
+	std::chrono::nanoseconds timeout);
+
+VCC_LIBRARY VkResult wait(const std::vector<timeline_value_type> &values, bool wait_all);
+
+inline VkResult wait(const timeline_semaphore_type &semaphore, uint64_t value) {
+	return wait({ timeline_value_type{ std::cref(semaphore), value } }, true);
+}
+
+#endif // VK_KHR_timeline_semaphore
+
 }  // namespace semaphore
 }  // namespace vcc
 
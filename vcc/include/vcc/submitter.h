@@ -0,0 +1,134 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_SUBMITTER_H_
+#define _VCC_SUBMITTER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vcc/queue.h>
+
+namespace vcc {
+namespace submitter {
+
+// Called on the submission thread with the result of vkQueuePresentKHR.
+typedef std::function<void(VkResult result)> present_callback_type;
+
+namespace internal {
+
+struct submission_type {
+	std::vector<queue::wait_semaphore> wait_semaphores;
+	std::vector<type::supplier<const command_buffer::command_buffer_type>> command_buffers;
+	std::vector<type::supplier<const semaphore::semaphore_type>> signal_semaphores;
+	type::supplier<const fence::fence_type> fence;
+	// Set for presents, which wait for semaphores and end the current batch.
+	std::vector<type::supplier<const semaphore::semaphore_type>> present_semaphores;
+	std::vector<type::supplier<const swapchain::swapchain_type>> swapchains;
+	std::vector<uint32_t> image_indices;
+	present_callback_type present_callback;
+	submission_type *next;
+};
+
+struct state_type {
+	state_type() : head(nullptr), enqueued(0), failed(false), stop(false), completed(0) {}
+
+	// Producers push onto head with a compare and swap, the submission thread
+	// takes the whole list with an exchange, so no submission is popped twice.
+	std::atomic<submission_type *> head;
+	std::atomic<uint64_t> enqueued;
+	// Lets producers check for an exception without taking the mutex.
+	std::atomic<bool> failed;
+	// Only taken to sleep and wake the submission thread, and to wait.
+	std::mutex mutex;
+	std::condition_variable wake, idle;
+	bool stop;
+	uint64_t completed;
+	std::exception_ptr exception;
+};
+
+}  // namespace internal
+
+/*
+ * Owns a thread submitting to a queue on behalf of others. Submitting only
+ * pushes onto a lock-free list, recording threads never wait for the queue
+ * mutex or the driver. The thread submits everything pushed since it last
+ * woke up in a single vkQueueSubmit, split at fences and presents.
+ */
+struct submitter_type {
+	friend VCC_LIBRARY submitter_type create(
+		const type::supplier<const queue::queue_type> &queue);
+	friend VCC_LIBRARY void submit(submitter_type &submitter,
+		const std::vector<queue::wait_semaphore> &wait_semaphores,
+		const std::vector<type::supplier<const command_buffer::command_buffer_type>> &command_buffers,
+		const std::vector<type::supplier<const semaphore::semaphore_type>> &signal_semaphores,
+		const type::supplier<const fence::fence_type> &fence);
+	friend VCC_LIBRARY void present(submitter_type &submitter,
+		const std::vector<type::supplier<const semaphore::semaphore_type>> &semaphores,
+		const std::vector<type::supplier<const swapchain::swapchain_type>> &swapchains,
+		const std::vector<uint32_t> &image_indices, const present_callback_type &callback);
+	friend VCC_LIBRARY void wait(submitter_type &submitter);
+
+	submitter_type() = default;
+	submitter_type(const submitter_type &) = delete;
+	submitter_type(submitter_type &&) = default;
+	submitter_type &operator=(const submitter_type &) = delete;
+	submitter_type &operator=(submitter_type &&) = delete;
+
+	// Submits whatever is still pushed before joining the thread.
+	VCC_LIBRARY ~submitter_type();
+
+private:
+	submitter_type(std::unique_ptr<internal::state_type> &&state, std::thread &&thread)
+		: state(std::move(state)), thread(std::move(thread)) {}
+
+	std::unique_ptr<internal::state_type> state;
+	std::thread thread;
+};
+
+VCC_LIBRARY submitter_type create(const type::supplier<const queue::queue_type> &queue);
+
+/*
+ * Like queue::submit, but returns before the command buffers are submitted.
+ * Submits are made in the order they are pushed, the objects are kept alive
+ * until vkQueueSubmit returns. Rethrows the exception of a failed earlier
+ * submit, if any.
+ */
+VCC_LIBRARY void submit(submitter_type &submitter,
+	const std::vector<queue::wait_semaphore> &wait_semaphores,
+	const std::vector<type::supplier<const command_buffer::command_buffer_type>> &command_buffers,
+	const std::vector<type::supplier<const semaphore::semaphore_type>> &signal_semaphores,
+	const type::supplier<const fence::fence_type> &fence =
+		type::supplier<const fence::fence_type>());
+
+// Presents after the submits pushed before it, a present made directly on
+// the queue could be made before the submit signaling its semaphores.
+VCC_LIBRARY void present(submitter_type &submitter,
+	const std::vector<type::supplier<const semaphore::semaphore_type>> &semaphores,
+	const std::vector<type::supplier<const swapchain::swapchain_type>> &swapchains,
+	const std::vector<uint32_t> &image_indices,
+	const present_callback_type &callback = present_callback_type());
+
+// Blocks until everything pushed so far is submitted, rethrowing the
+// exception of a failed submit, if any.
+VCC_LIBRARY void wait(submitter_type &submitter);
+
+}  // namespace submitter
+}  // namespace vcc
+
+#endif // _VCC_SUBMITTER_H_
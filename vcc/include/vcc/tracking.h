@@ -0,0 +1,151 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_TRACKING_H_
+#define _VCC_TRACKING_H_
+
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vcc/util.h>
+
+namespace vcc {
+namespace tracking {
+
+enum mode_type {
+	// Records the barriers needed before every tracked command.
+	automatic,
+	// Records no barriers, reports the ones missing before tracked commands.
+	validate
+};
+
+// Called with a description of a missing, redundant or unrecordable barrier.
+typedef std::function<void(const std::string &message)> report_callback_type;
+
+namespace internal {
+
+// What the last accesses of a buffer range or image subresource were, and
+// which later accesses are already ordered after them.
+struct access_state_type {
+	// The last write, cleared stages mean no write since tracking started.
+	VkPipelineStageFlags write_stages;
+	VkAccessFlags write_access;
+	// Reads since the last write.
+	VkPipelineStageFlags read_stages;
+	// Where the last write is visible.
+	VkPipelineStageFlags visible_stages;
+	VkAccessFlags visible_access;
+	// Stages ordered after the last write and all reads since.
+	VkPipelineStageFlags ordered_stages;
+	VkImageLayout layout;
+};
+
+struct buffer_piece_type {
+	VkDeviceSize end;
+	access_state_type state;
+};
+
+struct image_state_type {
+	uint32_t mip_levels, array_layers;
+	// Indexed by mip level * array_layers + array layer.
+	std::vector<access_state_type> subresources;
+};
+
+/*
+ * Buffers are tracked per byte range, split where accesses begin and end.
+ * Images are tracked per mip level and array layer, aspects share state.
+ * Nothing is known about accesses made before the recording, buffers are
+ * assumed idle and images in VK_IMAGE_LAYOUT_UNDEFINED until declared.
+ */
+struct tracker_type {
+	tracker_type(mode_type mode, const report_callback_type &report)
+		: mode(mode), report(report), render_pass(false), src_stages(0), dst_stages(0),
+		src_access(0), dst_access(0) {}
+
+	mode_type mode;
+	report_callback_type report;
+	// Barriers can not be recorded inside a render pass.
+	bool render_pass;
+	std::unordered_map<VkBuffer, std::map<VkDeviceSize, buffer_piece_type>> buffers;
+	std::unordered_map<VkImage, image_state_type> images;
+	// The barrier needed before the next command. Buffers share one
+	// VkMemoryBarrier, cheaper for drivers than one per buffer.
+	VkPipelineStageFlags src_stages, dst_stages;
+	VkAccessFlags src_access, dst_access;
+	std::vector<VkImageMemoryBarrier> image_barriers;
+};
+
+// Records a barrier from src to dst on state, returning whether it orders or
+// makes visible anything that was not already.
+VCC_LIBRARY bool apply(access_state_type &state, VkPipelineStageFlags src_stages,
+	VkPipelineStageFlags dst_stages, VkAccessFlags src_access, VkAccessFlags dst_access);
+
+// Updates state for the access and returns whether a barrier is needed
+// before it, adding its masks to src_stages, src_access and dst_access.
+// Write after read only needs an execution dependency, no access masks.
+VCC_LIBRARY bool prepare(access_state_type &state, VkPipelineStageFlags stage,
+	VkAccessFlags access, VkImageLayout layout, VkPipelineStageFlags &src_stages,
+	VkAccessFlags &src_access, VkAccessFlags &dst_access);
+
+// Splits the piece containing offset, so a piece begins at offset.
+VCC_LIBRARY void split(std::map<VkDeviceSize, buffer_piece_type> &pieces, VkDeviceSize offset);
+
+// Merges the pieces with equal state overlapping [offset, end].
+VCC_LIBRARY void merge(std::map<VkDeviceSize, buffer_piece_type> &pieces, VkDeviceSize offset,
+	VkDeviceSize end);
+
+// Merges per subresource barriers into ranges, first along array layers
+// then along mip levels.
+VCC_LIBRARY void merge(std::vector<VkImageMemoryBarrier> &barriers);
+
+// Adds the barrier needed before accessing size bytes at offset to the
+// pending barrier. buffer_size resolves VK_WHOLE_SIZE.
+VCC_LIBRARY void access(tracker_type &tracker, VkBuffer buffer, VkDeviceSize buffer_size,
+	VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags stage, VkAccessFlags access);
+
+// Adds the barrier, and layout transition, needed before accessing range in
+// layout to the pending barrier.
+VCC_LIBRARY void access(tracker_type &tracker, VkImage image, uint32_t mip_levels,
+	uint32_t array_layers, const VkImageSubresourceRange &range, VkPipelineStageFlags stage,
+	VkAccessFlags access, VkImageLayout layout);
+
+// Sets the state of range as if written at stage, without a barrier.
+VCC_LIBRARY void declare(tracker_type &tracker, VkImage image, uint32_t mip_levels,
+	uint32_t array_layers, const VkImageSubresourceRange &range, VkPipelineStageFlags stage,
+	VkAccessFlags access, VkImageLayout layout);
+
+// Apply a barrier recorded by the user, returning whether it orders or
+// makes visible any tracked access not already ordered or visible.
+VCC_LIBRARY bool barrier(tracker_type &tracker, VkPipelineStageFlags src_stages,
+	VkPipelineStageFlags dst_stages, const VkMemoryBarrier &barrier);
+VCC_LIBRARY bool barrier(tracker_type &tracker, VkPipelineStageFlags src_stages,
+	VkPipelineStageFlags dst_stages, VkDeviceSize buffer_size,
+	const VkBufferMemoryBarrier &barrier);
+VCC_LIBRARY bool barrier(tracker_type &tracker, VkPipelineStageFlags src_stages,
+	VkPipelineStageFlags dst_stages, uint32_t mip_levels, uint32_t array_layers,
+	const VkImageMemoryBarrier &barrier);
+
+// Records the pending barrier, or reports it in validate mode and inside
+// render passes, before the command named command.
+VCC_LIBRARY void flush(tracker_type &tracker, VkCommandBuffer command_buffer,
+	const char *command);
+
+}  // namespace internal
+}  // namespace tracking
+}  // namespace vcc
+
+#endif // _VCC_TRACKING_H_
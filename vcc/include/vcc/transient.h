@@ -0,0 +1,133 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_TRANSIENT_H_
+#define _VCC_TRANSIENT_H_
+
+#include <map>
+#include <thread>
+#include <vcc/command_buffer.h>
+#include <vcc/command_pool.h>
+#include <vcc/device.h>
+#include <vcc/fence.h>
+#include <vcc/queue.h>
+#include <vcc/semaphore.h>
+
+namespace vcc {
+namespace transient {
+namespace internal {
+
+// Command pools are externally synchronized, so every thread gets its own
+// pool per queue family. The pools are created lazily with a reference to
+// the device, which can not be moved after the first use. A pool is
+// released when its thread exits, or once its last borrowed command
+// buffer is returned if any is still out.
+struct thread_pool_type {
+	thread_pool_type(command_pool::command_pool_type &&command_pool)
+		: command_pool(std::move(command_pool)), borrowed(0), orphaned(false) {}
+
+	command_pool::command_pool_type command_pool;
+	std::vector<command_buffer::command_buffer_type> command_buffers;
+	std::size_t borrowed;
+	// The thread exited while command buffers were borrowed.
+	bool orphaned;
+};
+
+struct device_pool_type {
+	device_pool_type() : used(false) {}
+
+	std::mutex mutex;
+	std::map<std::pair<std::thread::id, uint32_t>, thread_pool_type> thread_pools;
+	std::vector<fence::fence_type> fences;
+	std::vector<semaphore::semaphore_type> semaphores;
+	// Set once anything refers to the device, which can not be moved then.
+	bool used;
+};
+
+// Releases the pools of a thread on every device it used, when it exits.
+struct thread_exit_type {
+	VCC_LIBRARY ~thread_exit_type();
+
+	std::vector<std::weak_ptr<device_pool_type>> device_pools;
+};
+
+}  // namespace internal
+
+// A one time command buffer and a fence borrowed from the calling thread's
+// transient command pool. Both are returned to the device on destruction.
+// Must be recorded on the thread that acquired it.
+struct command_type {
+	friend VCC_LIBRARY command_type acquire(const device::device_type &device,
+		uint32_t queue_family_index);
+	friend command_buffer::command_buffer_type &get_command_buffer(command_type &command);
+	friend const fence::fence_type &get_fence(const command_type &command);
+	friend VCC_LIBRARY void submit_and_wait(const queue::queue_type &queue,
+		const command_type &command);
+
+	command_type() = default;
+	command_type(const command_type &) = delete;
+	command_type(command_type &&) = default;
+	command_type &operator=(const command_type &) = delete;
+	command_type &operator=(command_type &&) = default;
+
+	VCC_LIBRARY ~command_type();
+
+private:
+	command_type(const device::device_type &device, uint32_t queue_family_index,
+			command_buffer::command_buffer_type &&command_buffer, fence::fence_type &&fence)
+		: device(&device), thread_id(std::this_thread::get_id())
+		, queue_family_index(queue_family_index)
+		, command_buffer(std::move(command_buffer)), fence(std::move(fence))
+		, fence_pending(false) {}
+
+	const device::device_type *device;
+	std::thread::id thread_id;
+	uint32_t queue_family_index;
+	command_buffer::command_buffer_type command_buffer;
+	fence::fence_type fence;
+	// Set when submit_and_wait failed, the fence is not recycled then.
+	mutable bool fence_pending;
+};
+
+VCC_LIBRARY command_type acquire(const device::device_type &device,
+	uint32_t queue_family_index);
+
+inline command_type acquire(const queue::queue_type &queue) {
+	return acquire(*vcc::internal::get_parent(queue), queue::get_family_index(queue));
+}
+
+inline command_buffer::command_buffer_type &get_command_buffer(command_type &command) {
+	return command.command_buffer;
+}
+
+// Signaled once a submission of the command has finished executing, it must be
+// reset before the command is submitted again or destroyed.
+inline const fence::fence_type &get_fence(const command_type &command) {
+	return command.fence;
+}
+
+// Submits the recorded command buffer and blocks until it has finished executing.
+// The command may be recorded and submitted again afterwards.
+VCC_LIBRARY void submit_and_wait(const queue::queue_type &queue, const command_type &command);
+
+// Semaphores must be unsignaled and have no pending operations when recycled.
+VCC_LIBRARY semaphore::semaphore_type acquire_semaphore(const device::device_type &device);
+VCC_LIBRARY void recycle(const device::device_type &device,
+	semaphore::semaphore_type &&semaphore);
+
+}  // namespace transient
+}  // namespace vcc
+
+#endif // _VCC_TRANSIENT_H_
@@ -0,0 +1,112 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VCC_UNIFORM_ALLOCATOR_H_
+#define _VCC_UNIFORM_ALLOCATOR_H_
+
+#include <atomic>
+#include <vcc/memory.h>
+#include <vcc/progress.h>
+
+namespace vcc {
+namespace uniform_allocator {
+
+struct uniform_allocator_type;
+
+namespace internal {
+
+struct state_type {
+	state_type() : offset(0) {}
+
+	// Where the next allocation starts, a multiple of the alignment.
+	std::atomic<VkDeviceSize> offset;
+};
+
+// Serializes into the next free slot, returning its offset.
+VCC_LIBRARY uint32_t write(uniform_allocator_type &allocator,
+	const type::serialize_type &serialize);
+
+}  // namespace internal
+
+/*
+ * Packs the uniforms of many draws into one host visible buffer bound as
+ * VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, each draw passing the offset of
+ * its uniforms in bind_descriptor_sets::dynamic_offsets instead of using a
+ * descriptor set and input_buffer of its own. Allocations are linear and
+ * freed all at once by reset, use one allocator per frame in flight.
+ */
+struct uniform_allocator_type {
+	friend VCC_LIBRARY uniform_allocator_type create(
+		const type::supplier<const device::device_type> &device, VkDeviceSize size);
+	friend VCC_LIBRARY uint32_t internal::write(uniform_allocator_type &allocator,
+		const type::serialize_type &serialize);
+	friend VCC_LIBRARY const type::supplier<const buffer::buffer_type> &get_buffer(
+		const uniform_allocator_type &allocator);
+	friend VCC_LIBRARY void reset(uniform_allocator_type &allocator);
+
+	uniform_allocator_type() = default;
+	uniform_allocator_type(const uniform_allocator_type &) = delete;
+	uniform_allocator_type(uniform_allocator_type &&) = default;
+	uniform_allocator_type &operator=(const uniform_allocator_type &) = delete;
+	uniform_allocator_type &operator=(uniform_allocator_type &&) = default;
+
+private:
+	uniform_allocator_type(const type::supplier<const buffer::buffer_type> &buffer,
+		VkDeviceSize size, VkDeviceSize alignment)
+		: buffer(buffer), size(size), alignment(alignment),
+		state(new internal::state_type()) {}
+
+	type::supplier<const buffer::buffer_type> buffer;
+	VkDeviceSize size;
+	// minUniformBufferOffsetAlignment of the device.
+	VkDeviceSize alignment;
+	std::unique_ptr<internal::state_type> state;
+};
+
+// An allocator of size bytes of memory::cpu_to_gpu memory.
+VCC_LIBRARY uniform_allocator_type create(
+	const type::supplier<const device::device_type> &device, VkDeviceSize size);
+
+// Serializes the storages, like those of input_buffer::create, into an
+// aligned slot of the buffer and returns the dynamic offset of the slot.
+// Thread safe, throws if the buffer is full.
+template<type::memory_layout Layout = type::linear_std140, typename... StorageType>
+uint32_t allocate(uniform_allocator_type &allocator, StorageType... storages) {
+	return internal::write(allocator, type::make_serialize<Layout>(
+		type::make_supplier(std::forward<StorageType>(storages))...));
+}
+
+// The buffer to write to the descriptor set once, with a range of the
+// largest uniforms allocated.
+VCC_LIBRARY const type::supplier<const buffer::buffer_type> &get_buffer(
+	const uniform_allocator_type &allocator);
+
+// Frees every allocation. The device must be done with the command buffers
+// using them, and no allocate may run concurrently.
+VCC_LIBRARY void reset(uniform_allocator_type &allocator);
+
+#if defined(VK_KHR_timeline_semaphore)
+
+// Like reset, once progress reached value, the value signaled by the last
+// submit using the allocations. Blocks until then.
+VCC_LIBRARY void reset(uniform_allocator_type &allocator,
+	const progress::progress_type &progress, uint64_t value);
+
+#endif // VK_KHR_timeline_semaphore
+
+}  // namespace uniform_allocator
+}  // namespace vcc
+
+#endif // _VCC_UNIFORM_ALLOCATOR_H_
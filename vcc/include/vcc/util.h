@@ -66,12 +66,21 @@ struct tuple_foreach_type {
 		tuple_foreach_type<N - 1>::call(functor, args);
 		functor(std::get<N - 1>(args));
 	}
+
+	template<typename FunctorT, typename... Args>
+	static void call(FunctorT &functor, const std::tuple<Args...> &args) {
+		tuple_foreach_type<N - 1>::call(functor, args);
+		functor(std::get<N - 1>(args));
+	}
 };
 
 template<>
 struct tuple_foreach_type<0> {
 	template<typename FunctorT, typename... Args>
 	static void call(FunctorT &, std::tuple<Args...> &) {}
+
+	template<typename FunctorT, typename... Args>
+	static void call(FunctorT &, const std::tuple<Args...> &) {}
 };
 
 template<typename FunctorT, typename... Args>
@@ -79,6 +88,11 @@ void tuple_foreach(FunctorT functor, std::tuple<Args...> &commands) {
 	tuple_foreach_type<sizeof...(Args)>::call(functor, commands);
 }
 
+template<typename FunctorT, typename... Args>
+void tuple_foreach(FunctorT functor, const std::tuple<Args...> &commands) {
+	tuple_foreach_type<sizeof...(Args)>::call(functor, commands);
+}
+
 VCC_LIBRARY std::vector<const char *> to_pointers(const std::vector<std::string> &vector);
 VCC_LIBRARY std::vector<const char *> to_pointers(const std::set<std::string> &set);
 
@@ -23,7 +23,6 @@
 #include <condition_variable>
 #include <thread>
 #include <vector>
-#include <vcc/command_pool.h>
 #include <vcc/device.h>
 #include <vcc/image.h>
 #include <vcc/image_view.h>
@@ -185,7 +184,6 @@ private:
 	queue::queue_type present_queue;
 	VkFormat format;
 	VkColorSpaceKHR color_space;
-	command_pool::command_pool_type cmd_pool;
 };
 
 VCC_LIBRARY window_type create(
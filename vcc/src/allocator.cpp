@@ -0,0 +1,194 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vcc/allocator.h>
+
+namespace vcc {
+namespace allocator {
+
+namespace internal {
+
+// Placed right before every block handed to the driver.
+struct header_type {
+	void *raw;
+	std::size_t size;
+	uint32_t size_class, scope;
+};
+
+const uint32_t no_size_class = ~0u;
+// Alignment of recycled blocks, larger alignments are never recycled.
+const std::size_t size_class_alignment = 64;
+
+uint32_t get_size_class(std::size_t size, std::size_t alignment) {
+	if (alignment > size_class_alignment) {
+		return no_size_class;
+	}
+	for (uint32_t size_class = 0; size_class < size_class_count; ++size_class) {
+		if (size <= std::size_t(1) << (size_class + min_size_class_shift)) {
+			return size_class;
+		}
+	}
+	return no_size_class;
+}
+
+header_type &get_header(void *memory) {
+	return *(static_cast<header_type *>(memory) - 1);
+}
+
+void count_allocation(scope_counters_type &counters, std::size_t size) {
+	const std::size_t bytes(counters.bytes += size);
+	++counters.allocations;
+	std::size_t peak_bytes(counters.peak_bytes);
+	while (bytes > peak_bytes && !counters.peak_bytes.compare_exchange_weak(peak_bytes, bytes));
+}
+
+void count_free(scope_counters_type &counters, std::size_t size) {
+	counters.bytes -= size;
+	--counters.allocations;
+}
+
+void *system_allocate(std::size_t capacity, std::size_t alignment) {
+	if (alignment < alignof(header_type)) {
+		alignment = alignof(header_type);
+	}
+	void *const raw(std::malloc(capacity + alignment + sizeof(header_type)));
+	if (!raw) {
+		return nullptr;
+	}
+	const std::uintptr_t begin(reinterpret_cast<std::uintptr_t>(raw) + sizeof(header_type));
+	void *const memory(reinterpret_cast<void *>(
+		begin + (alignment - begin % alignment) % alignment));
+	get_header(memory).raw = raw;
+	return memory;
+}
+
+void *VKAPI_PTR allocation(void *user_data, std::size_t size, std::size_t alignment,
+		VkSystemAllocationScope scope) {
+	heap_type &heap(*static_cast<heap_type *>(user_data));
+	const uint32_t size_class(get_size_class(size, alignment));
+	void *memory(nullptr);
+	if (size_class != no_size_class) {
+		size_class_type &blocks(heap.size_classes[size_class]);
+		std::lock_guard<std::mutex> lock(blocks.mutex);
+		if (!blocks.blocks.empty()) {
+			memory = blocks.blocks.back();
+			blocks.blocks.pop_back();
+		}
+	}
+	if (!memory) {
+		memory = size_class != no_size_class
+			? system_allocate(std::size_t(1) << (size_class + min_size_class_shift),
+				size_class_alignment)
+			: system_allocate(size, alignment);
+		if (!memory) {
+			return nullptr;
+		}
+	}
+	header_type &header(get_header(memory));
+	header.size = size;
+	header.size_class = size_class;
+	header.scope = scope;
+	count_allocation(heap.scopes[scope], size);
+	return memory;
+}
+
+void VKAPI_PTR deallocate(void *user_data, void *memory) {
+	if (!memory) {
+		return;
+	}
+	heap_type &heap(*static_cast<heap_type *>(user_data));
+	const header_type &header(get_header(memory));
+	count_free(heap.scopes[header.scope], header.size);
+	if (header.size_class != no_size_class) {
+		size_class_type &blocks(heap.size_classes[header.size_class]);
+		std::lock_guard<std::mutex> lock(blocks.mutex);
+		blocks.blocks.push_back(memory);
+	} else {
+		std::free(header.raw);
+	}
+}
+
+void *VKAPI_PTR reallocation(void *user_data, void *original, std::size_t size,
+		std::size_t alignment, VkSystemAllocationScope scope) {
+	if (!original) {
+		return allocation(user_data, size, alignment, scope);
+	}
+	if (!size) {
+		deallocate(user_data, original);
+		return nullptr;
+	}
+	heap_type &heap(*static_cast<heap_type *>(user_data));
+	header_type &header(get_header(original));
+	// Grow or shrink in place while the block's size class still fits.
+	if (header.size_class != no_size_class && alignment <= size_class_alignment
+			&& size <= std::size_t(1) << (header.size_class + min_size_class_shift)) {
+		count_free(heap.scopes[header.scope], header.size);
+		header.size = size;
+		header.scope = scope;
+		count_allocation(heap.scopes[scope], size);
+		return original;
+	}
+	void *const memory(allocation(user_data, size, alignment, scope));
+	if (memory) {
+		std::memcpy(memory, original, header.size < size ? header.size : size);
+		deallocate(user_data, original);
+	}
+	return memory;
+}
+
+void VKAPI_PTR internal_allocation(void *user_data, std::size_t size,
+		VkInternalAllocationType allocation_type, VkSystemAllocationScope scope) {
+	static_cast<heap_type *>(user_data)->scopes[scope].internal_bytes += size;
+}
+
+void VKAPI_PTR internal_free(void *user_data, std::size_t size,
+		VkInternalAllocationType allocation_type, VkSystemAllocationScope scope) {
+	static_cast<heap_type *>(user_data)->scopes[scope].internal_bytes -= size;
+}
+
+}  // namespace internal
+
+allocator_type::allocator_type() {
+	callbacks.pUserData = &heap;
+	callbacks.pfnAllocation = &internal::allocation;
+	callbacks.pfnReallocation = &internal::reallocation;
+	callbacks.pfnFree = &internal::deallocate;
+	callbacks.pfnInternalAllocation = &internal::internal_allocation;
+	callbacks.pfnInternalFree = &internal::internal_free;
+}
+
+allocator_type::~allocator_type() {
+	for (internal::size_class_type &size_class : heap.size_classes) {
+		for (void *memory : size_class.blocks) {
+			std::free(internal::get_header(memory).raw);
+		}
+	}
+}
+
+statistics_type statistics(const allocator_type &allocator) {
+	statistics_type statistics;
+	for (std::size_t scope = 0; scope < statistics.size(); ++scope) {
+		const internal::scope_counters_type &counters(allocator.heap.scopes[scope]);
+		statistics[scope] = scope_statistics_type{ counters.bytes, counters.peak_bytes,
+			counters.allocations, counters.internal_bytes };
+	}
+	return statistics;
+}
+
+}  // namespace allocator
+}  // namespace vcc
@@ -0,0 +1,126 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <vcc/bindless.h>
+
+namespace vcc {
+namespace bindless {
+
+#if defined(VK_EXT_descriptor_indexing)
+
+namespace internal {
+
+uint32_t acquire(slot_allocator_type &slots) {
+	if (!slots.released.empty()) {
+		const uint32_t slot(slots.released.back());
+		slots.released.pop_back();
+		slots.live[slot] = true;
+		return slot;
+	}
+	if (slots.next == slots.capacity) {
+		throw vcc_exception("all bindless slots are in use");
+	}
+	slots.live[slots.next] = true;
+	return slots.next++;
+}
+
+void release(slot_allocator_type &slots, uint32_t slot) {
+	if (slot >= slots.capacity || !slots.live[slot]) {
+		throw vcc_exception("the bindless slot is not in use");
+	}
+	slots.live[slot] = false;
+	slots.released.push_back(slot);
+}
+
+}  // namespace internal
+
+bindless_type create(const type::supplier<const device::device_type> &device,
+		uint32_t max_images, uint32_t max_buffers, VkShaderStageFlags stages) {
+	const VkDescriptorBindingFlagsEXT binding_flags(
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
+		| VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+		| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT);
+	const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> layout(
+		std::make_shared<descriptor_set_layout::descriptor_set_layout_type>(
+			descriptor_set_layout::create(device, {
+				descriptor_set_layout::descriptor_set_layout_binding{ image_binding,
+					VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, max_images, stages, {} },
+				descriptor_set_layout::descriptor_set_layout_binding{ buffer_binding,
+					VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, max_buffers, stages, {} } },
+				VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT,
+				{ binding_flags, binding_flags })));
+	const type::supplier<const descriptor_pool::descriptor_pool_type> pool(
+		std::make_shared<descriptor_pool::descriptor_pool_type>(descriptor_pool::create(
+			device, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT, 1,
+			descriptor_set_layout::internal::get_pool_sizes(*layout))));
+	const std::shared_ptr<descriptor_set::descriptor_set_type> descriptor_set(
+		std::make_shared<descriptor_set::descriptor_set_type>(std::move(
+			descriptor_set::create(device, pool, { layout }).front())));
+	return bindless_type(device, layout, descriptor_set,
+		std::unique_ptr<internal::state_type>(
+			new internal::state_type(max_images, max_buffers)));
+}
+
+const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &get_layout(
+		const bindless_type &bindless) {
+	return bindless.layout;
+}
+
+uint32_t add_image(bindless_type &bindless,
+		const type::supplier<const image_view::image_view_type> &image_view,
+		VkImageLayout image_layout) {
+	std::lock_guard<std::mutex> lock(bindless.state->mutex);
+	const uint32_t slot(internal::acquire(bindless.state->images));
+	descriptor_set::update(*bindless.device, descriptor_set::write_image{
+		*bindless.descriptor_set, image_binding, slot, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+		{ descriptor_set::image_info{ {}, image_view, image_layout } } });
+	return slot;
+}
+
+uint32_t add_buffer(bindless_type &bindless,
+		const type::supplier<const buffer::buffer_type> &buffer, VkDeviceSize offset,
+		VkDeviceSize range) {
+	std::lock_guard<std::mutex> lock(bindless.state->mutex);
+	const uint32_t slot(internal::acquire(bindless.state->buffers));
+	descriptor_set::update(*bindless.device, descriptor_set::write_buffer(
+		*bindless.descriptor_set, buffer_binding, slot, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		{ descriptor_set::buffer_info(buffer, offset, range) }));
+	return slot;
+}
+
+void remove_image(bindless_type &bindless, uint32_t slot) {
+	std::lock_guard<std::mutex> lock(bindless.state->mutex);
+	internal::release(bindless.state->images, slot);
+	bindless.descriptor_set->references.erase(std::make_pair(image_binding, slot));
+}
+
+void remove_buffer(bindless_type &bindless, uint32_t slot) {
+	std::lock_guard<std::mutex> lock(bindless.state->mutex);
+	internal::release(bindless.state->buffers, slot);
+	bindless.descriptor_set->references.erase(std::make_pair(buffer_binding, slot));
+}
+
+command::bind_descriptor_sets bind(const bindless_type &bindless,
+		VkPipelineBindPoint pipeline_bind_point,
+		const type::supplier<const pipeline_layout::pipeline_layout_type> &layout,
+		uint32_t set) {
+	return command::bind_descriptor_sets{ pipeline_bind_point, layout, set,
+		{ bindless.descriptor_set }, {} };
+}
+
+#endif // VK_EXT_descriptor_indexing
+
+}  // namespace bindless
+}  // namespace vcc
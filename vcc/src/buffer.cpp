@@ -29,8 +29,9 @@ buffer_type create(const type::supplier<const device::device_type> &device,
 	create.queueFamilyIndexCount = (uint32_t) queueFamilyIndices.size();
 	create.pQueueFamilyIndices = queueFamilyIndices.empty() ? NULL : &queueFamilyIndices.front();
 	VkBuffer buffer;
-	VKCHECK(vkCreateBuffer(internal::get_instance(*device), &create, NULL, &buffer));
-	return buffer_type(buffer, device);
+	VKCHECK(vkCreateBuffer(vcc::internal::get_instance(*device), &create,
+		vcc::internal::get_allocator(*device), &buffer));
+	return buffer_type(buffer, device, flags, size, usage, sharingMode, queueFamilyIndices);
 }
 
 }  // namespace buffer
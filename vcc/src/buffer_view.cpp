@@ -27,7 +27,7 @@ buffer_view_type create(const type::supplier<const buffer::buffer_type> &buffer,
 	create.range = range;
 	VkBufferView view;
 	VKCHECK(vkCreateBufferView(internal::get_instance(*internal::get_parent(*buffer)),
-		&create, NULL, &view));
+		&create, internal::get_allocator(*internal::get_parent(*buffer)), &view));
 	return buffer_view_type(view, internal::get_parent(*buffer), buffer);
 }
 
@@ -32,6 +32,59 @@ VkClearValue clear_depth_stencil(const VkClearDepthStencilValue &depth_stencil)
 
 namespace internal {
 
+// Push constants are recorded by value, so if the storages have been modified
+// since recording the command buffer must be recorded again.
+void record_push_constants(build_type &build,
+		const type::supplier<const pipeline_layout::pipeline_layout_type> &layout) {
+	if (!pipeline_layout::internal::get_push_constants(*layout)) {
+		return;
+	}
+	const uint64_t revision(pipeline_layout::internal::push_constants(*layout,
+		vcc::internal::get_instance(internal::get_command_buffer(build))));
+	// The first revision recorded is the oldest, checking it covers the rest of
+	// this command buffer. Other command buffers of the submit may have been
+	// recorded at other revisions, so the check is not shared with them.
+	internal::get_pre_execute_callbacks(build).add_local(&*layout, [layout, revision](
+			const queue::queue_type &) {
+		if (pipeline_layout::internal::push_constants_revision(*layout) != revision) {
+			throw vcc_exception("push constants modified since recording, "
+				"command buffer must be recorded again");
+		}
+	});
+}
+
+// The tracking helpers do nothing unless the track command was recorded.
+void track_buffer(build_type &build, const type::supplier<const buffer::buffer_type> &resource,
+		VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags stage,
+		VkAccessFlags access) {
+	if (internal::get_tracker(build)) {
+		tracking::internal::access(*internal::get_tracker(build),
+			vcc::internal::get_instance(*resource), buffer::get_size(*resource), offset, size,
+			stage, access);
+	}
+}
+
+void track_image(build_type &build, const type::supplier<const image::image_type> &resource,
+		const VkImageSubresourceRange &range, VkPipelineStageFlags stage,
+		VkAccessFlags access, VkImageLayout layout) {
+	if (internal::get_tracker(build)) {
+		tracking::internal::access(*internal::get_tracker(build),
+			vcc::internal::get_instance(*resource), image::get_mip_levels(*resource),
+			image::get_array_layers(*resource), range, stage, access, layout);
+	}
+}
+
+VkImageSubresourceRange subresource_range(const VkImageSubresourceLayers &layers) {
+	return { layers.aspectMask, layers.mipLevel, 1, layers.baseArrayLayer, layers.layerCount };
+}
+
+void track_flush(build_type &build, const char *command) {
+	if (internal::get_tracker(build)) {
+		tracking::internal::flush(*internal::get_tracker(build),
+			vcc::internal::get_instance(internal::get_command_buffer(build)), command);
+	}
+}
+
 void cmd(build_type &build, const bind_pipeline &bp) {
 	VKTRACE(vkCmdBindPipeline(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		bp.pipelineBindPoint, vcc::internal::get_instance(*bp.pipeline)));
@@ -88,18 +141,24 @@ void cmd(build_type &build, const set_stencil_reference &ssr) {
 }
 
 void cmd(build_type &build, const bind_descriptor_sets &bds) {
-	std::vector<VkDescriptorSet> descriptor_sets;
-	descriptor_sets.reserve(bds.descriptor_sets.size());
+	// Binds of a few sets, recorded once per draw, stay off the heap.
+	VkDescriptorSet small_descriptor_sets[4];
+	std::vector<VkDescriptorSet> large_descriptor_sets;
+	VkDescriptorSet *descriptor_sets(small_descriptor_sets);
+	if (bds.descriptor_sets.size() > sizeof(small_descriptor_sets)
+			/ sizeof(small_descriptor_sets[0])) {
+		large_descriptor_sets.resize(bds.descriptor_sets.size());
+		descriptor_sets = large_descriptor_sets.data();
+	}
 	type::supplier<const pipeline_layout::pipeline_layout_type> layout(bds.layout);
 	internal::get_references(build).add(layout);
-	internal::get_pre_execute_callbacks(build).add([layout](const queue::queue_type &queue) {
-		pipeline_layout::internal::get_pre_execute_callbacks(*layout)(queue);
-	});
-	for (const type::supplier<const descriptor_set::descriptor_set_type> &descriptor_set
-			: bds.descriptor_sets) {
-		descriptor_sets.push_back(vcc::internal::get_instance(*descriptor_set));
+	record_push_constants(build, layout);
+	for (std::size_t i = 0; i < bds.descriptor_sets.size(); ++i) {
+		const type::supplier<const descriptor_set::descriptor_set_type> &descriptor_set(
+			bds.descriptor_sets[i]);
+		descriptor_sets[i] = vcc::internal::get_instance(*descriptor_set);
 		internal::get_references(build).add(descriptor_set);
-		internal::get_pre_execute_callbacks(build).add([descriptor_set](
+		internal::get_pre_execute_callbacks(build).add(&*descriptor_set, [descriptor_set](
 				const queue::queue_type &queue) {
 			descriptor_set->pre_execute_callbacks(queue);
 		});
@@ -107,11 +166,14 @@ void cmd(build_type &build, const bind_descriptor_sets &bds) {
 	VKTRACE(vkCmdBindDescriptorSets(
 		vcc::internal::get_instance(internal::get_command_buffer(build)), bds.pipelineBindPoint,
 		vcc::internal::get_instance(*layout), bds.firstSet,
-		(uint32_t)bds.descriptor_sets.size(), descriptor_sets.data(),
+		(uint32_t)bds.descriptor_sets.size(), descriptor_sets,
 		(uint32_t)bds.dynamic_offsets.size(), bds.dynamic_offsets.data()));
 }
 
 void cmd(build_type &build, const bind_index_buffer_type &bib) {
+	track_buffer(build, bib.buffer, bib.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+	track_flush(build, "vkCmdBindIndexBuffer");
 	VKTRACE(vkCmdBindIndexBuffer(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*bib.buffer), bib.offset, bib.indexType));
@@ -132,42 +194,104 @@ void cmd(build_type &build, const bind_vertex_buffers_type &bvb) {
 		// but can't find anything in the spec.
 		offsets.push_back(bvb.offsets[i]);
 		//offsets.push_back(bvb.buffers[i]->offset + bvb.offsets[i]);
+		track_buffer(build, buffer, bvb.offsets[i], VK_WHOLE_SIZE,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 	}
+	track_flush(build, "vkCmdBindVertexBuffers");
 	VKTRACE(vkCmdBindVertexBuffers(
 		vcc::internal::get_instance(internal::get_command_buffer(build)), bvb.first_binding,
 		(uint32_t)bvb.buffers.size(), buffers.data(), offsets.data()));
 }
 
 void cmd(build_type &build, const draw &d) {
+	track_flush(build, "vkCmdDraw");
 	VKTRACE(vkCmdDraw(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		d.vertexCount, d.instanceCount, d.firstVertex, d.firstInstance));
 }
 
 void cmd(build_type &build, const draw_indexed &di) {
+	track_flush(build, "vkCmdDrawIndexed");
 	VKTRACE(vkCmdDrawIndexed(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		di.indexCount, di.instanceCount, di.firstIndex, di.vertexOffset,
 		di.firstInstance));
 }
 
 void cmd(build_type &build, const draw_indirect_type &di) {
+	track_buffer(build, di.buffer, di.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_flush(build, "vkCmdDrawIndirect");
 	VKTRACE(vkCmdDrawIndirect(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*di.buffer), di.offset, di.drawCount,
 		di.stride));
 }
 
 void cmd(build_type &build, const draw_indexed_indirect_type &dii) {
+	track_buffer(build, dii.buffer, dii.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_flush(build, "vkCmdDrawIndexedIndirect");
 	VKTRACE(vkCmdDrawIndexedIndirect(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*dii.buffer), dii.offset, dii.drawCount,
 		dii.stride));
 }
 
+#if defined(VK_KHR_draw_indirect_count)
+
+// Loaded by device::create, null if the device has neither the extension
+// nor Vulkan 1.2.
+const device::internal::functions_type &get_draw_indirect_count(build_type &build) {
+	const device::internal::functions_type &functions(device::internal::get_functions(
+		*vcc::internal::get_parent(get_command_buffer(build))));
+	if (!functions.draw_indirect_count || !functions.draw_indexed_indirect_count) {
+		throw vcc_exception("VK_KHR_draw_indirect_count is not enabled");
+	}
+	return functions;
+}
+
+void cmd(build_type &build, const draw_indirect_count_type &dic) {
+	const PFN_vkCmdDrawIndirectCountKHR draw_indirect_count(
+		get_draw_indirect_count(build).draw_indirect_count);
+	track_buffer(build, dic.buffer, dic.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_buffer(build, dic.countBuffer, dic.countBufferOffset, sizeof(uint32_t),
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_flush(build, "vkCmdDrawIndirectCountKHR");
+	VKTRACE(draw_indirect_count(
+		vcc::internal::get_instance(internal::get_command_buffer(build)),
+		vcc::internal::get_instance(*dic.buffer), dic.offset,
+		vcc::internal::get_instance(*dic.countBuffer), dic.countBufferOffset,
+		dic.maxDrawCount, dic.stride));
+	internal::get_references(build).add(dic.buffer, dic.countBuffer);
+}
+
+void cmd(build_type &build, const draw_indexed_indirect_count_type &diic) {
+	const PFN_vkCmdDrawIndexedIndirectCountKHR draw_indexed_indirect_count(
+		get_draw_indirect_count(build).draw_indexed_indirect_count);
+	track_buffer(build, diic.buffer, diic.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_buffer(build, diic.countBuffer, diic.countBufferOffset, sizeof(uint32_t),
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_flush(build, "vkCmdDrawIndexedIndirectCountKHR");
+	VKTRACE(draw_indexed_indirect_count(
+		vcc::internal::get_instance(internal::get_command_buffer(build)),
+		vcc::internal::get_instance(*diic.buffer), diic.offset,
+		vcc::internal::get_instance(*diic.countBuffer), diic.countBufferOffset,
+		diic.maxDrawCount, diic.stride));
+	internal::get_references(build).add(diic.buffer, diic.countBuffer);
+}
+
+#endif // VK_KHR_draw_indirect_count
+
 void cmd(build_type &build, const dispatch &d) {
+	track_flush(build, "vkCmdDispatch");
 	VKTRACE(vkCmdDispatch(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		d.x, d.y, d.z));
 }
 
 void cmd(build_type &build, const dispatch_indirect_type &di) {
+	track_buffer(build, di.buffer, di.offset, sizeof(VkDispatchIndirectCommand),
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_flush(build, "vkCmdDispatchIndirect");
 	VKTRACE(vkCmdDispatchIndirect(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*di.buffer), di.offset));
@@ -175,6 +299,13 @@ void cmd(build_type &build, const dispatch_indirect_type &di) {
 }
 
 void cmd(build_type &build, const copy_buffer_type &cb) {
+	for (const VkBufferCopy &region : cb.regions) {
+		track_buffer(build, cb.srcBuffer, region.srcOffset, region.size,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		track_buffer(build, cb.dstBuffer, region.dstOffset, region.size,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
+	track_flush(build, "vkCmdCopyBuffer");
 	VKTRACE(vkCmdCopyBuffer(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*cb.srcBuffer),
@@ -184,6 +315,13 @@ void cmd(build_type &build, const copy_buffer_type &cb) {
 }
 
 void cmd(build_type &build, const copy_image &ci) {
+	for (const VkImageCopy &region : ci.regions) {
+		track_image(build, ci.srcImage, subresource_range(region.srcSubresource),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, ci.srcImageLayout);
+		track_image(build, ci.dstImage, subresource_range(region.dstSubresource),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, ci.dstImageLayout);
+	}
+	track_flush(build, "vkCmdCopyImage");
 	VKTRACE(vkCmdCopyImage(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*ci.srcImage), ci.srcImageLayout,
 		vcc::internal::get_instance(*ci.dstImage), ci.dstImageLayout,
@@ -192,6 +330,13 @@ void cmd(build_type &build, const copy_image &ci) {
 }
 
 void cmd(build_type &build, const blit_image &bi) {
+	for (const VkImageBlit &region : bi.regions) {
+		track_image(build, bi.srcImage, subresource_range(region.srcSubresource),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, bi.srcImageLayout);
+		track_image(build, bi.dstImage, subresource_range(region.dstSubresource),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, bi.dstImageLayout);
+	}
+	track_flush(build, "vkCmdBlitImage");
 	VKTRACE(vkCmdBlitImage(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*bi.srcImage), bi.srcImageLayout,
 		vcc::internal::get_instance(*bi.dstImage), bi.dstImageLayout,
@@ -200,6 +345,14 @@ void cmd(build_type &build, const blit_image &bi) {
 }
 
 void cmd(build_type &build, const copy_buffer_to_image_type &bti) {
+	// The buffer range depends on the image format, track it to the end.
+	for (const VkBufferImageCopy &region : bti.regions) {
+		track_buffer(build, bti.srcBuffer, region.bufferOffset, VK_WHOLE_SIZE,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		track_image(build, bti.dstImage, subresource_range(region.imageSubresource),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, bti.dstImageLayout);
+	}
+	track_flush(build, "vkCmdCopyBufferToImage");
 	VKTRACE(vkCmdCopyBufferToImage(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*bti.srcBuffer),
@@ -209,6 +362,13 @@ void cmd(build_type &build, const copy_buffer_to_image_type &bti) {
 }
 
 void cmd(build_type &build, const copy_image_to_buffer &cib) {
+	for (const VkBufferImageCopy &region : cib.regions) {
+		track_image(build, cib.srcImage, subresource_range(region.imageSubresource),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, cib.srcImageLayout);
+		track_buffer(build, cib.dstBuffer, region.bufferOffset, VK_WHOLE_SIZE,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
+	track_flush(build, "vkCmdCopyImageToBuffer");
 	VKTRACE(vkCmdCopyImageToBuffer(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*cib.srcImage), cib.srcImageLayout,
@@ -218,6 +378,9 @@ void cmd(build_type &build, const copy_image_to_buffer &cib) {
 }
 
 void cmd(build_type &build, const update_buffer &ub) {
+	track_buffer(build, ub.dstBuffer, ub.dstOffset, ub.dataSize,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	track_flush(build, "vkCmdUpdateBuffer");
 	VKTRACE(vkCmdUpdateBuffer(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*ub.dstBuffer), ub.dstOffset, ub.dataSize,
@@ -226,6 +389,9 @@ void cmd(build_type &build, const update_buffer &ub) {
 }
 
 void cmd(build_type &build, const fill_buffer &fb) {
+	track_buffer(build, fb.dstBuffer, fb.dstOffset, fb.size,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	track_flush(build, "vkCmdFillBuffer");
 	VKTRACE(vkCmdFillBuffer(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*fb.dstBuffer), fb.dstOffset, fb.size,
@@ -234,6 +400,11 @@ void cmd(build_type &build, const fill_buffer &fb) {
 }
 
 void cmd(build_type &build, const clear_color_image &cci) {
+	for (const VkImageSubresourceRange &range : cci.ranges) {
+		track_image(build, cci.image, range, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, cci.imageLayout);
+	}
+	track_flush(build, "vkCmdClearColorImage");
 	VKTRACE(vkCmdClearColorImage(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*cci.image), cci.imageLayout, &cci.color,
@@ -242,6 +413,11 @@ void cmd(build_type &build, const clear_color_image &cci) {
 }
 
 void cmd(build_type &build, const clear_depth_stencil_image &cdsi) {
+	for (const VkImageSubresourceRange &range : cdsi.ranges) {
+		track_image(build, cdsi.image, range, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, cdsi.imageLayout);
+	}
+	track_flush(build, "vkCmdClearDepthStencilImage");
 	VKTRACE(vkCmdClearDepthStencilImage(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*cdsi.image), cdsi.imageLayout,
@@ -258,6 +434,13 @@ void cmd(build_type &build, const clear_attachments &ca) {
 }
 
 void cmd(build_type &build, const resolve_image &ri) {
+	for (const VkImageResolve &region : ri.regions) {
+		track_image(build, ri.srcImage, subresource_range(region.srcSubresource),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, ri.srcImageLayout);
+		track_image(build, ri.dstImage, subresource_range(region.dstSubresource),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, ri.dstImageLayout);
+	}
+	track_flush(build, "vkCmdResolveImage");
 	VKTRACE(vkCmdResolveImage(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*ri.srcImage), ri.srcImageLayout,
@@ -325,6 +508,35 @@ void cmd(build_type &build, const pipeline_barrier &pb) {
 			vcc::internal::get_instance(*barrier.image),
 			barrier.subresourceRange });
 	}
+	if (internal::get_tracker(build)) {
+		tracking::internal::tracker_type &tracker(*internal::get_tracker(build));
+		bool useful(false);
+		for (const VkMemoryBarrier &barrier : memory_barriers) {
+			useful |= tracking::internal::barrier(tracker, pb.srcStageMask, pb.dstStageMask,
+				barrier);
+		}
+		for (std::size_t i = 0; i < buffer_memory_barriers.size(); ++i) {
+			useful |= tracking::internal::barrier(tracker, pb.srcStageMask, pb.dstStageMask,
+				buffer::get_size(*pb.buffer_memory_barriers[i].buffer),
+				buffer_memory_barriers[i]);
+		}
+		for (std::size_t i = 0; i < image_memory_barriers.size(); ++i) {
+			const image::image_type &target(*pb.image_memory_barriers[i].image);
+			useful |= tracking::internal::barrier(tracker, pb.srcStageMask, pb.dstStageMask,
+				image::get_mip_levels(target), image::get_array_layers(target),
+				image_memory_barriers[i]);
+		}
+		// Ownership transfers are needed whatever was tracked before them.
+		for (const VkBufferMemoryBarrier &barrier : buffer_memory_barriers) {
+			useful |= barrier.srcQueueFamilyIndex != barrier.dstQueueFamilyIndex;
+		}
+		for (const VkImageMemoryBarrier &barrier : image_memory_barriers) {
+			useful |= barrier.srcQueueFamilyIndex != barrier.dstQueueFamilyIndex;
+		}
+		if (!useful && tracker.report) {
+			tracker.report("redundant pipeline barrier, it orders no tracked access");
+		}
+	}
 	VKTRACE(vkCmdPipelineBarrier(
 		vcc::internal::get_instance(internal::get_command_buffer(build)), pb.srcStageMask,
 		pb.dstStageMask, pb.dependencyFlags, (uint32_t)memory_barriers.size(),
@@ -360,6 +572,9 @@ void cmd(build_type &build, const write_timestamp &wt) {
 }
 
 void cmd(build_type &build, const copy_query_pool_results &cqpr) {
+	track_buffer(build, cqpr.dstBuffer, cqpr.dstOffset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	track_flush(build, "vkCmdCopyQueryPoolResults");
 	VKTRACE(vkCmdCopyQueryPoolResults(
 		vcc::internal::get_instance(internal::get_command_buffer(build)),
 		vcc::internal::get_instance(*cqpr.queryPool), cqpr.firstQuery,
@@ -375,21 +590,30 @@ void cmd(build_type &build, const push_constants_type &pc) {
 	internal::get_references(build).add(pc.layout);
 }
 
+void cmd(build_type &build, const push_layout_constants_type &plc) {
+	record_push_constants(build, plc.layout);
+	internal::get_references(build).add(plc.layout);
+}
+
 void cmd(build_type &build, const next_subpass &ns) {
 	VKTRACE(vkCmdNextSubpass(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		ns.contents));
 }
 
 void cmd(build_type &build, const execute_commands &ec) {
+	// commandBufferCount must be greater than 0, nothing to execute is valid here.
+	if (ec.commandBuffers.empty()) {
+		return;
+	}
 	std::vector<VkCommandBuffer> command_buffers;
 	command_buffers.reserve(ec.commandBuffers.size());
 	for (const type::supplier<const command_buffer::command_buffer_type> &command
 			: ec.commandBuffers) {
 		command_buffers.push_back(vcc::internal::get_instance(*command));
 		internal::get_references(build).add(command);
-		internal::get_pre_execute_callbacks(build).add([command](const queue::queue_type &queue) {
-			command_buffer::internal::get_pre_execute_hook(*command)(queue);
-		});
+		// Kept alive by the reference above.
+		internal::get_pre_execute_callbacks(build).add_nested(
+			command_buffer::internal::get_pre_execute_hook(*command));
 	}
 	VKTRACE(vkCmdExecuteCommands(vcc::internal::get_instance(internal::get_command_buffer(build)),
 		(uint32_t) command_buffers.size(), command_buffers.data()));
@@ -397,9 +621,10 @@ void cmd(build_type &build, const execute_commands &ec) {
 
 void cmd(build_type &build, const bind_index_data_buffer_type&bidb) {
 	const type::supplier<const input_buffer::input_buffer_type> &buffer(bidb.buffer);
-	internal::get_pre_execute_callbacks(build).add([buffer](const queue::queue_type &queue) {
-		input_buffer::flush(queue, *buffer);
-	});
+	internal::get_pre_execute_callbacks(build).add(&*buffer,
+		[buffer](const queue::queue_type &queue) {
+			input_buffer::flush(queue, *buffer);
+		});
 	cmd(build, bind_index_buffer_type{ std::ref(input_buffer::internal::get_buffer(*buffer)),
 		bidb.offset, bidb.indexType });
 }
@@ -408,9 +633,10 @@ void cmd(build_type &build, const bind_vertex_data_buffers_type&bvdb) {
 	std::vector<type::supplier<const buffer::buffer_type>> buffers;
 	buffers.reserve(bvdb.buffers.size());
 	for (const type::supplier<const input_buffer::input_buffer_type> &buffer : bvdb.buffers) {
-		internal::get_pre_execute_callbacks(build).add([buffer](const queue::queue_type &queue) {
-			input_buffer::flush(queue, *buffer);
-		});
+		internal::get_pre_execute_callbacks(build).add(&*buffer,
+			[buffer](const queue::queue_type &queue) {
+				input_buffer::flush(queue, *buffer);
+			});
 		buffers.push_back(std::ref(input_buffer::internal::get_buffer(*buffer)));
 	}
 	cmd(build, bind_vertex_buffers_type{ bvdb.first_binding, std::move(buffers),
@@ -419,49 +645,447 @@ void cmd(build_type &build, const bind_vertex_data_buffers_type&bvdb) {
 
 void cmd(build_type &build, const draw_indirect_data_type&did) {
 	const type::supplier<const input_buffer::input_buffer_type> &buffer(did.buffer);
-	internal::get_pre_execute_callbacks(build).add([buffer](const queue::queue_type &queue) {
-		input_buffer::flush(queue, *buffer);
-	});
+	internal::get_pre_execute_callbacks(build).add(&*buffer,
+		[buffer](const queue::queue_type &queue) {
+			input_buffer::flush(queue, *buffer);
+		});
 	cmd(build, draw_indirect_type{ std::ref(input_buffer::internal::get_buffer(*buffer)),
 		did.offset, did.drawCount, did.stride });
 }
 
 void cmd(build_type &build, const draw_indexed_indirect_data_type&diid) {
 	const type::supplier<const input_buffer::input_buffer_type> &buffer(diid.buffer);
-	internal::get_pre_execute_callbacks(build).add([buffer](const queue::queue_type &queue) {
-		input_buffer::flush(queue, *buffer);
-	});
+	internal::get_pre_execute_callbacks(build).add(&*buffer,
+		[buffer](const queue::queue_type &queue) {
+			input_buffer::flush(queue, *buffer);
+		});
 	cmd(build, draw_indexed_indirect_type{ std::ref(input_buffer::internal::get_buffer(*buffer)),
 		diid.offset, diid.drawCount, diid.stride });
 }
 
 void cmd(build_type &build, const dispatch_indirect_data_type&did) {
 	const type::supplier<const input_buffer::input_buffer_type> &buffer(did.buffer);
-	internal::get_pre_execute_callbacks(build).add([buffer](const queue::queue_type &queue) {
-		input_buffer::flush(queue, *buffer);
-	});
+	internal::get_pre_execute_callbacks(build).add(&*buffer,
+		[buffer](const queue::queue_type &queue) {
+			input_buffer::flush(queue, *buffer);
+		});
 	cmd(build, dispatch_indirect_type{ std::ref(input_buffer::internal::get_buffer(*buffer)),
 		did.offset });
 }
 
 void cmd(build_type &build, const copy_data_buffer_type&cdb) {
 	const type::supplier<const input_buffer::input_buffer_type> &buffer(cdb.srcBuffer);
-	internal::get_pre_execute_callbacks(build).add([buffer](const queue::queue_type &queue) {
-		input_buffer::flush(queue, *buffer);
-	});
+	internal::get_pre_execute_callbacks(build).add(&*buffer,
+		[buffer](const queue::queue_type &queue) {
+			input_buffer::flush(queue, *buffer);
+		});
 	cmd(build, copy_buffer_type{ std::ref(input_buffer::internal::get_buffer(*buffer)),
 		cdb.dstBuffer, cdb.regions });
 }
 
 void cmd(build_type &build, const copy_data_buffer_to_image_type&cdbti) {
 	const type::supplier<const input_buffer::input_buffer_type> &buffer(cdbti.srcBuffer);
-	internal::get_pre_execute_callbacks(build).add([buffer](const queue::queue_type &queue) {
-		input_buffer::flush(queue, *buffer);
-	});
+	internal::get_pre_execute_callbacks(build).add(&*buffer,
+		[buffer](const queue::queue_type &queue) {
+			input_buffer::flush(queue, *buffer);
+		});
 	cmd(build, copy_buffer_to_image_type{ std::ref(input_buffer::internal::get_buffer(*buffer)),
 		cdbti.dstImage, cdbti.dstImageLayout, cdbti.regions });
 }
 
+void track_before_render_pass(build_type &build, const bind_index_buffer_type &bib) {
+	track_buffer(build, bib.buffer, bib.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+}
+
+void track_before_render_pass(build_type &build, const bind_vertex_buffers_type &bvb) {
+	for (std::size_t i = 0; i < bvb.buffers.size(); ++i) {
+		track_buffer(build, bvb.buffers[i], bvb.offsets[i], VK_WHOLE_SIZE,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	}
+}
+
+void track_before_render_pass(build_type &build, const draw_indirect_type &di) {
+	track_buffer(build, di.buffer, di.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void track_before_render_pass(build_type &build, const draw_indexed_indirect_type &dii) {
+	track_buffer(build, dii.buffer, dii.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+#if defined(VK_KHR_draw_indirect_count)
+
+void track_before_render_pass(build_type &build, const draw_indirect_count_type &dic) {
+	track_buffer(build, dic.buffer, dic.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_buffer(build, dic.countBuffer, dic.countBufferOffset, sizeof(uint32_t),
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void track_before_render_pass(build_type &build,
+		const draw_indexed_indirect_count_type &diic) {
+	track_buffer(build, diic.buffer, diic.offset, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	track_buffer(build, diic.countBuffer, diic.countBufferOffset, sizeof(uint32_t),
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+#endif // VK_KHR_draw_indirect_count
+
+void track_before_render_pass(build_type &build, const bind_index_data_buffer_type &bidb) {
+	track_buffer(build, std::cref(input_buffer::internal::get_buffer(*bidb.buffer)),
+		bidb.offset, VK_WHOLE_SIZE, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_ACCESS_INDEX_READ_BIT);
+}
+
+void track_before_render_pass(build_type &build, const bind_vertex_data_buffers_type &bvdb) {
+	for (std::size_t i = 0; i < bvdb.buffers.size(); ++i) {
+		track_buffer(build, std::cref(input_buffer::internal::get_buffer(*bvdb.buffers[i])),
+			bvdb.offsets[i], VK_WHOLE_SIZE, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	}
+}
+
+void track_before_render_pass(build_type &build, const draw_indirect_data_type &did) {
+	track_buffer(build, std::cref(input_buffer::internal::get_buffer(*did.buffer)),
+		did.offset, VK_WHOLE_SIZE, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void track_before_render_pass(build_type &build, const draw_indexed_indirect_data_type &diid) {
+	track_buffer(build, std::cref(input_buffer::internal::get_buffer(*diid.buffer)),
+		diid.offset, VK_WHOLE_SIZE, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void track_before_render_pass(build_type &build, const buffer_access_type &ba) {
+	track_buffer(build, ba.buffer, ba.offset, ba.size, ba.stage, ba.access);
+}
+
+void track_before_render_pass(build_type &build, const image_access_type &ia) {
+	track_image(build, ia.image, ia.range, ia.stage, ia.access, ia.layout);
+}
+
+void cmd(build_type &build, const track_type &t) {
+	internal::get_tracker(build).reset(new tracking::internal::tracker_type(t.mode, t.report));
+}
+
+void cmd(build_type &build, const buffer_access_type &ba) {
+	// Flushed by the command accessing it, along with its own accesses.
+	track_buffer(build, ba.buffer, ba.offset, ba.size, ba.stage, ba.access);
+	internal::get_references(build).add(ba.buffer);
+}
+
+void cmd(build_type &build, const image_access_type &ia) {
+	track_image(build, ia.image, ia.range, ia.stage, ia.access, ia.layout);
+	internal::get_references(build).add(ia.image);
+}
+
+void cmd(build_type &build, const declare_image_type &di) {
+	if (internal::get_tracker(build)) {
+		tracking::internal::declare(*internal::get_tracker(build),
+			vcc::internal::get_instance(*di.image), image::get_mip_levels(*di.image),
+			image::get_array_layers(*di.image), di.range, di.stage, di.access, di.layout);
+	}
+}
+
+void cmd(build_type &build, const release_ownership_type &ro) {
+	const ownership_transfer_type &transfer(ro.transfer);
+	if (transfer.srcQueueFamilyIndex == transfer.dstQueueFamilyIndex) {
+		return;
+	}
+	// The destination stages and accesses are ignored by releases.
+	pipeline_barrier barrier(ro.srcStageMask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, {},
+		{}, {});
+	for (const owned_buffer_type &buffer : transfer.buffers) {
+		barrier.buffer_memory_barriers.push_back(buffer_memory_barrier_type{ ro.srcAccessMask,
+			0, transfer.srcQueueFamilyIndex, transfer.dstQueueFamilyIndex, buffer.buffer,
+			buffer.offset, buffer.size });
+		internal::get_references(build).add(buffer.buffer);
+	}
+	for (const owned_image_type &image : transfer.images) {
+		barrier.image_memory_barriers.push_back(image_memory_barrier{ ro.srcAccessMask, 0,
+			image.oldLayout, image.newLayout, transfer.srcQueueFamilyIndex,
+			transfer.dstQueueFamilyIndex, image.image, image.subresourceRange });
+		internal::get_references(build).add(image.image);
+	}
+	cmd(build, barrier);
+}
+
+void cmd(build_type &build, const acquire_ownership_type &ao) {
+	const ownership_transfer_type &transfer(ao.transfer);
+	const bool same_family(transfer.srcQueueFamilyIndex == transfer.dstQueueFamilyIndex);
+	const uint32_t src_family(same_family ? VK_QUEUE_FAMILY_IGNORED
+		: transfer.srcQueueFamilyIndex);
+	const uint32_t dst_family(same_family ? VK_QUEUE_FAMILY_IGNORED
+		: transfer.dstQueueFamilyIndex);
+	// The semaphore makes the source queue's writes available, the source
+	// stages and accesses are ignored by acquires.
+	pipeline_barrier barrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, ao.dstStageMask, 0, {}, {}, {});
+	if (!same_family) {
+		for (const owned_buffer_type &buffer : transfer.buffers) {
+			barrier.buffer_memory_barriers.push_back(buffer_memory_barrier_type{ 0,
+				ao.dstAccessMask, src_family, dst_family, buffer.buffer, buffer.offset,
+				buffer.size });
+			internal::get_references(build).add(buffer.buffer);
+		}
+	}
+	for (const owned_image_type &image : transfer.images) {
+		if (same_family && image.oldLayout == image.newLayout) {
+			continue;
+		}
+		barrier.image_memory_barriers.push_back(image_memory_barrier{ 0, ao.dstAccessMask,
+			image.oldLayout, image.newLayout, src_family, dst_family, image.image,
+			image.subresourceRange });
+		internal::get_references(build).add(image.image);
+	}
+	if (!barrier.buffer_memory_barriers.empty() || !barrier.image_memory_barriers.empty()) {
+		cmd(build, barrier);
+	}
+}
+
+// Typed push constants are recorded by value, so their revision is content.
+void hash_layout(hash_type &content,
+		const type::supplier<const pipeline_layout::pipeline_layout_type> &layout) {
+	hash(content, layout);
+	if (pipeline_layout::internal::get_push_constants(*layout)) {
+		hash(content, pipeline_layout::internal::push_constants_revision(*layout));
+	}
+}
+
+void hash(hash_type &content, const bind_pipeline &bp) {
+	hash_all(content, bp.pipelineBindPoint, bp.pipeline);
+}
+
+void hash(hash_type &content, const set_viewport &sv) {
+	hash_all(content, sv.first_viewport, sv.viewports);
+}
+
+void hash(hash_type &content, const set_scissor &ss) {
+	hash_all(content, ss.first_scissor, ss.scissors);
+}
+
+void hash(hash_type &content, const bind_descriptor_sets &bds) {
+	hash_layout(content, bds.layout);
+	hash_all(content, bds.pipelineBindPoint, bds.firstSet, bds.descriptor_sets,
+		bds.dynamic_offsets);
+}
+
+void hash(hash_type &content, const bind_index_buffer_type &bib) {
+	hash_all(content, bib.buffer, bib.offset, bib.indexType);
+}
+
+void hash(hash_type &content, const bind_vertex_buffers_type &bvb) {
+	hash_all(content, bvb.first_binding, bvb.buffers, bvb.offsets);
+}
+
+void hash(hash_type &content, const draw_indirect_type &di) {
+	hash_all(content, di.buffer, di.offset, di.drawCount, di.stride);
+}
+
+void hash(hash_type &content, const draw_indexed_indirect_type &dii) {
+	hash_all(content, dii.buffer, dii.offset, dii.drawCount, dii.stride);
+}
+
+void hash(hash_type &content, const dispatch_indirect_type &di) {
+	hash_all(content, di.buffer, di.offset);
+}
+
+#if defined(VK_KHR_draw_indirect_count)
+
+void hash(hash_type &content, const draw_indirect_count_type &dic) {
+	hash_all(content, dic.buffer, dic.offset, dic.countBuffer, dic.countBufferOffset,
+		dic.maxDrawCount, dic.stride);
+}
+
+void hash(hash_type &content, const draw_indexed_indirect_count_type &diic) {
+	hash_all(content, diic.buffer, diic.offset, diic.countBuffer, diic.countBufferOffset,
+		diic.maxDrawCount, diic.stride);
+}
+
+#endif // VK_KHR_draw_indirect_count
+
+void hash(hash_type &content, const copy_buffer_type &cb) {
+	hash_all(content, cb.srcBuffer, cb.dstBuffer, cb.regions);
+}
+
+void hash(hash_type &content, const copy_image &ci) {
+	hash_all(content, ci.srcImage, ci.srcImageLayout, ci.dstImage, ci.dstImageLayout,
+		ci.regions);
+}
+
+void hash(hash_type &content, const blit_image &bi) {
+	hash_all(content, bi.srcImage, bi.srcImageLayout, bi.dstImage, bi.dstImageLayout,
+		bi.regions, bi.filter);
+}
+
+void hash(hash_type &content, const copy_buffer_to_image_type &bti) {
+	hash_all(content, bti.srcBuffer, bti.dstImage, bti.dstImageLayout, bti.regions);
+}
+
+void hash(hash_type &content, const copy_image_to_buffer &cib) {
+	hash_all(content, cib.srcImage, cib.srcImageLayout, cib.dstBuffer, cib.regions);
+}
+
+void hash(hash_type &content, const update_buffer &ub) {
+	hash_all(content, ub.dstBuffer, ub.dstOffset, ub.dataSize);
+	content.add(ub.pData, std::size_t(ub.dataSize));
+}
+
+void hash(hash_type &content, const fill_buffer &fb) {
+	hash_all(content, fb.dstBuffer, fb.dstOffset, fb.size, fb.data);
+}
+
+void hash(hash_type &content, const clear_color_image &cci) {
+	hash_all(content, cci.image, cci.imageLayout, cci.color, cci.ranges);
+}
+
+void hash(hash_type &content, const clear_depth_stencil_image &cdsi) {
+	hash_all(content, cdsi.image, cdsi.imageLayout, cdsi.pDepthStencil, cdsi.ranges);
+}
+
+void hash(hash_type &content, const clear_attachments &ca) {
+	hash_all(content, ca.attachments, ca.rects);
+}
+
+void hash(hash_type &content, const resolve_image &ri) {
+	hash_all(content, ri.srcImage, ri.srcImageLayout, ri.dstImage, ri.dstImageLayout,
+		ri.regions);
+}
+
+void hash(hash_type &content, const set_event &se) {
+	hash_all(content, se.event, se.stageMask);
+}
+
+void hash(hash_type &content, const reset_event &re) {
+	hash_all(content, re.event, re.stageMask);
+}
+
+void hash(hash_type &content, const wait_events &we) {
+	hash_all(content, we.events, we.srcStageMask, we.dstStageMask, we.memoryBarriers,
+		we.bufferMemoryBarriers, we.imageMemoryBarriers);
+}
+
+void hash(hash_type &content, const buffer_memory_barrier_type &bmb) {
+	hash_all(content, bmb.srcAccessMask, bmb.dstAccessMask, bmb.srcQueueFamilyIndex,
+		bmb.dstQueueFamilyIndex, bmb.buffer, bmb.offset, bmb.size);
+}
+
+void hash(hash_type &content, const image_memory_barrier &imb) {
+	hash_all(content, imb.srcAccessMask, imb.dstAccessMask, imb.oldLayout, imb.newLayout,
+		imb.srcQueueFamilyIndex, imb.dstQueueFamilyIndex, imb.image, imb.subresourceRange);
+}
+
+void hash(hash_type &content, const pipeline_barrier &pb) {
+	hash_all(content, pb.srcStageMask, pb.dstStageMask, pb.dependencyFlags,
+		pb.memory_barriers, pb.buffer_memory_barriers, pb.image_memory_barriers);
+}
+
+void hash(hash_type &content, const begin_query &bq) {
+	hash_all(content, bq.queryPool, bq.entry, bq.flags);
+}
+
+void hash(hash_type &content, const end_query &eq) {
+	hash_all(content, eq.queryPool, eq.entry);
+}
+
+void hash(hash_type &content, const reset_query_pool &rqp) {
+	hash_all(content, rqp.queryPool, rqp.firstQuery, rqp.queryCount);
+}
+
+void hash(hash_type &content, const write_timestamp &wt) {
+	hash_all(content, wt.pipelineStage, wt.queryPool, wt.entry);
+}
+
+void hash(hash_type &content, const copy_query_pool_results &cqpr) {
+	hash_all(content, cqpr.queryPool, cqpr.firstQuery, cqpr.queryCount, cqpr.dstBuffer,
+		cqpr.dstOffset, cqpr.stride, cqpr.flags);
+}
+
+void hash(hash_type &content, const push_constants_type &pc) {
+	hash_all(content, pc.layout, pc.stageFlags, pc.offset, pc.size);
+	content.add(pc.pValues, pc.size);
+}
+
+void hash(hash_type &content, const push_layout_constants_type &plc) {
+	hash_layout(content, plc.layout);
+}
+
+// A secondary command buffer recorded again invalidates the primary.
+void hash(hash_type &content, const execute_commands &ec) {
+	for (const type::supplier<const command_buffer::command_buffer_type> &command
+			: ec.commandBuffers) {
+		hash_all(content, command, command_buffer::internal::get_revision(*command));
+	}
+}
+
+void hash(hash_type &content, const bind_index_data_buffer_type &bidb) {
+	hash_all(content, bidb.buffer, bidb.offset, bidb.indexType);
+}
+
+void hash(hash_type &content, const bind_vertex_data_buffers_type &bvdb) {
+	hash_all(content, bvdb.first_binding, bvdb.buffers, bvdb.offsets);
+}
+
+void hash(hash_type &content, const draw_indirect_data_type &did) {
+	hash_all(content, did.buffer, did.offset, did.drawCount, did.stride);
+}
+
+void hash(hash_type &content, const draw_indexed_indirect_data_type &diid) {
+	hash_all(content, diid.buffer, diid.offset, diid.drawCount, diid.stride);
+}
+
+void hash(hash_type &content, const dispatch_indirect_data_type &did) {
+	hash_all(content, did.buffer, did.offset);
+}
+
+void hash(hash_type &content, const copy_data_buffer_type &cdb) {
+	hash_all(content, cdb.srcBuffer, cdb.dstBuffer, cdb.regions);
+}
+
+void hash(hash_type &content, const copy_data_buffer_to_image_type &cdbti) {
+	hash_all(content, cdbti.srcBuffer, cdbti.dstImage, cdbti.dstImageLayout, cdbti.regions);
+}
+
+// The report callback can not be compared, only whether there is one.
+void hash(hash_type &content, const track_type &t) {
+	hash_all(content, t.mode, bool(t.report));
+}
+
+void hash(hash_type &content, const buffer_access_type &ba) {
+	hash_all(content, ba.buffer, ba.stage, ba.access, ba.offset, ba.size);
+}
+
+void hash(hash_type &content, const image_access_type &ia) {
+	hash_all(content, ia.image, ia.range, ia.stage, ia.access, ia.layout);
+}
+
+void hash(hash_type &content, const declare_image_type &di) {
+	hash_all(content, di.image, di.range, di.stage, di.access, di.layout);
+}
+
+void hash(hash_type &content, const owned_buffer_type &ob) {
+	hash_all(content, ob.buffer, ob.offset, ob.size);
+}
+
+void hash(hash_type &content, const owned_image_type &oi) {
+	hash_all(content, oi.image, oi.subresourceRange, oi.oldLayout, oi.newLayout);
+}
+
+void hash(hash_type &content, const ownership_transfer_type &ot) {
+	hash_all(content, ot.srcQueueFamilyIndex, ot.dstQueueFamilyIndex, ot.buffers, ot.images);
+}
+
+void hash(hash_type &content, const release_ownership_type &ro) {
+	hash_all(content, ro.transfer, ro.srcStageMask, ro.srcAccessMask);
+}
+
+void hash(hash_type &content, const acquire_ownership_type &ao) {
+	hash_all(content, ao.transfer, ao.dstStageMask, ao.dstAccessMask);
+}
+
 }  // namespace internal
 
 build_type::~build_type() {
@@ -474,7 +1098,16 @@ build_type::~build_type() {
 
 build_type::build_type(const type::supplier<command_buffer::command_buffer_type> &command_buffer)
 	: command_buffer(command_buffer),
-	command_buffer_lock(vcc::internal::get_mutex(*command_buffer)) {}
+	command_buffer_lock(vcc::internal::get_mutex(*command_buffer)),
+	pre_execute_callbacks(std::move(command_buffer->pre_execute_hook)),
+	references(std::move(command_buffer->references)) {
+	// The command buffer was reset when begun, what the previous recording
+	// kept alive is released and its memory reused for this recording.
+	pre_execute_callbacks.clear();
+	references.clear();
+	command_buffer->content_hash = 0;
+	++command_buffer->revision;
+}
 
 build_type build(const type::supplier<command_buffer::command_buffer_type> &command_buffer,
 	VkCommandBufferUsageFlags flags,
@@ -25,8 +25,8 @@ command_pool_type create(const type::supplier<const device::device_type> &device
 	create.flags = flags;
 	create.queueFamilyIndex = queueFamilyIndex;
 	VkCommandPool pool;
-	VKCHECK(vkCreateCommandPool(internal::get_instance(*device), &create, NULL,
-		&pool));
+	VKCHECK(vkCreateCommandPool(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &pool));
 	return command_pool_type(pool, device);
 }
 
@@ -87,7 +87,8 @@ debug_type create(const type::supplier<const instance::instance_type> &instance,
 	create.pfnCallback = &dbgFunc;
 	create.pUserData = callback_ptr.get();
 
-	dbgCreateMsgCallback(internal::get_instance(*instance), &create, NULL, &msg_callback);
+	dbgCreateMsgCallback(internal::get_instance(*instance), &create,
+		internal::get_allocator(*instance), &msg_callback);
 	return debug_type(instance, msg_callback,
 		std::forward<std::unique_ptr<callback_type>>(callback_ptr),
 		dbgDestroyMsgCallback);
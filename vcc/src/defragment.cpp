@@ -0,0 +1,206 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <algorithm>
+#include <map>
+#include <vcc/command.h>
+#include <vcc/defragment.h>
+#include <vcc/transient.h>
+
+namespace vcc {
+namespace defragment {
+
+namespace internal {
+
+buffer_entry_type &find_or_add(std::vector<buffer_entry_type> &buffers,
+		const type::supplier<buffer::buffer_type> &buffer) {
+	if (!(buffer::get_usage(*buffer) & VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+			|| !(buffer::get_usage(*buffer) & VK_BUFFER_USAGE_TRANSFER_DST_BIT)) {
+		throw vcc_exception("Buffers must be transfer source and destination to be moved");
+	}
+	const auto entry(std::find_if(buffers.begin(), buffers.end(),
+		[&buffer](const buffer_entry_type &entry) {
+			return &*entry.buffer == &*buffer;
+		}));
+	if (entry != buffers.end()) {
+		return *entry;
+	}
+	buffers.push_back(buffer_entry_type{ buffer });
+	return buffers.back();
+}
+
+void compact(const queue::queue_type &queue, VkMemoryPropertyFlags propertyFlags,
+		const std::vector<candidate_type> &batch, result_type &result) {
+	std::vector<buffer_entry_type *> entries;
+	for (const candidate_type &candidate : batch) {
+		entries.insert(entries.end(), candidate.entries.begin(), candidate.entries.end());
+		result.bytes_freed += candidate.size;
+	}
+	std::vector<buffer::buffer_type> buffers;
+	buffers.reserve(entries.size());
+	std::vector<buffer::buffer_type *> pointers;
+	pointers.reserve(entries.size());
+	for (buffer_entry_type *entry : entries) {
+		const buffer::buffer_type &buffer(*entry->buffer);
+		buffers.push_back(buffer::create(vcc::internal::get_parent(buffer),
+			buffer::get_flags(buffer), buffer::get_size(buffer), buffer::get_usage(buffer),
+			buffer::get_sharing_mode(buffer), buffer::get_queue_family_indices(buffer)));
+		pointers.push_back(&buffers.back());
+	}
+	memory::internal::bind_buffers(vcc::internal::get_parent(*entries.front()->buffer),
+		propertyFlags, pointers);
+
+	{
+		transient::command_type command(transient::acquire(queue));
+		{
+			command::build_type build(command::build(
+				std::ref(transient::get_command_buffer(command)),
+				VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, VK_FALSE, 0, 0));
+			for (std::size_t i = 0; i < entries.size(); ++i) {
+				command::internal::cmd(build, command::copy_buffer(entries[i]->buffer,
+					std::cref(buffers[i]),
+					{ VkBufferCopy{ 0, 0, buffer::get_size(buffers[i]) } }));
+				result.bytes_moved += buffer::get_size(buffers[i]);
+			}
+			// Later submissions may use the buffers in any way.
+			command::internal::cmd(build, command::pipeline_barrier(
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+				{ command::memory_barrier{ VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT } }, {}, {}));
+		}
+		transient::submit_and_wait(queue, command);
+	}
+
+	const device::device_type &device(*vcc::internal::get_parent(queue));
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		// Destroys the old VkBuffer and releases its allocation.
+		*entries[i]->buffer = std::move(buffers[i]);
+		for (const descriptor_type &descriptor : entries[i]->descriptors) {
+			descriptor_set::update(device, descriptor_set::write_buffer(*descriptor.set,
+				descriptor.binding, descriptor.array_element, descriptor.descriptor_type,
+				{ descriptor_set::buffer_info(entries[i]->buffer, descriptor.offset,
+					descriptor.range) }));
+		}
+		result.moved.push_back(entries[i]->buffer);
+	}
+}
+
+void select(std::vector<candidate_type> &candidates, float max_utilization) {
+	// Resources bound to the allocation that were never registered keep it
+	// alive, moving the registered ones would free nothing.
+	candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+		[max_utilization](const candidate_type &candidate) {
+			return candidate.used < candidate.bound
+				|| candidate.used >= max_utilization * candidate.size;
+		}), candidates.end());
+	// Emptiest first, they free the most memory per byte copied.
+	std::stable_sort(candidates.begin(), candidates.end(),
+		[](const candidate_type &lhs, const candidate_type &rhs) {
+			return lhs.used * rhs.size < rhs.used * lhs.size;
+		});
+}
+
+std::vector<candidate_type> next_batch(std::vector<candidate_type> &candidates,
+		VkDeviceSize block_size) {
+	std::vector<candidate_type> batch;
+	if (candidates.empty()) {
+		return batch;
+	}
+	const VkMemoryPropertyFlags propertyFlags(candidates.front().propertyFlags);
+	VkDeviceSize batch_size(0);
+	for (auto candidate(candidates.begin()); candidate != candidates.end();) {
+		if (candidate->propertyFlags == propertyFlags
+				&& (batch.empty() || batch_size + candidate->used <= block_size)) {
+			batch_size += candidate->used;
+			batch.push_back(std::move(*candidate));
+			candidate = candidates.erase(candidate);
+		} else {
+			++candidate;
+		}
+	}
+	return batch;
+}
+
+}  // namespace internal
+
+void add(defragmenter_type &defragmenter, const type::supplier<buffer::buffer_type> &buffer) {
+	std::lock_guard<std::mutex> lock(defragmenter.mutex);
+	internal::find_or_add(defragmenter.buffers, buffer);
+}
+
+void add(defragmenter_type &defragmenter, const type::supplier<buffer::buffer_type> &buffer,
+		const type::supplier<descriptor_set::descriptor_set_type> &set, uint32_t binding,
+		uint32_t array_element, VkDescriptorType descriptor_type, VkDeviceSize offset,
+		VkDeviceSize range) {
+	std::lock_guard<std::mutex> lock(defragmenter.mutex);
+	internal::find_or_add(defragmenter.buffers, buffer).descriptors.push_back(
+		internal::descriptor_type{ set, binding, array_element, descriptor_type, offset,
+			range });
+}
+
+void remove(defragmenter_type &defragmenter, const buffer::buffer_type &buffer) {
+	std::lock_guard<std::mutex> lock(defragmenter.mutex);
+	defragmenter.buffers.erase(std::remove_if(defragmenter.buffers.begin(),
+		defragmenter.buffers.end(), [&buffer](const internal::buffer_entry_type &entry) {
+			return &*entry.buffer == &buffer;
+		}), defragmenter.buffers.end());
+}
+
+result_type step(defragmenter_type &defragmenter, const queue::queue_type &queue,
+		std::chrono::microseconds budget) {
+	const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+	result_type result{ 0, 0 };
+	std::lock_guard<std::mutex> lock(defragmenter.mutex);
+
+	std::map<const memory::memory_type *, internal::candidate_type> allocations;
+	for (internal::buffer_entry_type &entry : defragmenter.buffers) {
+		const type::supplier<const memory::memory_type> &memory(
+			vcc::internal::get_memory(*entry.buffer));
+		if (memory) {
+			internal::candidate_type &candidate(allocations[&*memory]);
+			candidate.memory = &*memory;
+			candidate.propertyFlags = memory::internal::get_type(*memory).propertyFlags;
+			candidate.size = memory::internal::get_size(*memory);
+			candidate.used += memory::internal::get_memory_requirements(*entry.buffer).size;
+			candidate.entries.push_back(&entry);
+		}
+	}
+	std::vector<internal::candidate_type> candidates;
+	candidates.reserve(allocations.size());
+	{
+		memory::internal::device_memory_type &state(*device::internal::get_memory_state(
+			*vcc::internal::get_parent(queue)));
+		std::lock_guard<std::mutex> state_lock(state.mutex);
+		for (auto &allocation : allocations) {
+			const auto bound(state.allocations.find(
+				vcc::internal::get_instance(*allocation.first)));
+			if (bound != state.allocations.end()) {
+				allocation.second.bound = bound->second.used;
+				candidates.push_back(std::move(allocation.second));
+			}
+		}
+	}
+	internal::select(candidates, defragmenter.max_utilization);
+
+	while (!candidates.empty() && std::chrono::steady_clock::now() - start < budget) {
+		const std::vector<internal::candidate_type> batch(internal::next_batch(candidates,
+			defragmenter.block_size));
+		internal::compact(queue, batch.front().propertyFlags, batch, result);
+	}
+	return result;
+}
+
+}  // namespace defragment
+}  // namespace vcc
@@ -0,0 +1,115 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <iterator>
+#include <vcc/deletion_queue.h>
+
+#if defined(VK_KHR_timeline_semaphore)
+
+namespace vcc {
+namespace deletion_queue {
+
+namespace internal {
+
+// A failing wait, as when the device is lost, counts as complete. Nothing
+// can use the object anymore and the error must not escape the thread.
+bool is_complete(const entry_type &entry, std::chrono::nanoseconds timeout) {
+	try {
+		return progress::wait(*entry.progress, entry.value, timeout) == VK_SUCCESS;
+	} catch (...) {
+		return true;
+	}
+}
+
+void run(const std::shared_ptr<state_type> &state) {
+	for (;;) {
+		entry_type oldest;
+		bool stop;
+		{
+			std::unique_lock<std::mutex> lock(state->mutex);
+			state->retired.wait(lock, [&state]() {
+				return state->stop || !state->entries.empty();
+			});
+			if (state->entries.empty()) {
+				return;
+			}
+			oldest.progress = state->entries.front().progress;
+			oldest.value = state->entries.front().value;
+			stop = state->stop;
+		}
+		// Entries are retired in roughly the order the device completes them,
+		// block on the oldest and then collect everything else completed too.
+		// The timeout bounds how long newly retired entries wait to be looked at.
+		is_complete(oldest, stop ? std::chrono::nanoseconds::max()
+			: std::chrono::nanoseconds(std::chrono::milliseconds(10)));
+		// Checked without holding the mutex, so retiring never waits for the device.
+		std::deque<entry_type> entries;
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			std::swap(entries, state->entries);
+		}
+		std::deque<entry_type> remaining;
+		for (entry_type &entry : entries) {
+			if (!is_complete(entry, std::chrono::nanoseconds(0))) {
+				remaining.push_back(std::move(entry));
+			}
+		}
+		// Destroys the objects of the completed entries.
+		entries.clear();
+		std::lock_guard<std::mutex> lock(state->mutex);
+		state->entries.insert(state->entries.begin(), std::make_move_iterator(remaining.begin()),
+			std::make_move_iterator(remaining.end()));
+	}
+}
+
+queue_type::~queue_type() {
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		state->stop = true;
+	}
+	state->retired.notify_one();
+	if (!thread.joinable()) {
+		return;
+	}
+	if (thread.get_id() == std::this_thread::get_id()) {
+		// A retired object held the last reference to the device, the thread
+		// finishes the remaining entries on the state it shares.
+		thread.detach();
+	} else {
+		thread.join();
+	}
+}
+
+void retire(const device::device_type &device, entry_type &&entry) {
+	if (!entry.progress) {
+		throw vcc_exception("retired objects need a progress value to wait for");
+	}
+	queue_type &queue(*device::internal::get_deletion_queue(device));
+	{
+		std::lock_guard<std::mutex> lock(queue.state->mutex);
+		queue.state->entries.push_back(std::move(entry));
+		if (!queue.thread.joinable()) {
+			queue.thread = std::thread(&run, queue.state);
+		}
+	}
+	queue.state->retired.notify_one();
+}
+
+}  // namespace internal
+
+}  // namespace deletion_queue
+}  // namespace vcc
+
+#endif // VK_KHR_timeline_semaphore
@@ -0,0 +1,183 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#define NOMINMAX
+#include <algorithm>
+#include <vcc/descriptor_allocator.h>
+
+namespace vcc {
+namespace descriptor_allocator {
+
+namespace internal {
+
+// Pools grow geometrically up to this many sets.
+const uint32_t max_sets_per_pool = 1024;
+
+signature_type signature(const std::vector<VkDescriptorPoolSize> &pool_sizes) {
+	signature_type signature;
+	signature.reserve(pool_sizes.size());
+	for (const VkDescriptorPoolSize &size : pool_sizes) {
+		signature.push_back(uint64_t(size.type) << 32 | size.descriptorCount);
+	}
+	return signature;
+}
+
+bool is_exhausted(VkResult result) {
+#if defined(VK_KHR_maintenance1)
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY_KHR) {
+		return true;
+	}
+#endif // VK_KHR_maintenance1
+	// Drivers without VK_KHR_maintenance1 may report anything, like
+	// VK_ERROR_OUT_OF_DEVICE_MEMORY, when a pool runs out.
+	return result == VK_ERROR_FRAGMENTED_POOL || result == VK_ERROR_OUT_OF_DEVICE_MEMORY
+		|| result == VK_ERROR_OUT_OF_HOST_MEMORY;
+}
+
+type::supplier<const descriptor_pool::descriptor_pool_type> create_pool(state_type &state,
+		pool_list_type &list, const std::vector<VkDescriptorPoolSize> &set_sizes) {
+	if (!list.sets_per_pool) {
+		list.sets_per_pool = std::max(state.initial_sets_per_pool, 1u);
+	}
+	std::vector<VkDescriptorPoolSize> pool_sizes;
+	pool_sizes.reserve(set_sizes.size());
+	for (const VkDescriptorPoolSize &size : set_sizes) {
+		pool_sizes.push_back(VkDescriptorPoolSize{ size.type,
+			size.descriptorCount * list.sets_per_pool });
+	}
+	// Layouts without bindings still need a valid pool.
+	if (pool_sizes.empty()) {
+		pool_sizes.push_back(VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLER, 1 });
+	}
+	type::supplier<const descriptor_pool::descriptor_pool_type> pool(
+		std::make_shared<descriptor_pool::descriptor_pool_type>(descriptor_pool::create(
+			state.device, 0, list.sets_per_pool, pool_sizes)));
+	list.sets_per_pool = std::min(2 * list.sets_per_pool, max_sets_per_pool);
+	return pool;
+}
+
+descriptor_set::descriptor_set_type allocate(state_type &state, pool_list_type &list,
+		const descriptor_set_layout::descriptor_set_layout_type &layout) {
+	const VkDescriptorSetLayout layout_instance(vcc::internal::get_instance(layout));
+	VkDescriptorSetAllocateInfo allocate = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, NULL };
+	allocate.descriptorSetCount = 1;
+	allocate.pSetLayouts = &layout_instance;
+	for (;; ++list.current) {
+		const bool created(list.current == list.pools.size());
+		if (created) {
+			list.pools.push_back(create_pool(state, list,
+				descriptor_set_layout::internal::get_pool_sizes(layout)));
+		}
+		const type::supplier<const descriptor_pool::descriptor_pool_type> &pool(
+			list.pools[list.current]);
+		VkDescriptorSet descriptor_set;
+		VkResult result;
+		{
+			std::lock_guard<std::mutex> lock(vcc::internal::get_mutex(*pool));
+			allocate.descriptorPool = vcc::internal::get_instance(*pool);
+			result = vkAllocateDescriptorSets(vcc::internal::get_instance(*state.device),
+				&allocate, &descriptor_set);
+		}
+		if (result == VK_SUCCESS) {
+			return descriptor_set::descriptor_set_type(descriptor_set, pool, state.device);
+		} else if (created || !is_exhausted(result)) {
+			// A new pool has room for the set, so the device is out of memory.
+			VKCHECK(result);
+		}
+	}
+}
+
+// A recycled set of layout, or a new one if there is none.
+descriptor_set::descriptor_set_type take(state_type &state,
+		const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout) {
+	std::lock_guard<std::mutex> lock(state.mutex);
+	free_list_type &free_list(state.free_sets[vcc::internal::get_instance(*layout)]);
+	if (!free_list.layout) {
+		free_list.layout = layout;
+	}
+	if (free_list.sets.empty()) {
+		return allocate(state, state.pools[signature(
+			descriptor_set_layout::internal::get_pool_sizes(*layout))], *layout);
+	}
+	descriptor_set::descriptor_set_type descriptor_set(std::move(free_list.sets.back()));
+	free_list.sets.pop_back();
+	return descriptor_set;
+}
+
+}  // namespace internal
+
+descriptor_allocator_type create(const type::supplier<const device::device_type> &device,
+		uint32_t initial_sets_per_pool) {
+	return descriptor_allocator_type(std::make_shared<internal::state_type>(device,
+		initial_sets_per_pool));
+}
+
+std::shared_ptr<descriptor_set::descriptor_set_type> allocate(
+		descriptor_allocator_type &allocator,
+		const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout) {
+	const VkDescriptorSetLayout layout_instance(vcc::internal::get_instance(*layout));
+	std::unique_ptr<descriptor_set::descriptor_set_type> descriptor_set(
+		new descriptor_set::descriptor_set_type(internal::take(*allocator.state, layout)));
+	const std::shared_ptr<internal::state_type> shared_state(allocator.state);
+	return std::shared_ptr<descriptor_set::descriptor_set_type>(descriptor_set.release(),
+		[shared_state, layout_instance](descriptor_set::descriptor_set_type *descriptor_set) {
+			// Drop what the last writes kept alive.
+			descriptor_set->pre_execute_callbacks.clear();
+			descriptor_set->references.clear();
+			{
+				std::lock_guard<std::mutex> lock(shared_state->mutex);
+				shared_state->free_sets[layout_instance].sets.push_back(
+					std::move(*descriptor_set));
+			}
+			delete descriptor_set;
+		});
+}
+
+descriptor_set::descriptor_set_type allocate_transient(descriptor_allocator_type &allocator,
+		const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout) {
+	internal::state_type &state(*allocator.state);
+	std::lock_guard<std::mutex> lock(state.mutex);
+	return internal::allocate(state, state.transient_pools[internal::signature(
+		descriptor_set_layout::internal::get_pool_sizes(*layout))], *layout);
+}
+
+void reset(descriptor_allocator_type &allocator) {
+	internal::state_type &state(*allocator.state);
+	std::lock_guard<std::mutex> lock(state.mutex);
+	for (std::pair<const internal::signature_type, internal::pool_list_type> &list
+			: state.transient_pools) {
+		for (std::size_t i = 0; i < list.second.pools.size() && i <= list.second.current; ++i) {
+			const descriptor_pool::descriptor_pool_type &pool(*list.second.pools[i]);
+			std::lock_guard<std::mutex> pool_lock(vcc::internal::get_mutex(pool));
+			VKCHECK(vkResetDescriptorPool(vcc::internal::get_instance(*state.device),
+				vcc::internal::get_instance(pool), 0));
+		}
+		list.second.current = 0;
+	}
+}
+
+#if defined(VK_KHR_timeline_semaphore)
+
+void reset(descriptor_allocator_type &allocator, const progress::progress_type &progress,
+		uint64_t value) {
+	progress::wait(progress, value);
+	reset(allocator);
+}
+
+#endif // VK_KHR_timeline_semaphore
+
+}  // namespace descriptor_allocator
+}  // namespace vcc
@@ -0,0 +1,145 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cstdint>
+#include <vcc/descriptor_cache.h>
+
+namespace vcc {
+namespace descriptor_cache {
+
+namespace internal {
+
+template<typename T>
+uint64_t address(const type::supplier<T> &supplier) {
+	return supplier ? uint64_t(uintptr_t(&*supplier)) : 0;
+}
+
+key_type key(const descriptor_set_layout::descriptor_set_layout_type &layout,
+		const std::vector<binding_type> &bindings) {
+	key_type key;
+	key.push_back(uint64_t(uintptr_t(&layout)));
+	for (const binding_type &binding : bindings) {
+		key.push_back(uint64_t(binding.binding) << 32 | binding.array_element);
+		key.push_back(binding.descriptor_type);
+		// Tells the lists apart, like buffers from data buffers.
+		key.push_back(uint64_t(binding.images.size()) << 48
+			| uint64_t(binding.buffers.size()) << 32
+			| uint64_t(binding.data_buffers.size()) << 16
+			| binding.buffer_views.size());
+		for (const descriptor_set::image_info &info : binding.images) {
+			key.push_back(address(info.sampler));
+			key.push_back(address(info.image_view));
+			key.push_back(info.image_layout);
+		}
+		for (const descriptor_set::buffer_info_type &info : binding.buffers) {
+			key.push_back(address(info.buffer));
+			key.push_back(info.offset);
+			key.push_back(info.range);
+		}
+		for (const descriptor_set::buffer_info_data_type &info : binding.data_buffers) {
+			key.push_back(address(info.buffer));
+			key.push_back(info.offset);
+			key.push_back(info.range);
+		}
+		for (const type::supplier<const buffer_view::buffer_view_type> &view
+				: binding.buffer_views) {
+			key.push_back(address(view));
+		}
+	}
+	return key;
+}
+
+void write(const device::device_type &device, descriptor_set::descriptor_set_type &set,
+		const std::vector<binding_type> &bindings) {
+	descriptor_set::internal::update_storage storage;
+	for (const binding_type &binding : bindings) {
+		if (!binding.images.empty()) {
+			descriptor_set::internal::add(storage, descriptor_set::write_image{ set,
+				binding.binding, binding.array_element, binding.descriptor_type,
+				binding.images });
+		} else if (!binding.buffers.empty()) {
+			descriptor_set::internal::add(storage, descriptor_set::write_buffer_type{ set,
+				binding.binding, binding.array_element, binding.descriptor_type,
+				binding.buffers });
+		} else if (!binding.data_buffers.empty()) {
+			descriptor_set::internal::add(storage, descriptor_set::write_buffer_data_type{
+				set, binding.binding, binding.array_element, binding.descriptor_type,
+				binding.data_buffers });
+		} else if (!binding.buffer_views.empty()) {
+			descriptor_set::internal::add(storage, descriptor_set::write_buffer_view_type{
+				set, binding.binding, binding.array_element, binding.descriptor_type,
+				binding.buffer_views });
+		}
+	}
+	// The set is not shared yet, so it needs no lock.
+	VKTRACE(vkUpdateDescriptorSets(vcc::internal::get_instance(device),
+		(uint32_t)storage.write_sets.size(), storage.write_sets.data(), 0, NULL));
+}
+
+}  // namespace internal
+
+descriptor_cache_type create(const type::supplier<const device::device_type> &device,
+		uint32_t initial_sets_per_pool) {
+	return descriptor_cache_type(device,
+		descriptor_allocator::create(device, initial_sets_per_pool),
+		std::unique_ptr<internal::state_type>(new internal::state_type()));
+}
+
+std::shared_ptr<const descriptor_set::descriptor_set_type> get(descriptor_cache_type &cache,
+		const type::supplier<const descriptor_set_layout::descriptor_set_layout_type> &layout,
+		const std::vector<binding_type> &bindings) {
+	internal::state_type &state(*cache.state);
+	internal::key_type key(internal::key(*layout, bindings));
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		const auto it(state.entries.find(key));
+		if (it != state.entries.end()) {
+			it->second.last_used = state.frame;
+			return it->second.descriptor_set;
+		}
+	}
+	// Written without the lock, other threads keep hitting the cache.
+	const std::shared_ptr<descriptor_set::descriptor_set_type> descriptor_set(
+		descriptor_allocator::allocate(cache.allocator, layout));
+	internal::write(*cache.device, *descriptor_set, bindings);
+	std::lock_guard<std::mutex> lock(state.mutex);
+	// Another thread may have written the same set meanwhile, ours is recycled.
+	const auto inserted(state.entries.emplace(std::move(key),
+		internal::entry_type{ layout, descriptor_set, state.frame }));
+	inserted.first->second.last_used = state.frame;
+	return inserted.first->second.descriptor_set;
+}
+
+void end_frame(descriptor_cache_type &cache, uint32_t max_unused_frames) {
+	internal::state_type &state(*cache.state);
+	std::lock_guard<std::mutex> lock(state.mutex);
+	++state.frame;
+	for (auto it(state.entries.begin()); it != state.entries.end();) {
+		if (state.frame - it->second.last_used > max_unused_frames) {
+			it = state.entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void clear(descriptor_cache_type &cache) {
+	internal::state_type &state(*cache.state);
+	std::lock_guard<std::mutex> lock(state.mutex);
+	state.entries.clear();
+}
+
+}  // namespace descriptor_cache
+}  // namespace vcc
@@ -27,8 +27,8 @@ descriptor_pool_type create(const type::supplier<const device::device_type> &dev
 	create.poolSizeCount = (uint32_t) poolSizes.size();
 	create.pPoolSizes = poolSizes.empty() ? NULL : &poolSizes.front();
 	VkDescriptorPool descriptor_pool;
-	VKCHECK(vkCreateDescriptorPool(vcc::internal::get_instance(*device), &create, NULL,
-		&descriptor_pool));
+	VKCHECK(vkCreateDescriptorPool(vcc::internal::get_instance(*device), &create,
+		vcc::internal::get_allocator(*device), &descriptor_pool));
 	return descriptor_pool_type(descriptor_pool, device, flags);
 }
 
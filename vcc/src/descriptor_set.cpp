@@ -66,6 +66,7 @@ void add(update_storage &storage, const copy &c) {
 	set.dstArrayElement = c.dst_array_element;
 	set.descriptorCount = c.descriptor_count;
 	storage.copy_sets.push_back(set);
+	++c.dst_set.revision;
 	for (uint32_t i = 0; i < c.descriptor_count; ++i) {
 		c.dst_set.references.clone(std::pair<uint32_t, uint32_t>{ c.dst_binding, uint32_t(c.dst_array_element + i) }, c.src_set.references);
 	}
@@ -91,6 +92,7 @@ void add(update_storage &storage, const write_image &write) {
 	set.pImageInfo = image_infos.data();
 	storage.image_infos.push_back(std::move(image_infos));
 	storage.write_sets.push_back(set);
+	++write.dst_set.revision;
 	for (uint32_t i = 0; i < write.images.size(); ++i) {
 		write.dst_set.references.put(std::pair<uint32_t, uint32_t>{
 			write.dst_binding, uint32_t(write.dst_array_element + i) },
@@ -113,6 +115,7 @@ void add(update_storage &storage, const write_buffer_type &write) {
 	set.pBufferInfo = buffer_infos.data();
 	storage.buffer_infos.push_back(std::move(buffer_infos));
 	storage.write_sets.push_back(set);
+	++write.dst_set.revision;
 	for (uint32_t i = 0; i < write.buffers.size(); ++i) {
 		write.dst_set.references.put(
 			std::make_pair(write.dst_binding, uint32_t(write.dst_array_element + i)),
@@ -153,6 +156,7 @@ void add(update_storage &storage, const write_buffer_view_type &write) {
 	set.pTexelBufferView = buffer_views.data();
 	storage.buffer_view.push_back(std::move(buffer_views));
 	storage.write_sets.push_back(set);
+	++write.dst_set.revision;
 	for (uint32_t i = 0; i < write.buffers.size(); ++i) {
 		write.dst_set.references.put(std::make_pair(write.dst_binding, uint32_t(write.dst_array_element + i)),
 			write.buffers[i]);
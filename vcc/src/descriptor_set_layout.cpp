@@ -15,6 +15,7 @@
 */
 #include <algorithm>
 #include <iterator>
+#include <map>
 #include <vcc/descriptor_set_layout.h>
 
 namespace vcc {
@@ -37,7 +38,7 @@ std::pair<std::vector<VkDescriptorSetLayoutBinding>, std::vector<std::vector<VkS
 		std::transform(binding.immutableSamplers.begin(), binding.immutableSamplers.end(),
 			std::back_inserter(samplers),
 			[](const type::supplier<const sampler::sampler_type> &sampler) {
-				return internal::get_instance(*sampler);
+				return vcc::internal::get_instance(*sampler);
 			});
 		converted_binding.pImmutableSamplers = samplers.data();
 		converted_bindings.emplace_back(converted_binding);
@@ -46,19 +47,59 @@ std::pair<std::vector<VkDescriptorSetLayoutBinding>, std::vector<std::vector<VkS
 	return std::make_pair(std::move(converted_bindings), std::move(converted_samplers));
 }
 
-descriptor_set_layout_type create(const type::supplier<const device::device_type> &device,
+std::vector<VkDescriptorPoolSize> pool_sizes(
 		const std::vector<descriptor_set_layout_binding> &bindings) {
+	std::map<VkDescriptorType, uint32_t> counts;
+	for (const descriptor_set_layout_binding &binding : bindings) {
+		counts[binding.descriptorType] += binding.descriptorCount;
+	}
+	std::vector<VkDescriptorPoolSize> pool_sizes;
+	pool_sizes.reserve(counts.size());
+	for (const std::pair<const VkDescriptorType, uint32_t> &count : counts) {
+		pool_sizes.push_back(VkDescriptorPoolSize{ count.first, count.second });
+	}
+	return pool_sizes;
+}
+
+VkDescriptorSetLayout create_layout(const device::device_type &device,
+		const std::vector<descriptor_set_layout_binding> &bindings,
+		VkDescriptorSetLayoutCreateFlags flags, const void *next) {
 	VkDescriptorSetLayoutCreateInfo create = {
-		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, NULL, 0 };
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, next, flags };
 	create.bindingCount = (uint32_t) bindings.size();
 	std::vector<VkDescriptorSetLayoutBinding> converted_bindings;
 	std::vector<std::vector<VkSampler>> converted_samplers;
 	std::tie(converted_bindings, converted_samplers) = (convert_bindings(bindings));
 	create.pBindings = converted_bindings.data();
 	VkDescriptorSetLayout layout;
-	VKCHECK(vkCreateDescriptorSetLayout(internal::get_instance(*device), &create, NULL, &layout));
-	return descriptor_set_layout_type(layout, device);
+	VKCHECK(vkCreateDescriptorSetLayout(vcc::internal::get_instance(device), &create,
+		vcc::internal::get_allocator(device), &layout));
+	return layout;
+}
+
+descriptor_set_layout_type create(const type::supplier<const device::device_type> &device,
+		const std::vector<descriptor_set_layout_binding> &bindings) {
+	return descriptor_set_layout_type(create_layout(*device, bindings, 0, NULL), device,
+		pool_sizes(bindings));
+}
+
+#if defined(VK_EXT_descriptor_indexing)
+
+descriptor_set_layout_type create(const type::supplier<const device::device_type> &device,
+		const std::vector<descriptor_set_layout_binding> &bindings,
+		VkDescriptorSetLayoutCreateFlags flags,
+		const std::vector<VkDescriptorBindingFlagsEXT> &binding_flags) {
+	if (binding_flags.size() != bindings.size()) {
+		throw vcc_exception("binding_flags must have one element per binding");
+	}
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flags_create = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT, NULL,
+		(uint32_t) binding_flags.size(), binding_flags.data() };
+	return descriptor_set_layout_type(create_layout(*device, bindings, flags, &flags_create),
+		device, pool_sizes(bindings));
 }
 
+#endif // VK_EXT_descriptor_indexing
+
 }  // namespace descriptor_set_layout
 }  // namespace vcc
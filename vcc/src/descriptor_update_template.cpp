@@ -0,0 +1,104 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <vcc/descriptor_update_template.h>
+
+namespace vcc {
+namespace descriptor_update_template {
+
+#if defined(VK_KHR_descriptor_update_template)
+
+namespace internal {
+
+// The extension function, or the core one on Vulkan 1.1 devices without
+// the extension enabled.
+PFN_vkVoidFunction load(VkDevice device, const char *extension_name,
+		const char *core_name) {
+	PFN_vkVoidFunction function(vkGetDeviceProcAddr(device, extension_name));
+#if defined(VK_VERSION_1_1)
+	if (!function) {
+		function = vkGetDeviceProcAddr(device, core_name);
+	}
+#endif // VK_VERSION_1_1
+	return function;
+}
+
+}  // namespace internal
+
+void descriptor_update_template_type::destroy() {
+	if (vcc::internal::get_instance(*this)) {
+		const device::device_type &device(*vcc::internal::get_parent(*this));
+		destroy_template(vcc::internal::get_instance(device),
+			vcc::internal::get_instance(*this), vcc::internal::get_allocator(device));
+	}
+}
+
+descriptor_update_template_type &descriptor_update_template_type::operator=(
+		descriptor_update_template_type &&copy) {
+	destroy();
+	movable_with_parent::operator=(std::move(copy));
+	destroy_template = copy.destroy_template;
+	update_with_template = copy.update_with_template;
+	return *this;
+}
+
+descriptor_update_template_type::~descriptor_update_template_type() {
+	destroy();
+}
+
+descriptor_update_template_type create(
+		const type::supplier<const device::device_type> &device,
+		const descriptor_set_layout::descriptor_set_layout_type &layout,
+		const std::vector<VkDescriptorUpdateTemplateEntryKHR> &entries) {
+	const VkDevice instance(vcc::internal::get_instance(*device));
+	const PFN_vkCreateDescriptorUpdateTemplateKHR create_template(
+		(PFN_vkCreateDescriptorUpdateTemplateKHR) internal::load(instance,
+			"vkCreateDescriptorUpdateTemplateKHR", "vkCreateDescriptorUpdateTemplate"));
+	const PFN_vkDestroyDescriptorUpdateTemplateKHR destroy_template(
+		(PFN_vkDestroyDescriptorUpdateTemplateKHR) internal::load(instance,
+			"vkDestroyDescriptorUpdateTemplateKHR", "vkDestroyDescriptorUpdateTemplate"));
+	const PFN_vkUpdateDescriptorSetWithTemplateKHR update_with_template(
+		(PFN_vkUpdateDescriptorSetWithTemplateKHR) internal::load(instance,
+			"vkUpdateDescriptorSetWithTemplateKHR", "vkUpdateDescriptorSetWithTemplate"));
+	if (!create_template || !destroy_template || !update_with_template) {
+		throw vcc_exception("VK_KHR_descriptor_update_template is not enabled");
+	}
+	VkDescriptorUpdateTemplateCreateInfoKHR create = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR, NULL, 0 };
+	create.descriptorUpdateEntryCount = (uint32_t)entries.size();
+	create.pDescriptorUpdateEntries = entries.data();
+	create.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+	create.descriptorSetLayout = vcc::internal::get_instance(layout);
+	VkDescriptorUpdateTemplateKHR update_template;
+	VKCHECK(create_template(instance, &create, vcc::internal::get_allocator(*device),
+		&update_template));
+	return descriptor_update_template_type(update_template, device, destroy_template,
+		update_with_template);
+}
+
+void update(const descriptor_update_template_type &update_template,
+		descriptor_set::descriptor_set_type &descriptor_set, const void *data) {
+	std::lock_guard<std::mutex> lock(vcc::internal::get_mutex(descriptor_set));
+	++descriptor_set.revision;
+	VKTRACE(update_template.update_with_template(
+		vcc::internal::get_instance(*vcc::internal::get_parent(update_template)),
+		vcc::internal::get_instance(descriptor_set),
+		vcc::internal::get_instance(update_template), data));
+}
+
+#endif // VK_KHR_descriptor_update_template
+
+}  // namespace descriptor_update_template
+}  // namespace vcc
@@ -15,7 +15,10 @@
 */
 #include <algorithm>
 #include <iterator>
+#include <vcc/deletion_queue.h>
 #include <vcc/device.h>
+#include <vcc/memory.h>
+#include <vcc/transient.h>
 
 namespace vcc {
 namespace device {
@@ -34,10 +37,62 @@ std::vector<VkDeviceQueueCreateInfo> convert(const std::vector<queue_create_info
 	return converted;
 }
 
+namespace internal {
+
+void check_movable(const device_type &device) {
+	const std::shared_ptr<transient::internal::device_pool_type> &pool(
+		get_transient_pool(device));
+	if (pool) {
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		if (pool->used) {
+			throw vcc_exception("a device can not be moved once transient objects were acquired");
+		}
+	}
+}
+
+// The extension function, or the core one on Vulkan 1.2 devices without
+// the extension enabled. Null if neither is available.
+PFN_vkVoidFunction load_function(VkDevice device, const char *extension_name,
+		const char *core_name) {
+	PFN_vkVoidFunction function(vkGetDeviceProcAddr(device, extension_name));
+#if defined(VK_VERSION_1_2)
+	if (!function) {
+		function = vkGetDeviceProcAddr(device, core_name);
+	}
+#endif // VK_VERSION_1_2
+	return function;
+}
+
+}  // namespace internal
+
+device_type::device_type(device_type &&copy) {
+	internal::check_movable(copy);
+	movable_destructible::operator=(std::move(copy));
+	physical_device = std::move(copy.physical_device);
+	functions = copy.functions;
+	transient_pool = std::move(copy.transient_pool);
+	memory_state = std::move(copy.memory_state);
+	deletion_queue = std::move(copy.deletion_queue);
+}
+
+device_type &device_type::operator=(device_type &&copy) {
+	internal::check_movable(copy);
+	// Release the retired objects and the transient pool before the VkDevice
+	// they were created from.
+	deletion_queue = std::move(copy.deletion_queue);
+	transient_pool = std::move(copy.transient_pool);
+	movable_destructible::operator=(std::move(copy));
+	physical_device = std::move(copy.physical_device);
+	functions = copy.functions;
+	memory_state = std::move(copy.memory_state);
+	return *this;
+}
+
 device_type create(VkPhysicalDevice physical_device, const std::vector<queue_create_info_type> &queue_create_info,
 		const std::set<std::string> &layers, const std::set<std::string> &extensions,
-		const VkPhysicalDeviceFeatures &features) {
-	VkDeviceCreateInfo create_info = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO, NULL, 0};
+		const VkPhysicalDeviceFeatures &features, const VkAllocationCallbacks *allocator,
+		const void *next) {
+	VkDeviceCreateInfo create_info = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO, next, 0};
 	const std::vector<VkDeviceQueueCreateInfo> converted(convert(queue_create_info));
 	create_info.queueCreateInfoCount = (uint32_t)converted.size();
 	create_info.pQueueCreateInfos = converted.empty() ? NULL : &converted.front();
@@ -49,12 +104,39 @@ device_type create(VkPhysicalDevice physical_device, const std::vector<queue_cre
 	create_info.ppEnabledExtensionNames = extension_pointers.empty() ? NULL : &extension_pointers.front();
 	create_info.pEnabledFeatures = &features;
 	VkDevice device;
-	VKCHECK(vkCreateDevice(physical_device, &create_info, NULL, &device));
-	return device_type(device, physical_device);
+	VKCHECK(vkCreateDevice(physical_device, &create_info, allocator, &device));
+	std::shared_ptr<memory::internal::device_memory_type> memory_state(
+		std::make_shared<memory::internal::device_memory_type>());
+#if defined(VK_KHR_dedicated_allocation) && defined(VK_KHR_get_memory_requirements2)
+	if (extensions.count(VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME)
+			&& extensions.count(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME)) {
+		memory_state->get_image_memory_requirements2 =
+			(PFN_vkGetImageMemoryRequirements2KHR) vkGetDeviceProcAddr(device,
+				"vkGetImageMemoryRequirements2KHR");
+		memory_state->get_buffer_memory_requirements2 =
+			(PFN_vkGetBufferMemoryRequirements2KHR) vkGetDeviceProcAddr(device,
+				"vkGetBufferMemoryRequirements2KHR");
+	}
+#endif // VK_KHR_dedicated_allocation
+	internal::functions_type functions;
+#if defined(VK_KHR_draw_indirect_count)
+	functions.draw_indirect_count = (PFN_vkCmdDrawIndirectCountKHR)
+		internal::load_function(device, "vkCmdDrawIndirectCountKHR", "vkCmdDrawIndirectCount");
+	functions.draw_indexed_indirect_count = (PFN_vkCmdDrawIndexedIndirectCountKHR)
+		internal::load_function(device, "vkCmdDrawIndexedIndirectCountKHR",
+			"vkCmdDrawIndexedIndirectCount");
+#endif // VK_KHR_draw_indirect_count
+	std::shared_ptr<deletion_queue::internal::queue_type> retired;
+#if defined(VK_KHR_timeline_semaphore)
+	retired = std::make_shared<deletion_queue::internal::queue_type>();
+#endif // VK_KHR_timeline_semaphore
+	return device_type(device, allocator, physical_device, functions,
+		std::make_shared<transient::internal::device_pool_type>(), memory_state,
+		retired);
 }
 
 void wait_idle(const device_type &device) {
-	VKCHECK(vkDeviceWaitIdle(internal::get_instance(device)));
+	VKCHECK(vkDeviceWaitIdle(vcc::internal::get_instance(device)));
 }
 
 }  // namespace device
@@ -21,7 +21,8 @@ namespace event {
 event_type create(const type::supplier<const device::device_type> &device) {
 	VkEventCreateInfo create = {VK_STRUCTURE_TYPE_EVENT_CREATE_INFO, NULL, 0};
 	VkEvent event;
-	VKCHECK(vkCreateEvent(internal::get_instance(*device), &create, NULL, &event));
+	VKCHECK(vkCreateEvent(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &event));
 	return event_type(event, device);
 }
 
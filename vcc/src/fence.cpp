@@ -23,7 +23,8 @@ fence_type create(const type::supplier<const device::device_type> &device,
 	VkFenceCreateInfo create = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, NULL};
 	create.flags = flags;
 	VkFence fence;
-	VKCHECK(vkCreateFence(internal::get_instance(*device), &create, NULL, &fence));
+	VKCHECK(vkCreateFence(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &fence));
 	return fence_type(fence, device);
 }
 
@@ -41,7 +41,8 @@ framebuffer_type create(const type::supplier<const device::device_type> &device,
 	create.height = extent.height;
 	create.layers = layers;
 	VkFramebuffer framebuffer;
-	VKCHECK(vkCreateFramebuffer(internal::get_instance(*device), &create, NULL, &framebuffer));
+	VKCHECK(vkCreateFramebuffer(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &framebuffer));
 	return framebuffer_type(framebuffer, device, render_pass, image_views);
 }
 
@@ -0,0 +1,453 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <algorithm>
+#include <vcc/graph.h>
+
+namespace vcc {
+namespace graph {
+
+namespace internal {
+
+VkImageSubresourceRange whole_range(const resource_info_type &resource) {
+	return { resource.image_description.aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0,
+		VK_REMAINING_ARRAY_LAYERS };
+}
+
+VkDeviceSize align(VkDeviceSize offset, VkDeviceSize alignment) {
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+void add_access(std::vector<resource_info_type> &resources, std::vector<pass_info_type> &passes,
+		pass_type pass, const access_type &access) {
+	if (pass >= passes.size() || access.resource >= resources.size()) {
+		throw vcc_exception("pass or resource not part of the graph");
+	}
+	passes[pass].accesses.push_back(access);
+}
+
+std::vector<bool> cull(const std::vector<resource_info_type> &resources,
+		const std::vector<pass_info_type> &passes) {
+	std::vector<bool> keep(passes.size()), needed(resources.size());
+	for (std::size_t i = passes.size(); i--;) {
+		const pass_info_type &pass(passes[i]);
+		keep[i] = !!(pass.flags & pass_side_effect_bit);
+		for (const access_type &access : pass.accesses) {
+			if (access.write && (resources[access.resource].imported
+					|| needed[access.resource])) {
+				keep[i] = true;
+			}
+		}
+		if (!keep[i]) {
+			continue;
+		}
+		for (const access_type &access : pass.accesses) {
+			if (access.write) {
+				needed[access.resource] = false;
+			}
+		}
+		for (const access_type &access : pass.accesses) {
+			if (!access.write) {
+				needed[access.resource] = true;
+			}
+		}
+	}
+	return keep;
+}
+
+std::vector<int> assign_levels(const std::vector<resource_info_type> &resources,
+		const std::vector<pass_info_type> &passes, const std::vector<bool> &keep,
+		std::vector<usage_type> &usages) {
+	usages.resize(resources.size());
+	for (std::size_t i = 0; i < usages.size(); ++i) {
+		usages[i] = usage_type{ -1, -1, -1, -1, resources[i].imported
+			? resources[i].initial_layout : VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, 0, 0 };
+	}
+	std::vector<int> levels(passes.size(), -1);
+	for (std::size_t i = 0; i < passes.size(); ++i) {
+		if (!keep[i]) {
+			continue;
+		}
+		const pass_info_type &pass(passes[i]);
+		int level(0);
+		for (const access_type &access : pass.accesses) {
+			const usage_type &usage(usages[access.resource]);
+			level = std::max(level, usage.last_write + 1);
+			if (access.write || (resources[access.resource].is_image
+					&& access.layout != usage.layout)) {
+				level = std::max(level, usage.last_read + 1);
+			}
+		}
+		for (const access_type &access : pass.accesses) {
+			usage_type &usage(usages[access.resource]);
+			if (access.write || (resources[access.resource].is_image
+					&& access.layout != usage.layout)) {
+				usage.last_write = level;
+				usage.last_read = -1;
+			} else {
+				usage.last_read = std::max(usage.last_read, level);
+			}
+			if (usage.first == -1) {
+				usage.first = level;
+			}
+			if (usage.first == level) {
+				usage.first_stages |= access.stage;
+				usage.first_access |= access.access;
+			}
+			usage.last = level;
+			usage.layout = access.final_layout;
+			usage.stages |= access.stage;
+			if (access.write) {
+				usage.write_access |= access.access;
+			}
+		}
+		levels[i] = level;
+	}
+	return levels;
+}
+
+bool overlaps(const usage_type &lhs, const usage_type &rhs) {
+	return lhs.first <= rhs.last && rhs.first <= lhs.last;
+}
+
+bool overlaps(const placement_type &lhs, const placement_type &rhs) {
+	return lhs.offset < rhs.offset + rhs.size && rhs.offset < lhs.offset + lhs.size;
+}
+
+VkDeviceSize place(const std::vector<usage_type> &usages,
+		const std::vector<VkMemoryRequirements> &requirements,
+		VkDeviceSize granularity, std::vector<placement_type> &placements) {
+	std::sort(placements.begin(), placements.end(),
+		[&requirements](const placement_type &lhs, const placement_type &rhs) {
+			return requirements[lhs.resource].size > requirements[rhs.resource].size;
+		});
+	VkDeviceSize size(0);
+	for (std::size_t i = 0; i < placements.size(); ++i) {
+		placement_type &placement(placements[i]);
+		const VkMemoryRequirements &requirement(requirements[placement.resource]);
+		// Linear and optimal resources never share a granularity page.
+		const VkDeviceSize alignment(std::max(requirement.alignment, granularity));
+		placement.size = align(requirement.size, granularity);
+		std::vector<placement_type> alive;
+		for (std::size_t j = 0; j < i; ++j) {
+			if (overlaps(usages[placements[j].resource], usages[placement.resource])) {
+				alive.push_back(placements[j]);
+			}
+		}
+		std::sort(alive.begin(), alive.end(),
+			[](const placement_type &lhs, const placement_type &rhs) {
+				return lhs.offset < rhs.offset;
+			});
+		VkDeviceSize offset(0);
+		for (const placement_type &other : alive) {
+			if (align(offset, alignment) + placement.size <= other.offset) {
+				break;
+			}
+			offset = std::max(offset, other.offset + other.size);
+		}
+		placement.offset = align(offset, alignment);
+		size = std::max(size, placement.offset + placement.size);
+	}
+	return size;
+}
+
+void track(tracking::internal::tracker_type &tracker, const resource_info_type &resource,
+		VkPipelineStageFlags stage, VkAccessFlags access, VkImageLayout layout) {
+	if (resource.is_image) {
+		tracking::internal::access(tracker, vcc::internal::get_instance(*resource.image),
+			image::get_mip_levels(*resource.image), image::get_array_layers(*resource.image),
+			whole_range(resource), stage, access, layout);
+	} else {
+		tracking::internal::access(tracker, vcc::internal::get_instance(*resource.buffer),
+			buffer::get_size(*resource.buffer), 0, VK_WHOLE_SIZE, stage, access);
+	}
+}
+
+// Render passes change layouts without the tracker seeing it.
+void declare_final_layouts(tracking::internal::tracker_type &tracker,
+		const std::vector<resource_info_type> &resources, const pass_info_type &pass) {
+	for (const access_type &access : pass.accesses) {
+		const resource_info_type &resource(resources[access.resource]);
+		if (resource.is_image && access.final_layout != access.layout) {
+			tracking::internal::declare(tracker, vcc::internal::get_instance(*resource.image),
+				image::get_mip_levels(*resource.image), image::get_array_layers(*resource.image),
+				whole_range(resource), access.stage, access.access, access.final_layout);
+		}
+	}
+}
+
+void execute(const compiled_type &graph, command::build_type &build,
+		parallel::recorder_type *recorder) {
+	if (!command::internal::get_tracker(build)) {
+		command::internal::cmd(build, command::track(tracking::automatic));
+	}
+	tracking::internal::tracker_type &tracker(*command::internal::get_tracker(build));
+	const VkCommandBuffer command_buffer(vcc::internal::get_instance(
+		command::internal::get_command_buffer(build)));
+
+	for (const resource_info_type &resource : graph.resources) {
+		if (resource.is_image && resource.image) {
+			command::internal::get_references(build).add(resource.image);
+			if (resource.imported) {
+				tracking::internal::declare(tracker,
+					vcc::internal::get_instance(*resource.image),
+					image::get_mip_levels(*resource.image),
+					image::get_array_layers(*resource.image), whole_range(resource),
+					resource.initial_stages, resource.initial_access, resource.initial_layout);
+			}
+		} else if (!resource.is_image && resource.buffer) {
+			command::internal::get_references(build).add(resource.buffer);
+		}
+	}
+
+	for (const level_type &level : graph.levels) {
+		for (std::size_t index : level.passes) {
+			for (const access_type &access : graph.passes[index].accesses) {
+				track(tracker, graph.resources[access.resource], access.stage, access.access,
+					access.layout);
+			}
+		}
+		if (level.alias_barrier.dst_stages) {
+			tracker.src_stages |= level.alias_barrier.src_stages;
+			tracker.src_access |= level.alias_barrier.src_access;
+			tracker.dst_stages |= level.alias_barrier.dst_stages;
+			tracker.dst_access |= level.alias_barrier.dst_access;
+		}
+		// One barrier for every pass of the level.
+		tracking::internal::flush(tracker, command_buffer,
+			graph.passes[level.passes.front()].name.c_str());
+
+		std::vector<std::size_t> parallel_passes;
+		for (std::size_t index : level.passes) {
+			const pass_info_type &pass(graph.passes[index]);
+			if (recorder && (pass.flags & pass_parallel_bit)) {
+				parallel_passes.push_back(index);
+			} else {
+				pass.callback(build, graph);
+				declare_final_layouts(tracker, graph.resources, pass);
+			}
+		}
+		if (parallel_passes.size() == 1) {
+			graph.passes[parallel_passes.front()].callback(build, graph);
+		} else if (!parallel_passes.empty()) {
+			command::internal::cmd(build, parallel::record(*recorder, parallel_passes.size(),
+				[&graph, &parallel_passes](command::build_type &secondary, std::size_t first,
+						std::size_t last) {
+					for (std::size_t i = first; i < last; ++i) {
+						graph.passes[parallel_passes[i]].callback(secondary, graph);
+					}
+				}));
+		}
+		for (std::size_t index : parallel_passes) {
+			declare_final_layouts(tracker, graph.resources, graph.passes[index]);
+		}
+	}
+
+	for (const resource_info_type &resource : graph.resources) {
+		if (resource.imported && resource.is_image
+				&& resource.final_layout != VK_IMAGE_LAYOUT_UNDEFINED) {
+			track(tracker, resource, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				resource.final_layout);
+		}
+	}
+	tracking::internal::flush(tracker, command_buffer, "the end of the graph");
+}
+
+}  // namespace internal
+
+resource_type import_buffer(graph_type &graph,
+		const type::supplier<const buffer::buffer_type> &buffer) {
+	internal::resource_info_type resource = {};
+	resource.buffer = buffer;
+	resource.imported = true;
+	graph.resources.push_back(std::move(resource));
+	return resource_type(graph.resources.size() - 1);
+}
+
+resource_type import_image(graph_type &graph,
+		const type::supplier<const image::image_type> &image, VkImageAspectFlags aspectMask,
+		VkImageLayout initial_layout, VkPipelineStageFlags initial_stages,
+		VkAccessFlags initial_access, VkImageLayout final_layout) {
+	internal::resource_info_type resource = {};
+	resource.image = image;
+	resource.is_image = true;
+	resource.imported = true;
+	resource.image_description.aspectMask = aspectMask;
+	resource.initial_layout = initial_layout;
+	resource.initial_stages = initial_stages;
+	resource.initial_access = initial_access;
+	resource.final_layout = final_layout;
+	graph.resources.push_back(std::move(resource));
+	return resource_type(graph.resources.size() - 1);
+}
+
+resource_type create_buffer(graph_type &graph, const buffer_description_type &description) {
+	internal::resource_info_type resource = {};
+	resource.buffer_description = description;
+	graph.resources.push_back(std::move(resource));
+	return resource_type(graph.resources.size() - 1);
+}
+
+resource_type create_image(graph_type &graph, const image_description_type &description) {
+	internal::resource_info_type resource = {};
+	resource.is_image = true;
+	resource.image_description = description;
+	graph.resources.push_back(std::move(resource));
+	return resource_type(graph.resources.size() - 1);
+}
+
+pass_type add_pass(graph_type &graph, const std::string &name,
+		const record_callback_type &callback, pass_flags flags) {
+	graph.passes.push_back(internal::pass_info_type{ name,
+		std::vector<internal::access_type>(), callback, flags });
+	return pass_type(graph.passes.size() - 1);
+}
+
+void read(graph_type &graph, pass_type pass, resource_type resource,
+		VkPipelineStageFlags stage, VkAccessFlags access, VkImageLayout layout) {
+	internal::add_access(graph.resources, graph.passes, pass,
+		internal::access_type{ resource, stage, access, layout, layout, false });
+}
+
+void write(graph_type &graph, pass_type pass, resource_type resource,
+		VkPipelineStageFlags stage, VkAccessFlags access, VkImageLayout layout,
+		VkImageLayout final_layout) {
+	internal::add_access(graph.resources, graph.passes, pass,
+		internal::access_type{ resource, stage, access, layout,
+			final_layout == VK_IMAGE_LAYOUT_UNDEFINED ? layout : final_layout, true });
+}
+
+compiled_type compile(const type::supplier<const device::device_type> &device,
+		const graph_type &graph) {
+	compiled_type compiled;
+	compiled.resources = graph.resources;
+	const std::vector<bool> keep(internal::cull(graph.resources, graph.passes));
+
+	std::vector<internal::usage_type> usages;
+	const std::vector<int> levels(internal::assign_levels(graph.resources, graph.passes, keep,
+		usages));
+	std::vector<int> pass_levels;
+	for (std::size_t i = 0; i < graph.passes.size(); ++i) {
+		if (keep[i]) {
+			compiled.passes.push_back(graph.passes[i]);
+			pass_levels.push_back(levels[i]);
+		}
+	}
+	int level_count(0);
+	for (int level : pass_levels) {
+		level_count = std::max(level_count, level + 1);
+	}
+	compiled.levels.resize(level_count);
+	for (std::size_t i = 0; i < pass_levels.size(); ++i) {
+		compiled.levels[pass_levels[i]].passes.push_back(i);
+	}
+
+	// Creates the transient resources that are used and aliases their memory.
+	std::vector<std::shared_ptr<buffer::buffer_type>> buffers(graph.resources.size());
+	std::vector<std::shared_ptr<image::image_type>> images(graph.resources.size());
+	std::vector<VkMemoryRequirements> requirements(graph.resources.size());
+	std::vector<internal::placement_type> placements;
+	uint32_t memoryTypeBits(~0u);
+	for (resource_type i = 0; i < graph.resources.size(); ++i) {
+		const internal::resource_info_type &resource(graph.resources[i]);
+		if (resource.imported || usages[i].first == -1) {
+			continue;
+		}
+		if (resource.is_image) {
+			const image_description_type &description(resource.image_description);
+			images[i] = std::make_shared<image::image_type>(image::create(device, 0,
+				description.imageType, description.format, description.extent,
+				description.mipLevels, description.arrayLayers, description.samples,
+				VK_IMAGE_TILING_OPTIMAL, description.usage, VK_SHARING_MODE_EXCLUSIVE, {},
+				VK_IMAGE_LAYOUT_UNDEFINED));
+			requirements[i] = memory::internal::get_memory_requirements(*images[i]);
+			compiled.resources[i].image = images[i];
+		} else {
+			buffers[i] = std::make_shared<buffer::buffer_type>(buffer::create(device, 0,
+				resource.buffer_description.size, resource.buffer_description.usage,
+				VK_SHARING_MODE_EXCLUSIVE, {}));
+			requirements[i] = memory::internal::get_memory_requirements(*buffers[i]);
+			compiled.resources[i].buffer = buffers[i];
+		}
+		memoryTypeBits &= requirements[i].memoryTypeBits;
+		placements.push_back(internal::placement_type{ i, 0, 0 });
+	}
+	if (placements.empty()) {
+		return compiled;
+	}
+	const VkDeviceSize size(internal::place(usages, requirements,
+		physical_device::properties(device::get_physical_device(*device))
+			.limits.bufferImageGranularity, placements));
+	compiled.memory = memory::internal::allocate(device, memory::gpu_only, memoryTypeBits,
+		size);
+	for (const internal::placement_type &placement : placements) {
+		if (images[placement.resource]) {
+			memory::internal::bind(compiled.memory, placement.offset, *images[placement.resource]);
+		} else {
+			memory::internal::bind(compiled.memory, placement.offset,
+				*buffers[placement.resource]);
+		}
+	}
+
+	// The first use of a resource waits for the resources that used its
+	// memory before it.
+	for (const internal::placement_type &placement : placements) {
+		const internal::usage_type &usage(usages[placement.resource]);
+		internal::alias_barrier_type &barrier(compiled.levels[usage.first].alias_barrier);
+		for (const internal::placement_type &other : placements) {
+			const internal::usage_type &other_usage(usages[other.resource]);
+			if (other_usage.last < usage.first && internal::overlaps(placement, other)) {
+				barrier.src_stages |= other_usage.stages;
+				barrier.src_access |= other_usage.write_access;
+				barrier.dst_stages |= usage.first_stages;
+				barrier.dst_access |= usage.first_access;
+			}
+		}
+	}
+	return compiled;
+}
+
+void execute(const compiled_type &graph, command::build_type &build) {
+	internal::execute(graph, build, nullptr);
+}
+
+void execute(const compiled_type &graph, command::build_type &build,
+		parallel::recorder_type &recorder) {
+	internal::execute(graph, build, &recorder);
+}
+
+std::vector<std::string> get_pass_names(const compiled_type &graph) {
+	std::vector<std::string> names;
+	names.reserve(graph.passes.size());
+	for (const internal::level_type &level : graph.levels) {
+		for (std::size_t index : level.passes) {
+			names.push_back(graph.passes[index].name);
+		}
+	}
+	return names;
+}
+
+type::supplier<const buffer::buffer_type> get_buffer(const compiled_type &graph,
+		resource_type resource) {
+	return graph.resources.at(resource).buffer;
+}
+
+type::supplier<const image::image_type> get_image(const compiled_type &graph,
+		resource_type resource) {
+	return graph.resources.at(resource).image;
+}
+
+}  // namespace graph
+}  // namespace vcc
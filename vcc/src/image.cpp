@@ -47,7 +47,8 @@ image_type create(const type::supplier<const device::device_type> &device,
 	create.pQueueFamilyIndices = queueFamilyIndices.empty() ? NULL : &queueFamilyIndices.front();
 	create.initialLayout = initialLayout;
 	VkImage image;
-	VKCHECK(vkCreateImage(internal::get_instance(*device), &create, NULL, &image));
+	VKCHECK(vkCreateImage(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &image));
 	const VkDevice device_instance(internal::get_instance(*device));
 	return image_type(image, device, true, imageType, format, mipLevels,
 		arrayLayers);
@@ -30,8 +30,8 @@ image_view_type create(const type::supplier<const image::image_type> &image,
 	create.components = components;
 	create.subresourceRange = subresourceRange;
 	VkImageView image_view;
-	VKCHECK(vkCreateImageView(internal::get_instance(*internal::get_parent(*image)), &create, NULL,
-		&image_view));
+	VKCHECK(vkCreateImageView(internal::get_instance(*internal::get_parent(*image)), &create,
+		internal::get_allocator(*internal::get_parent(*image)), &image_view));
 	return image_view_type(image_view, internal::get_parent(*image), image);
 }
 
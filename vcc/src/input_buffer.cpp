@@ -19,6 +19,7 @@
 #include <vcc/input_buffer.h>
 #include <vcc/memory.h>
 #include <vcc/queue.h>
+#include <vcc/transient.h>
 
 namespace vcc {
 namespace input_buffer {
@@ -41,13 +42,9 @@ bool flush(const input_buffer_type &buffer) {
 bool flush(const queue::queue_type &queue, const input_buffer_type &buffer) {
 	if (flush(buffer)) {
 		std::unique_lock<std::mutex> lock(buffer.mutex);
-		type::supplier<const device::device_type> device(vcc::internal::get_parent(buffer.buffer));
-		command_pool::command_pool_type command_pool(command_pool::create(device,
-			VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, queue::get_family_index(queue)));
-		command_buffer::command_buffer_type command_buffer(std::move(command_buffer::allocate(
-			device, std::ref(command_pool), VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1).front()));
+		transient::command_type command(transient::acquire(queue));
 		command::compile(
-			vcc::command::build(std::ref(command_buffer),
+			vcc::command::build(std::ref(transient::get_command_buffer(command)),
 				VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, VK_FALSE, 0, 0),
 			command::pipeline_barrier{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
 				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, {},
@@ -59,9 +56,7 @@ bool flush(const queue::queue_type &queue, const input_buffer_type &buffer) {
 				}, {}
 			});
 		// Must block until our command finish executing.
-		fence::fence_type fence(vcc::fence::create(device));
-		queue::submit(queue, {}, { command_buffer }, {}, fence);
-		fence::wait(*device, { fence }, true);
+		transient::submit_and_wait(queue, command);
 		return true;
 	} else {
 		return false;
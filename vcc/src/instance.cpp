@@ -18,7 +18,8 @@
 namespace vcc {
 namespace instance {
 
-instance_type create(const std::set<std::string> &layers, const std::set<std::string> &extensions) {
+instance_type create(const std::set<std::string> &layers, const std::set<std::string> &extensions,
+		const VkAllocationCallbacks *allocator) {
 	VkInstanceCreateInfo create_info = {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO, NULL, 0,
 		NULL};
 	create_info.enabledLayerCount = (uint32_t) layers.size();
@@ -28,8 +29,8 @@ instance_type create(const std::set<std::string> &layers, const std::set<std::st
 	create_info.enabledExtensionCount = (uint32_t) extensions.size();
 	create_info.ppEnabledExtensionNames = extensions_pointers.empty() ? NULL : &extensions_pointers.front();
 	VkInstance instance;
-	VKCHECK(vkCreateInstance(&create_info, NULL, &instance));
-	return instance_type(instance);
+	VKCHECK(vkCreateInstance(&create_info, allocator, &instance));
+	return instance_type(instance, allocator);
 }
 
 }  // namespace instance
@@ -13,25 +13,283 @@
 * See the License for the specific language governing permissions and
 * limitations under the License.
 */
+#include <algorithm>
+#include <map>
+#include <set>
 #include <vcc/memory.h>
 #include <vcc/physical_device.h>
 
 namespace vcc {
 namespace memory {
 
-memory_type memory_type::allocate(const type::supplier<const device::device_type> &device,
-		VkDeviceSize allocationSize, uint32_t memoryTypeIndex, VkMemoryType type) {
+namespace internal {
+
+// Returns the budget and usage of each heap. Without VK_EXT_memory_budget
+// the heap size and the bytes allocated through vcc are used instead.
+void get_budget(const device::device_type &device, const device_memory_type &state,
+		std::vector<VkDeviceSize> &heap_budget,
+		std::vector<VkDeviceSize> &heap_usage) {
+	const VkPhysicalDeviceMemoryProperties memory_properties(
+		physical_device::memory_properties(device::get_physical_device(device)));
+	heap_budget.resize(memory_properties.memoryHeapCount);
+	heap_usage.assign(memory_properties.memoryHeapCount, 0);
+	for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i) {
+		heap_budget[i] = memory_properties.memoryHeaps[i].size;
+	}
+	for (const auto &allocation : state.allocations) {
+		heap_usage[allocation.second.heap_index] += allocation.second.size;
+	}
+#if defined(VK_KHR_get_physical_device_properties2) && defined(VK_EXT_memory_budget)
+	if (state.get_physical_device_memory_properties2) {
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT, NULL };
+		VkPhysicalDeviceMemoryProperties2KHR properties = {
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR, &budget };
+		state.get_physical_device_memory_properties2(device::get_physical_device(device),
+			&properties);
+		for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i) {
+			heap_budget[i] = budget.heapBudget[i];
+			heap_usage[i] = budget.heapUsage[i];
+		}
+	}
+#endif // VK_EXT_memory_budget
+}
+
+}  // namespace internal
+
+VkResult memory_type::try_allocate(const type::supplier<const device::device_type> &device,
+		VkDeviceSize allocationSize, VkDeviceSize largest_free_block,
+		uint32_t memoryTypeIndex, VkMemoryType type, const internal::dedicated_type &dedicated,
+		VkDeviceMemory &memory) {
 	VkMemoryAllocateInfo allocate = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL};
 	allocate.allocationSize = allocationSize;
 	allocate.memoryTypeIndex = memoryTypeIndex;
+#if defined(VK_KHR_dedicated_allocation) && defined(VK_KHR_get_memory_requirements2)
+	VkMemoryDedicatedAllocateInfoKHR dedicated_allocate = {
+		VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO_KHR, NULL, dedicated.image,
+		dedicated.buffer };
+	if (dedicated.image || dedicated.buffer) {
+		allocate.pNext = &dedicated_allocate;
+	}
+#endif // VK_KHR_dedicated_allocation
+	const VkResult result(vkAllocateMemory(vcc::internal::get_instance(*device), &allocate,
+		vcc::internal::get_allocator(*device), &memory));
+	if (result != VK_SUCCESS) {
+		return result;
+	}
+
+	internal::device_memory_type &state(*device::internal::get_memory_state(*device));
+	budget_callback_type callback;
+	std::vector<VkDeviceSize> heap_budget, heap_usage;
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		state.allocations.emplace(memory, internal::allocation_type{ memoryTypeIndex,
+			type.heapIndex, allocationSize, 0, largest_free_block });
+		if (state.budget_callback) {
+			internal::get_budget(*device, state, heap_budget, heap_usage);
+			if (heap_usage[type.heapIndex] > state.threshold * heap_budget[type.heapIndex]) {
+				callback = state.budget_callback;
+			}
+		}
+	}
+	// Outside the lock, the callback may very well ask for statistics.
+	if (callback) {
+		callback(type.heapIndex, heap_usage[type.heapIndex], heap_budget[type.heapIndex]);
+	}
+	return VK_SUCCESS;
+}
+
+memory_type memory_type::allocate(const type::supplier<const device::device_type> &device,
+		VkDeviceSize allocationSize, VkDeviceSize largest_free_block,
+		uint32_t memoryTypeBits, VkMemoryPropertyFlags propertyFlags,
+		const internal::dedicated_type &dedicated) {
+	const VkPhysicalDeviceMemoryProperties memory_properties(
+		vcc::physical_device::memory_properties(device::get_physical_device(*device)));
+	const uint32_t memoryTypeIndex(internal::find_memory_type(memory_properties,
+		memoryTypeBits, propertyFlags));
 	VkDeviceMemory memory;
-	VKCHECK(vkAllocateMemory(vcc::internal::get_instance(*device), &allocate, NULL,
-		&memory));
-	return memory_type(memory, device, allocationSize, type);
+	VKCHECK(try_allocate(device, allocationSize, largest_free_block, memoryTypeIndex,
+		memory_properties.memoryTypes[memoryTypeIndex], dedicated, memory));
+	return memory_type(memory, device, allocationSize,
+		memory_properties.memoryTypes[memoryTypeIndex]);
+}
+
+memory_type memory_type::allocate(const type::supplier<const device::device_type> &device,
+		VkDeviceSize allocationSize, VkDeviceSize largest_free_block,
+		uint32_t memoryTypeBits, usage_type usage, const internal::dedicated_type &dedicated) {
+	const VkPhysicalDeviceMemoryProperties memory_properties(
+		vcc::physical_device::memory_properties(device::get_physical_device(*device)));
+	const std::vector<uint32_t> memory_types(internal::rank_memory_types(memory_properties,
+		memoryTypeBits, usage));
+	if (memory_types.empty()) {
+		throw vcc_exception("Failed to find valid memoryTypeBits that fits the usage");
+	}
+	// A full heap is not the end, the next best type may live on another one.
+	for (uint32_t memoryTypeIndex : memory_types) {
+		VkDeviceMemory memory;
+		const VkResult result(try_allocate(device, allocationSize, largest_free_block,
+			memoryTypeIndex, memory_properties.memoryTypes[memoryTypeIndex], dedicated, memory));
+		if (result == VK_SUCCESS) {
+			return memory_type(memory, device, allocationSize,
+				memory_properties.memoryTypes[memoryTypeIndex]);
+		} else if (result != VK_ERROR_OUT_OF_DEVICE_MEMORY
+				|| memoryTypeIndex == memory_types.back()) {
+			VKCHECK(result);
+		}
+	}
+	throw vcc_exception("Failed to allocate memory");
+}
+
+memory_type::~memory_type() {
+	if (vcc::internal::get_instance(*this)) {
+		const device::device_type &device(*vcc::internal::get_parent(*this));
+		if (mapped) {
+			vkUnmapMemory(vcc::internal::get_instance(device), vcc::internal::get_instance(*this));
+		}
+		internal::device_memory_type &state(*device::internal::get_memory_state(device));
+		std::lock_guard<std::mutex> lock(state.mutex);
+		state.allocations.erase(vcc::internal::get_instance(*this));
+		// Writes to memory about to be freed need no flush.
+		state.pending_flushes.erase(std::remove_if(state.pending_flushes.begin(),
+			state.pending_flushes.end(), [this](const mapped_range_type &range) {
+				return &*range.memory == this;
+			}), state.pending_flushes.end());
+	}
 }
 
 namespace internal {
 
+uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties &memory_properties,
+		uint32_t memoryTypeBits, VkMemoryPropertyFlags propertyFlags) {
+	for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < memory_properties.memoryTypeCount;
+			++memoryTypeIndex) {
+		if ((memoryTypeBits & (1 << memoryTypeIndex))
+			&& (memory_properties.memoryTypes[memoryTypeIndex].propertyFlags & propertyFlags)
+				== propertyFlags) {
+			return memoryTypeIndex;
+		}
+	}
+	throw vcc_exception("Failed to find valid memoryTypeBits that fits the propertyFlags");
+}
+
+std::vector<uint32_t> rank_memory_types(
+		const VkPhysicalDeviceMemoryProperties &memory_properties, uint32_t memoryTypeBits,
+		usage_type usage) {
+	// Every flag in preferred scores a point, every flag in most_preferred two
+	// and every flag in not_preferred costs one.
+	VkMemoryPropertyFlags required, most_preferred(0), preferred, not_preferred;
+	switch (usage) {
+	case gpu_only:
+		required = 0;
+		preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		not_preferred = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		break;
+	case cpu_to_gpu:
+		required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		not_preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		break;
+	case gpu_to_cpu:
+		// Uncached reads are slow, coherence only saves an invalidate.
+		required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		most_preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		not_preferred = 0;
+		break;
+	case cpu_only:
+		required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		not_preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		break;
+	case transient:
+		required = 0;
+		preferred = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		not_preferred = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		break;
+	default:
+		throw vcc_exception("Unknown memory usage");
+	}
+	std::vector<std::pair<int, uint32_t>> scores;
+	for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < memory_properties.memoryTypeCount;
+			++memoryTypeIndex) {
+		const VkMemoryPropertyFlags flags(
+			memory_properties.memoryTypes[memoryTypeIndex].propertyFlags);
+		if (!(memoryTypeBits & (1 << memoryTypeIndex)) || (flags & required) != required) {
+			continue;
+		}
+		int score(0);
+		for (VkMemoryPropertyFlags bit = 1; bit <= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+				bit <<= 1) {
+			if (flags & bit & most_preferred) {
+				score += 2;
+			} else if (flags & bit & preferred) {
+				++score;
+			} else if (flags & bit & not_preferred) {
+				--score;
+			}
+		}
+		scores.emplace_back(score, memoryTypeIndex);
+	}
+	// Ties go to the lowest index, as the driver orders by performance.
+	std::stable_sort(scores.begin(), scores.end(), [](const std::pair<int, uint32_t> &lhs,
+			const std::pair<int, uint32_t> &rhs) {
+		return lhs.first > rhs.first;
+	});
+	std::vector<uint32_t> memory_types;
+	memory_types.reserve(scores.size());
+	for (const std::pair<int, uint32_t> &score : scores) {
+		memory_types.push_back(score.second);
+	}
+	return memory_types;
+}
+
+uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties &memory_properties,
+		uint32_t memoryTypeBits, usage_type usage) {
+	const std::vector<uint32_t> memory_types(rank_memory_types(memory_properties,
+		memoryTypeBits, usage));
+	if (memory_types.empty()) {
+		throw vcc_exception("Failed to find valid memoryTypeBits that fits the usage");
+	}
+	return memory_types.front();
+}
+
+// Keeps the memory alive for a bound resource and its bytes counted as used.
+struct binding_type {
+	binding_type(const type::supplier<const memory_type> &memory, VkDeviceSize size)
+		: memory(memory), size(size) {}
+	binding_type(const binding_type &) = delete;
+	binding_type &operator=(const binding_type &) = delete;
+
+	~binding_type() {
+		device_memory_type &state(*device::internal::get_memory_state(
+			*vcc::internal::get_parent(*memory)));
+		std::lock_guard<std::mutex> lock(state.mutex);
+		const auto allocation(state.allocations.find(vcc::internal::get_instance(*memory)));
+		if (allocation != state.allocations.end()) {
+			allocation->second.used -= size;
+		}
+	}
+
+	type::supplier<const memory_type> memory;
+	VkDeviceSize size;
+};
+
+type::supplier<const memory_type> make_binding(const type::supplier<const memory_type> &memory,
+		VkDeviceSize size) {
+	{
+		device_memory_type &state(*device::internal::get_memory_state(
+			*vcc::internal::get_parent(*memory)));
+		std::lock_guard<std::mutex> lock(state.mutex);
+		const auto allocation(state.allocations.find(vcc::internal::get_instance(*memory)));
+		if (allocation != state.allocations.end()) {
+			allocation->second.used += size;
+		}
+	}
+	const std::shared_ptr<binding_type> binding(std::make_shared<binding_type>(memory, size));
+	// Points at the memory, but releasing the last copy releases the binding.
+	return std::shared_ptr<const memory_type>(binding, &*binding->memory);
+}
+
 VkMemoryRequirements get_memory_requirements(const image::image_type &image) {
 	VkMemoryRequirements requirements;
 	vkGetImageMemoryRequirements(vcc::internal::get_instance(
@@ -49,7 +307,8 @@ void bind(const type::supplier<const memory_type> &memory, VkDeviceSize offset,
 			vcc::internal::get_instance(image),
 			vcc::internal::get_instance(*memory), offset));
 	}
-	vcc::internal::get_memory(image) = memory;
+	vcc::internal::get_memory(image) = make_binding(memory,
+		get_memory_requirements(image).size);
 	vcc::internal::get_offset(image) = offset;
 }
 
@@ -71,7 +330,8 @@ void bind(const type::supplier<const memory_type> &memory, VkDeviceSize offset,
 			vcc::internal::get_instance(buffer),
 			vcc::internal::get_instance(*memory), offset));
 	}
-	vcc::internal::get_memory(buffer) = memory;
+	vcc::internal::get_memory(buffer) = make_binding(memory,
+		get_memory_requirements(buffer).size);
 	vcc::internal::get_offset(buffer) = offset;
 }
 
@@ -84,17 +344,206 @@ void bind(const type::supplier<const memory_type> &memory, VkDeviceSize offset,
 	bind(memory, offset, input_buffer::internal::get_buffer(buffer));
 }
 
+type::supplier<const memory_type> bind_buffers(
+		const type::supplier<const device::device_type> &device,
+		VkMemoryPropertyFlags propertyFlags, const std::vector<buffer::buffer_type *> &buffers) {
+	if (buffers.empty()) {
+		throw vcc_exception("No buffers to bind.");
+	}
+	std::vector<VkDeviceSize> offsets(buffers.size());
+	uint32_t memoryTypeBits(~0u);
+	VkDeviceSize size(0), largest_free_block(0);
+	for (std::size_t i = 0; i < buffers.size(); ++i) {
+		const VkMemoryRequirements requirements(get_memory_requirements(*buffers[i]));
+		offsets[i] = size + (requirements.alignment - size % requirements.alignment)
+			% requirements.alignment;
+		if (offsets[i] - size > largest_free_block) {
+			largest_free_block = offsets[i] - size;
+		}
+		size = offsets[i] + requirements.size;
+		memoryTypeBits &= requirements.memoryTypeBits;
+	}
+	if (!memoryTypeBits) {
+		throw vcc_exception("No memoryTypeBits for all given storage.");
+	}
+	std::shared_ptr<memory_type> memory(std::make_shared<memory_type>(memory_type::allocate(
+		device, size, largest_free_block, memoryTypeBits, propertyFlags,
+		buffers.size() == 1 ? get_dedicated(*buffers.front())
+			: dedicated_type{ VK_NULL_HANDLE, VK_NULL_HANDLE })));
+	for (std::size_t i = 0; i < buffers.size(); ++i) {
+		bind(memory, offsets[i], *buffers[i]);
+	}
+	return memory;
+}
+
+type::supplier<const memory_type> allocate(
+		const type::supplier<const device::device_type> &device, usage_type usage,
+		uint32_t memoryTypeBits, VkDeviceSize size) {
+	if (!memoryTypeBits) {
+		throw vcc_exception("No memoryTypeBits for all given storage.");
+	}
+	return std::make_shared<memory_type>(memory_type::allocate(device, size, 0,
+		memoryTypeBits, usage, dedicated_type{ VK_NULL_HANDLE, VK_NULL_HANDLE }));
+}
+
+dedicated_type get_dedicated(const image::image_type &image) {
+	dedicated_type dedicated{ VK_NULL_HANDLE, VK_NULL_HANDLE };
+#if defined(VK_KHR_dedicated_allocation) && defined(VK_KHR_get_memory_requirements2)
+	const device::device_type &device(*vcc::internal::get_parent(image));
+	const device_memory_type &state(*device::internal::get_memory_state(device));
+	if (state.get_image_memory_requirements2) {
+		VkMemoryDedicatedRequirementsKHR dedicated_requirements = {
+			VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS_KHR, NULL };
+		VkMemoryRequirements2KHR requirements = {
+			VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR, &dedicated_requirements };
+		const VkImageMemoryRequirementsInfo2KHR info = {
+			VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2_KHR, NULL,
+			vcc::internal::get_instance(image) };
+		state.get_image_memory_requirements2(vcc::internal::get_instance(device), &info,
+			&requirements);
+		if (dedicated_requirements.prefersDedicatedAllocation
+				|| dedicated_requirements.requiresDedicatedAllocation) {
+			dedicated.image = vcc::internal::get_instance(image);
+		}
+	}
+#endif // VK_KHR_dedicated_allocation
+	return dedicated;
+}
+
+dedicated_type get_dedicated(const buffer::buffer_type &buffer) {
+	dedicated_type dedicated{ VK_NULL_HANDLE, VK_NULL_HANDLE };
+#if defined(VK_KHR_dedicated_allocation) && defined(VK_KHR_get_memory_requirements2)
+	const device::device_type &device(*vcc::internal::get_parent(buffer));
+	const device_memory_type &state(*device::internal::get_memory_state(device));
+	if (state.get_buffer_memory_requirements2) {
+		VkMemoryDedicatedRequirementsKHR dedicated_requirements = {
+			VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS_KHR, NULL };
+		VkMemoryRequirements2KHR requirements = {
+			VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR, &dedicated_requirements };
+		const VkBufferMemoryRequirementsInfo2KHR info = {
+			VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2_KHR, NULL,
+			vcc::internal::get_instance(buffer) };
+		state.get_buffer_memory_requirements2(vcc::internal::get_instance(device), &info,
+			&requirements);
+		if (dedicated_requirements.prefersDedicatedAllocation
+				|| dedicated_requirements.requiresDedicatedAllocation) {
+			dedicated.buffer = vcc::internal::get_instance(buffer);
+		}
+	}
+#endif // VK_KHR_dedicated_allocation
+	return dedicated;
+}
+
+dedicated_type get_dedicated(const input_buffer::input_buffer_type &buffer) {
+	return get_dedicated(input_buffer::internal::get_buffer(buffer));
+}
+
+typedef VkResult(VKAPI_PTR *mapped_memory_ranges_function_type)(VkDevice, uint32_t,
+	const VkMappedMemoryRange *);
+
+struct rounded_range_type {
+	const memory_type *memory;
+	VkDeviceSize begin, end;
+};
+
+rounded_range_type round(const memory_type &memory, VkDeviceSize offset, VkDeviceSize size,
+		VkDeviceSize atom_size) {
+	const VkDeviceSize begin(offset - offset % atom_size);
+	VkDeviceSize end(size == VK_WHOLE_SIZE ? get_size(memory) : offset + size);
+	end += (atom_size - end % atom_size) % atom_size;
+	// The end of the allocation is always a valid end of a range.
+	if (end > get_size(memory)) {
+		end = get_size(memory);
+	}
+	return rounded_range_type{ &memory, begin, end };
+}
+
+// All ranges must belong to device.
+void mapped_memory_ranges(mapped_memory_ranges_function_type function,
+		const device::device_type &device, std::vector<rounded_range_type> &&ranges) {
+	std::sort(ranges.begin(), ranges.end(), [](const rounded_range_type &lhs,
+			const rounded_range_type &rhs) {
+		const VkDeviceMemory lhs_memory(vcc::internal::get_instance(*lhs.memory)),
+			rhs_memory(vcc::internal::get_instance(*rhs.memory));
+		return std::less<VkDeviceMemory>()(lhs_memory, rhs_memory)
+			|| (lhs_memory == rhs_memory && lhs.begin < rhs.begin);
+	});
+	std::vector<VkMappedMemoryRange> merged;
+	merged.reserve(ranges.size());
+	for (const rounded_range_type &range : ranges) {
+		const VkDeviceMemory memory(vcc::internal::get_instance(*range.memory));
+		if (!merged.empty() && merged.back().memory == memory
+				&& merged.back().offset + merged.back().size >= range.begin) {
+			if (range.end > merged.back().offset + merged.back().size) {
+				merged.back().size = range.end - merged.back().offset;
+			}
+		} else {
+			merged.push_back(VkMappedMemoryRange{ VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, nullptr,
+				memory, range.begin, range.end - range.begin });
+		}
+	}
+	if (!merged.empty()) {
+		VKCHECK(function(vcc::internal::get_instance(device), uint32_t(merged.size()),
+			merged.data()));
+	}
+}
+
+void mapped_memory_ranges(mapped_memory_ranges_function_type function,
+		const std::vector<mapped_range_type> &ranges) {
+	std::map<const device::device_type *, std::vector<rounded_range_type>> device_ranges;
+	std::map<const device::device_type *, VkDeviceSize> atom_sizes;
+	for (const mapped_range_type &range : ranges) {
+		if (get_type(*range.memory).propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+			continue;
+		}
+		const device::device_type &device(*vcc::internal::get_parent(*range.memory));
+		auto atom_size(atom_sizes.find(&device));
+		if (atom_size == atom_sizes.end()) {
+			atom_size = atom_sizes.emplace(&device, physical_device::properties(
+				device::get_physical_device(device)).limits.nonCoherentAtomSize).first;
+		}
+		device_ranges[&device].push_back(round(*range.memory, range.offset, range.size,
+			atom_size->second));
+	}
+	for (auto &entry : device_ranges) {
+		mapped_memory_ranges(function, *entry.first, std::move(entry.second));
+	}
+}
+
+void mapped_memory_range(mapped_memory_ranges_function_type function,
+		const memory_type &memory, VkDeviceSize offset, VkDeviceSize size) {
+	const device::device_type &device(*vcc::internal::get_parent(memory));
+	mapped_memory_ranges(function, device, { round(memory, offset, size,
+		physical_device::properties(device::get_physical_device(device))
+			.limits.nonCoherentAtomSize) });
+}
+
+// Host writes in an invalidated range that were not flushed are undefined,
+// so the writes still pending on memory are flushed first.
+void flush_pending(const memory_type &memory) {
+	std::vector<mapped_range_type> ranges;
+	{
+		device_memory_type &state(*device::internal::get_memory_state(
+			*vcc::internal::get_parent(memory)));
+		std::lock_guard<std::mutex> lock(state.mutex);
+		const auto pending(std::stable_partition(state.pending_flushes.begin(),
+			state.pending_flushes.end(), [&memory](const mapped_range_type &range) {
+				return &*range.memory != &memory;
+			}));
+		ranges.assign(pending, state.pending_flushes.end());
+		state.pending_flushes.erase(pending, state.pending_flushes.end());
+	}
+	mapped_memory_ranges(vkFlushMappedMemoryRanges, ranges);
+}
+
 }  // namespace internal
 
 map_type::~map_type() {
-	if (memory) {
-		std::lock_guard<std::mutex> lock(vcc::internal::get_mutex(*memory));
-		vkUnmapMemory(
-			vcc::internal::get_instance(*vcc::internal::get_parent(*memory)),
-			vcc::internal::get_instance(*memory));
-		if (!(memory->type.propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-			flush(*memory, offset, size);
-		}
+	if (memory && !(memory->type.propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+		internal::device_memory_type &state(*device::internal::get_memory_state(
+			*vcc::internal::get_parent(*memory)));
+		std::lock_guard<std::mutex> lock(state.mutex);
+		state.pending_flushes.push_back(mapped_range_type{ memory, offset, size });
 	}
 }
 
@@ -103,25 +552,110 @@ map_type map(const type::supplier<const memory_type> &memory, VkDeviceSize offse
 	void *data;
 	{
 		std::lock_guard<std::mutex> lock(vcc::internal::get_mutex(*memory));
-		VKCHECK(vkMapMemory(
-			vcc::internal::get_instance(*vcc::internal::get_parent(*memory)),
-			vcc::internal::get_instance(*memory), offset, size, 0, &data));
+		if (!memory->mapped) {
+			VKCHECK(vkMapMemory(
+				vcc::internal::get_instance(*vcc::internal::get_parent(*memory)),
+				vcc::internal::get_instance(*memory), 0, VK_WHOLE_SIZE, 0, &memory->mapped));
+		}
+		data = static_cast<uint8_t *>(memory->mapped) + offset;
 	}
 	return map_type(memory, offset, size, data);
 }
 
 void flush(const memory_type &memory, VkDeviceSize offset, VkDeviceSize size) {
-	VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, nullptr,
-		vcc::internal::get_instance(memory), offset, size };
-	VKCHECK(vkFlushMappedMemoryRanges(
-		vcc::internal::get_instance(*vcc::internal::get_parent(memory)), 1, &range));
+	internal::mapped_memory_range(vkFlushMappedMemoryRanges, memory, offset, size);
 }
 
 void invalidate(const memory_type &memory, VkDeviceSize offset, VkDeviceSize size) {
-	VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, nullptr,
-		vcc::internal::get_instance(memory), offset, size };
-	VKCHECK(vkInvalidateMappedMemoryRanges(
-		vcc::internal::get_instance(*vcc::internal::get_parent(memory)), 1, &range));
+	internal::flush_pending(memory);
+	internal::mapped_memory_range(vkInvalidateMappedMemoryRanges, memory, offset, size);
+}
+
+void flush(const std::vector<mapped_range_type> &ranges) {
+	internal::mapped_memory_ranges(vkFlushMappedMemoryRanges, ranges);
+}
+
+void invalidate(const std::vector<mapped_range_type> &ranges) {
+	std::set<const memory_type *> memories;
+	for (const mapped_range_type &range : ranges) {
+		const VkMemoryPropertyFlags flags(internal::get_type(*range.memory).propertyFlags);
+		if (!(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+				&& memories.insert(&*range.memory).second) {
+			internal::flush_pending(*range.memory);
+		}
+	}
+	internal::mapped_memory_ranges(vkInvalidateMappedMemoryRanges, ranges);
+}
+
+void flush_pending(const device::device_type &device) {
+	std::vector<mapped_range_type> ranges;
+	{
+		internal::device_memory_type &state(*device::internal::get_memory_state(device));
+		std::lock_guard<std::mutex> lock(state.mutex);
+		ranges.swap(state.pending_flushes);
+	}
+	flush(ranges);
+}
+
+#if defined(VK_KHR_get_physical_device_properties2) && defined(VK_EXT_memory_budget)
+void enable_memory_budget(const instance::instance_type &instance,
+		const device::device_type &device) {
+	PFN_vkVoidFunction function(vkGetInstanceProcAddr(vcc::internal::get_instance(instance),
+		"vkGetPhysicalDeviceMemoryProperties2KHR"));
+	if (!function) {
+		function = vkGetInstanceProcAddr(vcc::internal::get_instance(instance),
+			"vkGetPhysicalDeviceMemoryProperties2");
+	}
+	if (!function) {
+		throw vcc_exception("vkGetPhysicalDeviceMemoryProperties2KHR");
+	}
+	internal::device_memory_type &state(*device::internal::get_memory_state(device));
+	std::lock_guard<std::mutex> lock(state.mutex);
+	state.get_physical_device_memory_properties2 =
+		(PFN_vkGetPhysicalDeviceMemoryProperties2KHR) function;
+}
+#endif // VK_EXT_memory_budget
+
+statistics_type statistics(const device::device_type &device) {
+	const VkPhysicalDeviceMemoryProperties memory_properties(
+		physical_device::memory_properties(device::get_physical_device(device)));
+	statistics_type statistics;
+	statistics.heaps.assign(memory_properties.memoryHeapCount, usage_statistics_type{});
+	statistics.types.assign(memory_properties.memoryTypeCount, usage_statistics_type{});
+	internal::device_memory_type &state(*device::internal::get_memory_state(device));
+	std::lock_guard<std::mutex> lock(state.mutex);
+	for (const auto &entry : state.allocations) {
+		const internal::allocation_type &allocation(entry.second);
+		for (usage_statistics_type *usage : { &statistics.heaps[allocation.heap_index],
+				&statistics.types[allocation.type_index] }) {
+			usage->allocated_bytes += allocation.size;
+			usage->used_bytes += allocation.used;
+			++usage->allocation_count;
+			if (allocation.largest_free_block > usage->largest_free_block) {
+				usage->largest_free_block = allocation.largest_free_block;
+			}
+		}
+	}
+	for (std::vector<usage_statistics_type> *usages : { &statistics.heaps, &statistics.types }) {
+		for (usage_statistics_type &usage : *usages) {
+			// Resources aliasing each other may use more than was allocated.
+			const VkDeviceSize free_bytes(usage.allocated_bytes > usage.used_bytes
+				? usage.allocated_bytes - usage.used_bytes : 0);
+			usage.fragmentation = free_bytes
+				? 1.f - float(usage.largest_free_block) / free_bytes : 0.f;
+		}
+	}
+	internal::get_budget(device, state, statistics.heap_budget,
+		statistics.heap_usage);
+	return statistics;
+}
+
+void set_budget_callback(const device::device_type &device, float threshold,
+		const budget_callback_type &callback) {
+	internal::device_memory_type &state(*device::internal::get_memory_state(device));
+	std::lock_guard<std::mutex> lock(state.mutex);
+	state.threshold = threshold;
+	state.budget_callback = callback;
 }
 
 }  // namespace memory
@@ -0,0 +1,184 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <vcc/parallel.h>
+
+namespace vcc {
+namespace parallel {
+
+namespace internal {
+
+std::shared_ptr<command_buffer::command_buffer_type> acquire(
+		const type::supplier<const device::device_type> &device,
+		const std::shared_ptr<worker_type> &worker) {
+	command_buffer::command_buffer_type command_buffer;
+	{
+		std::lock_guard<std::mutex> lock(worker->mutex);
+		if (!worker->command_buffers.empty()) {
+			command_buffer = std::move(worker->command_buffers.back());
+			worker->command_buffers.pop_back();
+		}
+	}
+	if (!vcc::internal::get_instance(command_buffer)) {
+		command_buffer = std::move(command_buffer::allocate(device,
+			std::cref(worker->command_pool), VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1).front());
+	}
+	// The worker is kept alive until all of its command buffers are returned.
+	return std::shared_ptr<command_buffer::command_buffer_type>(
+		new command_buffer::command_buffer_type(std::move(command_buffer)),
+		[worker](command_buffer::command_buffer_type *command_buffer) {
+			// Drop whatever the last recording kept alive, keeping the memory.
+			command_buffer::internal::get_references(*command_buffer).clear();
+			command_buffer::internal::get_pre_execute_hook(*command_buffer).clear();
+			{
+				std::lock_guard<std::mutex> lock(worker->mutex);
+				worker->command_buffers.push_back(std::move(*command_buffer));
+			}
+			delete command_buffer;
+		});
+}
+
+void record_part(const type::supplier<const device::device_type> &device,
+		const std::shared_ptr<worker_type> &worker, state_type &state, std::size_t index,
+		std::size_t parts) {
+	job_type &job(state.job);
+	const std::size_t first(job.count * index / parts),
+		last(job.count * (index + 1) / parts);
+	if (first == last) {
+		return;
+	}
+	try {
+		const std::shared_ptr<command_buffer::command_buffer_type> command_buffer(
+			acquire(device, worker));
+		{
+			command::build_type build(job.render_pass
+				? command::build(command_buffer, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+					job.render_pass, job.subpass, job.framebuffer, VK_FALSE, 0, 0)
+				: command::build(command_buffer, 0, VK_FALSE, 0, 0));
+			job.callback(build, first, last);
+		}
+		job.command_buffers[index] = command_buffer;
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(state.mutex);
+		if (!job.exception) {
+			job.exception = std::current_exception();
+		}
+	}
+}
+
+void run(const type::supplier<const device::device_type> &device,
+		const std::shared_ptr<worker_type> &worker, state_type &state, std::size_t index,
+		std::size_t parts) {
+	uint64_t generation(0);
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(state.mutex);
+			state.start.wait(lock, [&state, generation]() {
+				return state.stop || state.generation != generation;
+			});
+			if (state.stop) {
+				return;
+			}
+			generation = state.generation;
+		}
+		record_part(device, worker, state, index, parts);
+		std::lock_guard<std::mutex> lock(state.mutex);
+		if (!--state.remaining) {
+			state.done.notify_one();
+		}
+	}
+}
+
+}  // namespace internal
+
+recorder_type::~recorder_type() {
+	if (state) {
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->stop = true;
+		}
+		state->start.notify_all();
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+	}
+}
+
+recorder_type create(const type::supplier<const device::device_type> &device,
+		uint32_t queue_family_index, std::size_t thread_count) {
+	// hardware_concurrency returns zero when unknown.
+	if (!thread_count) {
+		thread_count = 1;
+	}
+	std::vector<std::shared_ptr<internal::worker_type>> workers;
+	workers.reserve(thread_count);
+	for (std::size_t i = 0; i < thread_count; ++i) {
+		workers.push_back(std::make_shared<internal::worker_type>());
+		workers.back()->command_pool = command_pool::create(device,
+			VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, queue_family_index);
+	}
+	std::unique_ptr<internal::state_type> state(new internal::state_type());
+	// The calling thread records with the first worker.
+	std::vector<std::thread> threads;
+	threads.reserve(thread_count - 1);
+	for (std::size_t i = 1; i < thread_count; ++i) {
+		threads.emplace_back(&internal::run, device, workers[i], std::ref(*state), i,
+			thread_count);
+	}
+	return recorder_type(device, std::move(workers), std::move(state), std::move(threads));
+}
+
+command::execute_commands record(recorder_type &recorder,
+		const type::supplier<const render_pass::render_pass_type> &render_pass,
+		uint32_t subpass, const type::supplier<const framebuffer::framebuffer_type> &framebuffer,
+		std::size_t count, const record_callback_type &callback) {
+	std::lock_guard<std::mutex> record_lock(*recorder.mutex);
+	internal::state_type &state(*recorder.state);
+	const std::size_t parts(recorder.workers.size());
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		state.job = internal::job_type{ render_pass, subpass, framebuffer, count, callback,
+			std::vector<type::supplier<const command_buffer::command_buffer_type>>(parts),
+			std::exception_ptr() };
+		state.remaining = parts - 1;
+		++state.generation;
+	}
+	state.start.notify_all();
+	internal::record_part(recorder.device, recorder.workers.front(), state, 0, parts);
+
+	internal::job_type job;
+	{
+		std::unique_lock<std::mutex> lock(state.mutex);
+		state.done.wait(lock, [&state]() {
+			return !state.remaining;
+		});
+		// Leaves nothing from this call alive in the recorder.
+		std::swap(job, state.job);
+	}
+	if (job.exception) {
+		std::rethrow_exception(job.exception);
+	}
+	command::execute_commands execute;
+	for (type::supplier<const command_buffer::command_buffer_type> &command_buffer
+			: job.command_buffers) {
+		if (command_buffer) {
+			execute.commandBuffers.push_back(std::move(command_buffer));
+		}
+	}
+	return execute;
+}
+
+}  // namespace parallel
+}  // namespace vcc
@@ -13,6 +13,8 @@
 * See the License for the specific language governing permissions and
 * limitations under the License.
 */
+#define NOMINMAX
+#include <limits>
 #include <vcc/physical_device.h>
 
 namespace vcc {
@@ -51,5 +53,32 @@ uint32_t get_queue_family_properties_with_flag(const std::vector<VkQueueFamilyPr
 	throw vcc_exception("No queue family found with the given properties.");
 }
 
+uint32_t get_dedicated_queue_family(const std::vector<VkQueueFamilyProperties> &properties,
+		VkQueueFlags flags, VkQueueFlags avoided) {
+	uint32_t family(std::numeric_limits<uint32_t>::max());
+	std::size_t best_count(std::numeric_limits<std::size_t>::max());
+	for (std::size_t i = 0; i < properties.size(); ++i) {
+		VkQueueFlags queue_flags(properties[i].queueFlags);
+		if (queue_flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) {
+			queue_flags |= VK_QUEUE_TRANSFER_BIT;
+		}
+		if ((queue_flags & flags) != flags || !properties[i].queueCount) {
+			continue;
+		}
+		std::size_t count(0);
+		for (VkQueueFlags bits(queue_flags & avoided); bits; bits &= bits - 1) {
+			++count;
+		}
+		if (count < best_count) {
+			family = uint32_t(i);
+			best_count = count;
+		}
+	}
+	if (family == std::numeric_limits<uint32_t>::max()) {
+		throw vcc_exception("No queue family found with the given properties.");
+	}
+	return family;
+}
+
 }  // namespace physical_device
 }  // namespace vcc
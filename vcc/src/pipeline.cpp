@@ -182,7 +182,8 @@ pipeline_type create_graphics(const type::supplier<const device::device_type> &d
 	create.basePipelineIndex = -1;
 
 	VKCHECK(vkCreateGraphicsPipelines(internal::get_instance(*device),
-		internal::get_instance(pipeline_cache), 1, &create, NULL, &pipeline));
+		internal::get_instance(pipeline_cache), 1, &create,
+			internal::get_allocator(*device), &pipeline));
 	return pipeline_type(pipeline, device, layout, render_pass);
 }
 
@@ -251,7 +252,8 @@ pipeline_type create_compute(const type::supplier<const device::device_type> &de
 	create.basePipelineIndex = -1;
 	VkPipeline instance;
 	VKCHECK(vkCreateComputePipelines(internal::get_instance(*device),
-		internal::get_instance(pipeline_cache), 1, &create, NULL, &instance));
+		internal::get_instance(pipeline_cache), 1, &create,
+			internal::get_allocator(*device), &instance));
 	return pipeline_type(instance, device, layout);
 }
 
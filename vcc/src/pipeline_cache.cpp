@@ -27,7 +27,8 @@ pipeline_cache_type create(const type::supplier<const device::device_type> &devi
 	create.initialDataSize = data.size();
 	create.pInitialData = &data[0];
 	VkPipelineCache cache;
-	VKCHECK(vkCreatePipelineCache(internal::get_instance(*device), &create, NULL, &cache));
+	VKCHECK(vkCreatePipelineCache(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &cache));
 	return pipeline_cache_type(cache, device);
 }
 
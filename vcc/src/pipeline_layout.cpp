@@ -17,9 +17,6 @@
 #include <algorithm>
 #include <cassert>
 #include <iterator>
-#include <vcc/command.h>
-#include <vcc/command_buffer.h>
-#include <vcc/queue.h>
 #include <vcc/pipeline_layout.h>
 
 namespace vcc {
@@ -42,44 +39,50 @@ pipeline_layout_type create(const type::supplier<const device::device_type> &dev
 	create.pushConstantRangeCount = (uint32_t) push_constant_ranges.size();
 	create.pPushConstantRanges = push_constant_ranges.empty() ? NULL : &push_constant_ranges.front();
 	VkPipelineLayout pipeline_layout;
-	VKCHECK(vkCreatePipelineLayout(vcc::internal::get_instance(*device), &create, NULL, &pipeline_layout));
+	VKCHECK(vkCreatePipelineLayout(vcc::internal::get_instance(*device), &create,
+		vcc::internal::get_allocator(*device), &pipeline_layout));
 	return pipeline_layout_type(pipeline_layout, device, set_layouts);
 }
 
 namespace internal {
 
-void flush(const type::supplier<const type::serialize_type> &constants,
-		VkPipelineLayout pipeline_layout,
-		const std::vector<VkPushConstantRange> &push_constant_ranges,
-		const queue::queue_type &queue) {
-	if (type::dirty(*constants)) {
-		const type::supplier<const device::device_type> device(
-			vcc::internal::get_parent(queue));
-		std::string buffer(type::size(*constants), '\0');
-		type::flush(*constants, &buffer[0]);
-		command_pool::command_pool_type command_pool(command_pool::create(
-			device, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, queue::get_family_index(queue)));
-		command_buffer::command_buffer_type cmd(std::move(
-			command_buffer::allocate(device, std::ref(command_pool),
-				VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1).front()));
-		{
-			command::build_type begin(command::build(
-				std::ref(cmd), VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-				VK_FALSE, 0, 0));
-			for (const VkPushConstantRange &range : push_constant_ranges) {
-				assert(range.offset + range.size <= buffer.size());
-				vkCmdPushConstants(vcc::internal::get_instance(cmd), pipeline_layout,
-					range.stageFlags, range.offset, range.size,
-					&buffer[range.offset]);
-			}
+// Must hold push_constants.mutex.
+void update(push_constants_type &push_constants) {
+	if (type::dirty(*push_constants.constants)) {
+		std::string data(type::size(*push_constants.constants), '\0');
+		type::flush(*push_constants.constants, &data[0]);
+		if (data != push_constants.data) {
+			push_constants.data.swap(data);
+			++push_constants.revision;
 		}
-		// Must block until our command finish executing.
-		fence::fence_type fence(fence::create(device));
-		queue::submit(queue, {}, { cmd }, {}, fence);
-		fence::wait(*device, { fence }, true, std::chrono::nanoseconds::max());
 	}
 }
 
+uint64_t push_constants(const pipeline_layout_type &layout, VkCommandBuffer command_buffer) {
+	const std::unique_ptr<push_constants_type> &push_constants(get_push_constants(layout));
+	if (!push_constants) {
+		return 0;
+	}
+	std::lock_guard<std::mutex> lock(push_constants->mutex);
+	update(*push_constants);
+	for (const VkPushConstantRange &range : push_constants->push_constant_ranges) {
+		assert(range.offset + range.size <= push_constants->data.size());
+		VKTRACE(vkCmdPushConstants(command_buffer, vcc::internal::get_instance(layout),
+			range.stageFlags, range.offset, range.size, &push_constants->data[range.offset]));
+	}
+	return push_constants->revision;
+}
+
+uint64_t push_constants_revision(const pipeline_layout_type &layout) {
+	const std::unique_ptr<push_constants_type> &push_constants(get_push_constants(layout));
+	if (!push_constants) {
+		return 0;
+	}
+	std::lock_guard<std::mutex> lock(push_constants->mutex);
+	update(*push_constants);
+	return push_constants->revision;
+}
+
 }  // namespace internal
 
 }  // namespace pipeline_layout
@@ -0,0 +1,85 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <algorithm>
+#include <vcc/progress.h>
+
+#if defined(VK_KHR_timeline_semaphore)
+
+namespace vcc {
+namespace progress {
+
+namespace internal {
+
+uint64_t update_completed(state_type &state, uint64_t value) {
+	uint64_t completed(state.completed.load(std::memory_order_relaxed));
+	while (completed < value && !state.completed.compare_exchange_weak(completed, value,
+		std::memory_order_relaxed)) {}
+	return std::max(completed, value);
+}
+
+}  // namespace internal
+
+progress_type create(const type::supplier<const device::device_type> &device) {
+	return progress_type(std::make_shared<semaphore::timeline_semaphore_type>(
+		semaphore::create_timeline(device, 0)));
+}
+
+queue::timeline_signal_semaphore signal(progress_type &progress) {
+	return queue::timeline_signal_semaphore{ progress.semaphore,
+		progress.state->issued.fetch_add(1, std::memory_order_relaxed) + 1 };
+}
+
+uint64_t get_issued(const progress_type &progress) {
+	return progress.state->issued.load(std::memory_order_relaxed);
+}
+
+uint64_t get_completed(const progress_type &progress) {
+	return internal::update_completed(*progress.state, semaphore::get_value(*progress.semaphore));
+}
+
+bool is_complete(const progress_type &progress, uint64_t value) {
+	return progress.state->completed.load(std::memory_order_relaxed) >= value
+		|| get_completed(progress) >= value;
+}
+
+void wait(const progress_type &progress, uint64_t value) {
+	if (progress.state->completed.load(std::memory_order_relaxed) < value) {
+		semaphore::wait(*progress.semaphore, value);
+		internal::update_completed(*progress.state, value);
+	}
+}
+
+VkResult wait(const progress_type &progress, uint64_t value, std::chrono::nanoseconds timeout) {
+	if (progress.state->completed.load(std::memory_order_relaxed) >= value) {
+		return VK_SUCCESS;
+	}
+	const VkResult result(semaphore::wait({ semaphore::timeline_value_type{
+		std::cref(*progress.semaphore), value } }, true, timeout));
+	if (result == VK_SUCCESS) {
+		internal::update_completed(*progress.state, value);
+	}
+	return result;
+}
+
+queue::timeline_wait_semaphore wait_semaphore(const progress_type &progress, uint64_t value,
+		VkPipelineStageFlags wait_dst_stage_mask) {
+	return queue::timeline_wait_semaphore{ progress.semaphore, value, wait_dst_stage_mask };
+}
+
+}  // namespace progress
+}  // namespace vcc
+
+#endif // VK_KHR_timeline_semaphore
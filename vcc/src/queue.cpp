@@ -14,7 +14,9 @@
 * limitations under the License.
 */
 #define NOMINMAX
+#include <algorithm>
 #include <limits>
+#include <vcc/memory.h>
 #include <vcc/physical_device.h>
 #include <vcc/queue.h>
 
@@ -24,7 +26,7 @@ namespace queue {
 queue_type get_device_queue(const type::supplier<const device::device_type> &device,
 		uint32_t queue_family_index, uint32_t queue_index) {
 	VkQueue queue;
-	vkGetDeviceQueue(internal::get_instance(*device), queue_family_index,
+	vkGetDeviceQueue(vcc::internal::get_instance(*device), queue_family_index,
 		queue_index, &queue);
 	return queue_type(queue, device, queue_family_index);
 }
@@ -40,6 +42,16 @@ queue_type get_queue(const type::supplier<const device::device_type> &device, Vk
 	throw vcc_exception("Failed to find queue");
 }
 
+queue_type get_transfer_queue(const type::supplier<const device::device_type> &device) {
+	return get_device_queue(device, physical_device::get_transfer_queue_family(
+		physical_device::queue_famility_properties(device::get_physical_device(*device))), 0);
+}
+
+queue_type get_compute_queue(const type::supplier<const device::device_type> &device) {
+	return get_device_queue(device, physical_device::get_compute_queue_family(
+		physical_device::queue_famility_properties(device::get_physical_device(*device))), 0);
+}
+
 queue_type get_present_queue(const type::supplier<const device::device_type> &device,
 		const surface::surface_type &surface) {
 	const std::vector<VkQueueFamilyProperties> queue_props(
@@ -83,78 +95,171 @@ std::pair<queue_type, queue_type> get_graphics_and_present_queues(
 		get_device_queue(device, (uint32_t) present_index, 0));
 }
 
-void submit(const queue_type &queue,
-		const std::vector<wait_semaphore> &wait_semaphores,
-		const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>>
-			&command_buffers,
-		const std::vector<std::reference_wrapper<const semaphore::semaphore_type>> &signal_semaphores,
+namespace internal {
+
+// The converted handles of a batch, kept alive until vkQueueSubmit returns.
+struct converted_submit_type {
+	std::vector<VkSemaphore> wait_semaphores;
+	std::vector<VkPipelineStageFlags> wait_dst_stage_masks;
+	std::vector<VkCommandBuffer> command_buffers;
+	std::vector<VkSemaphore> signal_semaphores;
+#if defined(VK_KHR_timeline_semaphore)
+	bool timeline;
+	std::vector<uint64_t> wait_values, signal_values;
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info;
+#endif // VK_KHR_timeline_semaphore
+};
+
+void submit(const queue_type &queue, const std::vector<submit_info_type> &submits,
 		const fence::fence_type *fence) {
-	std::vector<VkCommandBuffer> converted_command_buffers;
-	converted_command_buffers.reserve(command_buffers.size());
-	for (const command_buffer::command_buffer_type &command_buffer : command_buffers) {
-		converted_command_buffers.push_back(internal::get_instance(command_buffer));
-		command_buffer::internal::get_pre_execute_hook(command_buffer)(queue);
-	}
-	std::vector<VkSemaphore> converted_wait_semaphores;
-	converted_wait_semaphores.reserve(wait_semaphores.size());
-	std::vector<VkPipelineStageFlags> wait_mask;
-	wait_mask.reserve(wait_semaphores.size());
-	for (const wait_semaphore &semaphore : wait_semaphores) {
-		converted_wait_semaphores.push_back(internal::get_instance(*semaphore.semaphore));
-		wait_mask.push_back(semaphore.wait_dst_stage_mask);
-	}
-	std::vector<VkSemaphore> converted_signal_semaphores;
-	converted_signal_semaphores.reserve(signal_semaphores.size());
-	for (const semaphore::semaphore_type &semaphore : signal_semaphores) {
-		converted_signal_semaphores.push_back(internal::get_instance(semaphore));
+	std::vector<converted_submit_type> converted(submits.size());
+	std::vector<VkSubmitInfo> infos;
+	infos.reserve(submits.size());
+	// A semaphore signaled by one batch and waited on by a later one is locked once.
+	std::vector<std::mutex *> mutexes;
+	// Each descriptor set, input buffer and layout is checked once per submit.
+	vcc::internal::key_set_type called;
+	for (std::size_t i = 0; i < submits.size(); ++i) {
+		const submit_info_type &info(submits[i]);
+		converted_submit_type &batch(converted[i]);
+		batch.command_buffers.reserve(info.command_buffers.size());
+		for (const command_buffer::command_buffer_type &command_buffer : info.command_buffers) {
+			batch.command_buffers.push_back(vcc::internal::get_instance(command_buffer));
+			command_buffer::internal::get_pre_execute_hook(command_buffer)(called, queue);
+		}
+		batch.wait_semaphores.reserve(info.wait_semaphores.size());
+		batch.wait_dst_stage_masks.reserve(info.wait_semaphores.size());
+		for (const wait_semaphore &semaphore : info.wait_semaphores) {
+			batch.wait_semaphores.push_back(vcc::internal::get_instance(*semaphore.semaphore));
+			batch.wait_dst_stage_masks.push_back(semaphore.wait_dst_stage_mask);
+			mutexes.push_back(&vcc::internal::get_mutex(*semaphore.semaphore));
+		}
+		batch.signal_semaphores.reserve(info.signal_semaphores.size());
+		for (const semaphore::semaphore_type &semaphore : info.signal_semaphores) {
+			batch.signal_semaphores.push_back(vcc::internal::get_instance(semaphore));
+			mutexes.push_back(&vcc::internal::get_mutex(semaphore));
+		}
+#if defined(VK_KHR_timeline_semaphore)
+		batch.timeline = !info.timeline_wait_semaphores.empty()
+			|| !info.timeline_signal_semaphores.empty();
+		if (batch.timeline) {
+			// Values of binary semaphores are ignored, but take a slot.
+			batch.wait_values.assign(batch.wait_semaphores.size(), 0);
+			for (const timeline_wait_semaphore &semaphore : info.timeline_wait_semaphores) {
+				batch.wait_semaphores.push_back(vcc::internal::get_instance(*semaphore.semaphore));
+				batch.wait_dst_stage_masks.push_back(semaphore.wait_dst_stage_mask);
+				batch.wait_values.push_back(semaphore.value);
+				mutexes.push_back(&vcc::internal::get_mutex(*semaphore.semaphore));
+			}
+			batch.signal_values.assign(batch.signal_semaphores.size(), 0);
+			for (const timeline_signal_semaphore &semaphore : info.timeline_signal_semaphores) {
+				batch.signal_semaphores.push_back(
+					vcc::internal::get_instance(*semaphore.semaphore));
+				batch.signal_values.push_back(semaphore.value);
+				mutexes.push_back(&vcc::internal::get_mutex(*semaphore.semaphore));
+			}
+			VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
+				VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR, NULL };
+			timeline_info.waitSemaphoreValueCount = (uint32_t)batch.wait_values.size();
+			timeline_info.pWaitSemaphoreValues = batch.wait_values.empty() ? NULL
+				: batch.wait_values.data();
+			timeline_info.signalSemaphoreValueCount = (uint32_t)batch.signal_values.size();
+			timeline_info.pSignalSemaphoreValues = batch.signal_values.empty() ? NULL
+				: batch.signal_values.data();
+			batch.timeline_info = timeline_info;
+		}
+#endif // VK_KHR_timeline_semaphore
+		VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO, NULL };
+#if defined(VK_KHR_timeline_semaphore)
+		// converted is never resized, so the chained struct stays put.
+		submit.pNext = batch.timeline ? &batch.timeline_info : NULL;
+#endif // VK_KHR_timeline_semaphore
+		submit.waitSemaphoreCount = (uint32_t)batch.wait_semaphores.size();
+		submit.pWaitSemaphores = batch.wait_semaphores.empty() ? NULL
+			: batch.wait_semaphores.data();
+		submit.pWaitDstStageMask = batch.wait_dst_stage_masks.empty() ? NULL
+			: batch.wait_dst_stage_masks.data();
+		submit.commandBufferCount = (uint32_t)batch.command_buffers.size();
+		submit.pCommandBuffers = batch.command_buffers.data();
+		submit.signalSemaphoreCount = (uint32_t)batch.signal_semaphores.size();
+		submit.pSignalSemaphores = batch.signal_semaphores.empty() ? NULL
+			: batch.signal_semaphores.data();
+		infos.push_back(submit);
 	}
-	VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO, NULL };
-	submit.waitSemaphoreCount = (uint32_t)converted_wait_semaphores.size();
-	submit.pWaitSemaphores = converted_wait_semaphores.empty() ? NULL : &converted_wait_semaphores.front();
-	submit.pWaitDstStageMask = wait_mask.empty() ? NULL : wait_mask.data();
-	submit.commandBufferCount = (uint32_t)converted_command_buffers.size();
-	submit.pCommandBuffers = converted_command_buffers.data();
-	submit.signalSemaphoreCount = (uint32_t)converted_signal_semaphores.size();
-	submit.pSignalSemaphores = converted_signal_semaphores.empty() ? NULL : &converted_signal_semaphores.front();
+	// Host writes made by the hooks and since the last submit must be visible to the device.
+	memory::flush_pending(*vcc::internal::get_parent(queue));
+	std::sort(mutexes.begin(), mutexes.end());
+	mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
 	std::vector<std::unique_lock<std::mutex>> locks;
-	locks.reserve(wait_semaphores.size() + signal_semaphores.size());
-	for (const wait_semaphore &semaphore : wait_semaphores) {
-		locks.emplace_back(internal::get_mutex(*semaphore.semaphore), std::defer_lock);
-	}
-	for (const semaphore::semaphore_type &semaphore : signal_semaphores) {
-		locks.emplace_back(internal::get_mutex(semaphore), std::defer_lock);
+	locks.reserve(mutexes.size());
+	for (std::mutex *mutex : mutexes) {
+		locks.emplace_back(*mutex, std::defer_lock);
 	}
 	util::lock(locks);
 	if (fence) {
-		std::lock(internal::get_mutex(queue), internal::get_mutex(*fence));
-		std::lock_guard<std::mutex> queue_lock(internal::get_mutex(queue), std::adopt_lock);
-		std::lock_guard<std::mutex> fence_lock(internal::get_mutex(*fence), std::adopt_lock);
-		VKCHECK(vkQueueSubmit(internal::get_instance(queue), 1, &submit,
-			internal::get_instance(*fence)));
+		std::lock(vcc::internal::get_mutex(queue), vcc::internal::get_mutex(*fence));
+		std::lock_guard<std::mutex> queue_lock(vcc::internal::get_mutex(queue), std::adopt_lock);
+		std::lock_guard<std::mutex> fence_lock(vcc::internal::get_mutex(*fence), std::adopt_lock);
+		VKCHECK(vkQueueSubmit(vcc::internal::get_instance(queue), (uint32_t)infos.size(),
+			infos.data(), vcc::internal::get_instance(*fence)));
 	} else {
-		std::lock_guard<std::mutex> queue_lock(internal::get_mutex(queue));
-		VKCHECK(vkQueueSubmit(internal::get_instance(queue), 1, &submit, VK_NULL_HANDLE));
+		std::lock_guard<std::mutex> queue_lock(vcc::internal::get_mutex(queue));
+		VKCHECK(vkQueueSubmit(vcc::internal::get_instance(queue), (uint32_t)infos.size(),
+			infos.data(), VK_NULL_HANDLE));
 	}
 }
 
+}  // namespace internal
+
 void submit(const queue_type &queue,
 		const std::vector<wait_semaphore> &wait_semaphores,
 		const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>>
 			&command_buffers,
 		const std::vector<std::reference_wrapper<const semaphore::semaphore_type>> &signal_semaphores,
 		const fence::fence_type &fence) {
-	submit(queue, wait_semaphores, command_buffers, signal_semaphores, &fence);
+	internal::submit(queue, std::vector<submit_info_type>{ submit_info_type{ wait_semaphores,
+		command_buffers, signal_semaphores } }, &fence);
 }
 
 void submit(const queue_type &queue,
 	const std::vector<wait_semaphore> &wait_semaphores,
 	const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>> &command_buffers,
 	const std::vector<std::reference_wrapper<const semaphore::semaphore_type>> &signal_semaphores) {
-	submit(queue, wait_semaphores, command_buffers, signal_semaphores, nullptr);
+	internal::submit(queue, std::vector<submit_info_type>{ submit_info_type{ wait_semaphores,
+		command_buffers, signal_semaphores } }, nullptr);
+}
+
+void submit(const queue_type &queue, const std::vector<submit_info_type> &submits,
+		const fence::fence_type &fence) {
+	internal::submit(queue, submits, &fence);
+}
+
+void submit(const queue_type &queue, const std::vector<submit_info_type> &submits) {
+	internal::submit(queue, submits, nullptr);
+}
+
+wait_semaphore submit_release(const queue_type &queue,
+		const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>>
+			&command_buffers,
+		const type::supplier<const semaphore::semaphore_type> &semaphore,
+		VkPipelineStageFlags dst_stage_mask, const fence::fence_type &fence) {
+	internal::submit(queue, std::vector<submit_info_type>{ submit_info_type{ {},
+		command_buffers, { std::cref(*semaphore) } } }, &fence);
+	return wait_semaphore{ semaphore, dst_stage_mask };
+}
+
+wait_semaphore submit_release(const queue_type &queue,
+		const std::vector<std::reference_wrapper<const command_buffer::command_buffer_type>>
+			&command_buffers,
+		const type::supplier<const semaphore::semaphore_type> &semaphore,
+		VkPipelineStageFlags dst_stage_mask) {
+	internal::submit(queue, std::vector<submit_info_type>{ submit_info_type{ {},
+		command_buffers, { std::cref(*semaphore) } } }, nullptr);
+	return wait_semaphore{ semaphore, dst_stage_mask };
 }
 
 void wait_idle(const queue_type &queue) {
-	VKCHECK(vkQueueWaitIdle(internal::get_instance(queue)));
+	VKCHECK(vkQueueWaitIdle(vcc::internal::get_instance(queue)));
 }
 
 VkResult present(const queue_type &queue,
@@ -165,26 +270,26 @@ VkResult present(const queue_type &queue,
 	info.waitSemaphoreCount = (uint32_t) semaphores.size();
 	std::vector<std::unique_lock<std::mutex>> locks;
 	locks.reserve(1 + semaphores.size() + swapchains.size());
-	locks.emplace_back(internal::get_mutex(queue), std::defer_lock);
+	locks.emplace_back(vcc::internal::get_mutex(queue), std::defer_lock);
 	std::vector<VkSemaphore> converted_semaphores;
 	converted_semaphores.reserve(semaphores.size());
 	for (const semaphore::semaphore_type &semaphore : semaphores) {
-		converted_semaphores.push_back(internal::get_instance(semaphore));
-		locks.emplace_back(internal::get_mutex(semaphore), std::defer_lock);
+		converted_semaphores.push_back(vcc::internal::get_instance(semaphore));
+		locks.emplace_back(vcc::internal::get_mutex(semaphore), std::defer_lock);
 	}
 	info.pWaitSemaphores = semaphores.empty() ? NULL : &converted_semaphores.front();
 	info.swapchainCount = (uint32_t) swapchains.size();
 	std::vector<VkSwapchainKHR> converted_swapchains;
 	converted_swapchains.reserve(swapchains.size());
 	for (const swapchain::swapchain_type &swapchain : swapchains) {
-		converted_swapchains.push_back(internal::get_instance(swapchain));
-		locks.emplace_back(internal::get_mutex(swapchain), std::defer_lock);
+		converted_swapchains.push_back(vcc::internal::get_instance(swapchain));
+		locks.emplace_back(vcc::internal::get_mutex(swapchain), std::defer_lock);
 	}
 	info.pSwapchains = swapchains.empty() ? NULL : &converted_swapchains.front();
 	info.pImageIndices = image_indices.empty() ? NULL : &image_indices.front();
 	info.pResults = NULL;
 	util::lock(locks);
-	return vkQueuePresentKHR(internal::get_instance(queue), &info);
+	return vkQueuePresentKHR(vcc::internal::get_instance(queue), &info);
 }
 
 }  // namespace queue
@@ -0,0 +1,143 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <vcc/command.h>
+#include <vcc/memory.h>
+#include <vcc/readback.h>
+
+namespace vcc {
+namespace readback {
+
+namespace internal {
+
+void run(const device::device_type &device, state_type &state) {
+	for (;;) {
+		std::unique_lock<std::mutex> lock(state.mutex);
+		state.condition.wait(lock, [&state]() {
+			return state.stop || !state.pending.empty();
+		});
+		if (state.pending.empty()) {
+			return;
+		}
+		// Only this thread pops, pushing to the back leaves the front in place.
+		pending_type &pending(state.pending.front());
+		lock.unlock();
+
+		// A lost device fails the wait, the error goes to the caller rather
+		// than terminating the thread, and the staging buffer is not reused.
+		bool completed(false);
+		try {
+			fence::wait(device, { transient::get_fence(pending.command) }, true);
+			completed = true;
+			fence::reset(device, { transient::get_fence(pending.command) });
+			const memory::map_type map(memory::map(
+				vcc::internal::get_memory(*pending.staging),
+				vcc::internal::get_offset(*pending.staging), pending.size));
+			// Readback memory is often cached but not coherent.
+			memory::invalidate({ memory::mapped_range_type{ map.memory, map.offset,
+				map.size } });
+			pending.callback(map.data, pending.size);
+			pending.promise.set_value();
+		} catch (...) {
+			pending.promise.set_exception(std::current_exception());
+		}
+
+		lock.lock();
+		if (completed) {
+			state.staging_buffers.push_back(std::move(pending.staging));
+		}
+		state.pending.pop_front();
+	}
+}
+
+std::shared_ptr<buffer::buffer_type> acquire_staging(
+		const type::supplier<const device::device_type> &device, state_type &state,
+		VkDeviceSize size) {
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		const auto staging(std::find_if(state.staging_buffers.begin(),
+			state.staging_buffers.end(),
+			[size](const std::shared_ptr<buffer::buffer_type> &staging) {
+				return buffer::get_size(*staging) >= size;
+			}));
+		if (staging != state.staging_buffers.end()) {
+			std::shared_ptr<buffer::buffer_type> buffer(std::move(*staging));
+			state.staging_buffers.erase(staging);
+			return buffer;
+		}
+	}
+	std::shared_ptr<buffer::buffer_type> staging(std::make_shared<buffer::buffer_type>(
+		buffer::create(device, 0, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_SHARING_MODE_EXCLUSIVE, {})));
+	memory::bind(device, memory::gpu_to_cpu, *staging);
+	return staging;
+}
+
+}  // namespace internal
+
+readback_type::~readback_type() {
+	if (state) {
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->stop = true;
+		}
+		state->condition.notify_one();
+		thread.join();
+	}
+}
+
+readback_type create(const type::supplier<const device::device_type> &device) {
+	std::unique_ptr<internal::state_type> state(new internal::state_type());
+	std::thread thread(&internal::run, std::cref(*device), std::ref(*state));
+	return readback_type(device, std::move(state), std::move(thread));
+}
+
+std::future<void> read(readback_type &readback, const queue::queue_type &queue,
+		const type::supplier<const buffer::buffer_type> &buffer, VkDeviceSize offset,
+		VkDeviceSize size, const callback_type &callback) {
+	internal::state_type &state(*readback.state);
+	std::shared_ptr<buffer::buffer_type> staging(
+		internal::acquire_staging(readback.device, state, size));
+	transient::command_type command(transient::acquire(queue));
+	command::compile(
+		command::build(std::ref(transient::get_command_buffer(command)),
+			VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, VK_FALSE, 0, 0),
+		command::pipeline_barrier(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			{ command::memory_barrier{ VK_ACCESS_MEMORY_WRITE_BIT,
+				VK_ACCESS_TRANSFER_READ_BIT } }, {}, {}),
+		command::copy_buffer(buffer, staging, { VkBufferCopy{ offset, 0, size } }),
+		command::pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+			0, {}, {
+				command::buffer_memory_barrier(VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_ACCESS_HOST_READ_BIT, VK_QUEUE_FAMILY_IGNORED,
+					VK_QUEUE_FAMILY_IGNORED, staging, 0, size)
+			}, {}));
+	queue::submit(queue, {}, { transient::get_command_buffer(command) }, {},
+		transient::get_fence(command));
+
+	std::promise<void> promise;
+	std::future<void> future(promise.get_future());
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		state.pending.push_back(internal::pending_type{ std::move(command), std::move(staging),
+			size, callback, std::move(promise) });
+	}
+	state.condition.notify_one();
+	return future;
+}
+
+}  // namespace readback
+}  // namespace vcc
@@ -57,7 +57,8 @@ render_pass_type create(const type::supplier<const device::device_type> &device,
 	create.dependencyCount = (uint32_t)subpass_dependency.size();
 	create.pDependencies = subpass_dependency.empty() ? NULL : &subpass_dependency.front();
 	VkRenderPass render_pass;
-	VKCHECK(vkCreateRenderPass(internal::get_instance(*device), &create, NULL, &render_pass));
+	VKCHECK(vkCreateRenderPass(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &render_pass));
 	return render_pass_type(render_pass, device);
 }
 
@@ -43,7 +43,8 @@ sampler_type create(const type::supplier<const device::device_type> &device,
 	create.unnormalizedCoordinates = unnormalizedCoordinates;
 
 	VkSampler sampler;
-	VKCHECK(vkCreateSampler(internal::get_instance(*device), &create, NULL, &sampler));
+	VKCHECK(vkCreateSampler(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &sampler));
 	return sampler_type(sampler, device);
 }
 
@@ -22,9 +22,81 @@ semaphore_type create(const type::supplier<const device::device_type> &device) {
 	VkSemaphoreCreateInfo create = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
 		NULL, 0};
 	VkSemaphore semaphore;
-	VKCHECK(vkCreateSemaphore(internal::get_instance(*device), &create, NULL, &semaphore));
+	VKCHECK(vkCreateSemaphore(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &semaphore));
 	return semaphore_type(semaphore, device);
 }
 
+#if defined(VK_KHR_timeline_semaphore)
+
+timeline_semaphore_type create_timeline(const type::supplier<const device::device_type> &device,
+		uint64_t initial_value) {
+	const VkDevice instance(internal::get_instance(*device));
+	const PFN_vkGetSemaphoreCounterValueKHR get_counter_value(
+		(PFN_vkGetSemaphoreCounterValueKHR) vkGetDeviceProcAddr(instance,
+			"vkGetSemaphoreCounterValueKHR"));
+	const PFN_vkWaitSemaphoresKHR wait_semaphores((PFN_vkWaitSemaphoresKHR)
+		vkGetDeviceProcAddr(instance, "vkWaitSemaphoresKHR"));
+	const PFN_vkSignalSemaphoreKHR signal_semaphore((PFN_vkSignalSemaphoreKHR)
+		vkGetDeviceProcAddr(instance, "vkSignalSemaphoreKHR"));
+	if (!get_counter_value || !wait_semaphores || !signal_semaphore) {
+		throw vcc_exception("VK_KHR_timeline_semaphore is not enabled");
+	}
+	VkSemaphoreTypeCreateInfoKHR type = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR,
+		NULL, VK_SEMAPHORE_TYPE_TIMELINE_KHR, initial_value };
+	VkSemaphoreCreateInfo create = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, &type, 0 };
+	VkSemaphore semaphore;
+	VKCHECK(vkCreateSemaphore(instance, &create, internal::get_allocator(*device),
+		&semaphore));
+	return timeline_semaphore_type(semaphore, device, get_counter_value, wait_semaphores,
+		signal_semaphore);
+}
+
+uint64_t get_value(const timeline_semaphore_type &semaphore) {
+	uint64_t value;
+	VKCHECK(semaphore.get_counter_value(internal::get_instance(*internal::get_parent(semaphore)),
+		internal::get_instance(semaphore), &value));
+	return value;
+}
+
+void signal(const timeline_semaphore_type &semaphore, uint64_t value) {
+	VkSemaphoreSignalInfoKHR info = { VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR, NULL,
+		internal::get_instance(semaphore), value };
+	VKCHECK(semaphore.signal_semaphore(
+		internal::get_instance(*internal::get_parent(semaphore)), &info));
+}
+
+VkResult wait(const std::vector<timeline_value_type> &values, bool wait_all,
+		std::chrono::nanoseconds timeout) {
+	if (values.empty()) {
+		return VK_SUCCESS;
+	}
+	std::vector<VkSemaphore> converted_semaphores;
+	converted_semaphores.reserve(values.size());
+	std::vector<uint64_t> converted_values;
+	converted_values.reserve(values.size());
+	for (const timeline_value_type &value : values) {
+		converted_semaphores.push_back(internal::get_instance(value.semaphore.get()));
+		converted_values.push_back(value.value);
+	}
+	VkSemaphoreWaitInfoKHR info = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR, NULL,
+		VkSemaphoreWaitFlagsKHR(wait_all ? 0 : VK_SEMAPHORE_WAIT_ANY_BIT_KHR),
+		(uint32_t)values.size(), converted_semaphores.data(), converted_values.data() };
+	const timeline_semaphore_type &first(values.front().semaphore);
+	const VkResult result(first.wait_semaphores(
+		internal::get_instance(*internal::get_parent(first)), &info,
+		timeout == std::chrono::nanoseconds::max() ? UINT64_MAX : uint64_t(timeout.count())));
+	if (result != VK_TIMEOUT && result != VK_SUCCESS) {
+		VKCHECK(result);
+	}
+	return result;
+}
+
+VkResult wait(const std::vector<timeline_value_type> &values, bool wait_all) {
+	return wait(values, wait_all, std::chrono::nanoseconds::max());
+}
+
+#endif // VK_KHR_timeline_semaphore
+
 }  // namespace semaphore
 }  // namespace vcc
@@ -32,7 +32,8 @@ shader_module_type create(const type::supplier<const device::device_type> &devic
 	create.codeSize = string.size();
 
 	VkShaderModule shader_module;
-	VKCHECK(vkCreateShaderModule(internal::get_instance(*device), &create, NULL, &shader_module));
+	VKCHECK(vkCreateShaderModule(internal::get_instance(*device), &create,
+		internal::get_allocator(*device), &shader_module));
 	return shader_module_type(shader_module, device);
 }
 
@@ -0,0 +1,222 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <algorithm>
+#include <vcc/submitter.h>
+
+namespace vcc {
+namespace submitter {
+
+namespace internal {
+
+void push(state_type &state, submission_type *submission) {
+	state.enqueued.fetch_add(1, std::memory_order_relaxed);
+	submission_type *head(state.head.load(std::memory_order_relaxed));
+	do {
+		submission->next = head;
+	} while (!state.head.compare_exchange_weak(head, submission, std::memory_order_release,
+		std::memory_order_relaxed));
+	if (!head) {
+		// The submission thread checks head under the mutex before sleeping,
+		// so taking it here makes sure the notification is not lost.
+		std::lock_guard<std::mutex> lock(state.mutex);
+		state.wake.notify_one();
+	}
+}
+
+void fail(state_type &state) {
+	std::lock_guard<std::mutex> lock(state.mutex);
+	if (!state.exception) {
+		state.exception = std::current_exception();
+	}
+	state.failed.store(true, std::memory_order_release);
+}
+
+void rethrow(state_type &state) {
+	if (state.failed.load(std::memory_order_acquire)) {
+		std::exception_ptr exception;
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			std::swap(exception, state.exception);
+			state.failed.store(false, std::memory_order_relaxed);
+		}
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+}
+
+void submit_batches(const queue::queue_type &queue, state_type &state,
+		std::vector<queue::submit_info_type> &batches,
+		const type::supplier<const fence::fence_type> &fence) {
+	if (batches.empty() && !fence) {
+		return;
+	}
+	try {
+		if (fence) {
+			queue::submit(queue, batches, *fence);
+		} else {
+			queue::submit(queue, batches);
+		}
+	} catch (...) {
+		fail(state);
+	}
+	batches.clear();
+}
+
+void process(const queue::queue_type &queue, state_type &state,
+		const std::vector<std::unique_ptr<submission_type>> &submissions) {
+	std::vector<queue::submit_info_type> batches;
+	for (const std::unique_ptr<submission_type> &submission : submissions) {
+		if (!submission->swapchains.empty()) {
+			submit_batches(queue, state, batches, type::supplier<const fence::fence_type>());
+			std::vector<std::reference_wrapper<const semaphore::semaphore_type>> semaphores;
+			semaphores.reserve(submission->present_semaphores.size());
+			for (const type::supplier<const semaphore::semaphore_type> &semaphore
+					: submission->present_semaphores) {
+				semaphores.push_back(*semaphore);
+			}
+			std::vector<std::reference_wrapper<const swapchain::swapchain_type>> swapchains;
+			swapchains.reserve(submission->swapchains.size());
+			for (const type::supplier<const swapchain::swapchain_type> &swapchain
+					: submission->swapchains) {
+				swapchains.push_back(*swapchain);
+			}
+			try {
+				const VkResult result(queue::present(queue, semaphores, swapchains,
+					submission->image_indices));
+				if (submission->present_callback) {
+					submission->present_callback(result);
+				}
+			} catch (...) {
+				fail(state);
+			}
+			continue;
+		}
+		queue::submit_info_type batch;
+		batch.wait_semaphores = submission->wait_semaphores;
+		batch.command_buffers.reserve(submission->command_buffers.size());
+		for (const type::supplier<const command_buffer::command_buffer_type> &command_buffer
+				: submission->command_buffers) {
+			batch.command_buffers.push_back(*command_buffer);
+		}
+		batch.signal_semaphores.reserve(submission->signal_semaphores.size());
+		for (const type::supplier<const semaphore::semaphore_type> &semaphore
+				: submission->signal_semaphores) {
+			batch.signal_semaphores.push_back(*semaphore);
+		}
+		batches.push_back(std::move(batch));
+		// A vkQueueSubmit signals one fence, after all of its batches.
+		if (submission->fence) {
+			submit_batches(queue, state, batches, submission->fence);
+		}
+	}
+	submit_batches(queue, state, batches, type::supplier<const fence::fence_type>());
+}
+
+void run(const type::supplier<const queue::queue_type> &queue, state_type &state) {
+	for (;;) {
+		submission_type *head(state.head.exchange(nullptr, std::memory_order_acquire));
+		if (!head) {
+			std::unique_lock<std::mutex> lock(state.mutex);
+			if (state.stop) {
+				return;
+			}
+			state.wake.wait(lock, [&state]() {
+				return state.stop || state.head.load(std::memory_order_acquire);
+			});
+			continue;
+		}
+		// The list is in reverse push order.
+		std::vector<std::unique_ptr<submission_type>> submissions;
+		for (; head; head = head->next) {
+			submissions.emplace_back(head);
+		}
+		std::reverse(submissions.begin(), submissions.end());
+		process(*queue, state, submissions);
+		const std::size_t count(submissions.size());
+		// Release the objects before waiters are told they are submitted.
+		submissions.clear();
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			state.completed += count;
+		}
+		state.idle.notify_all();
+	}
+}
+
+}  // namespace internal
+
+submitter_type::~submitter_type() {
+	if (state) {
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->stop = true;
+		}
+		state->wake.notify_one();
+		thread.join();
+	}
+}
+
+submitter_type create(const type::supplier<const queue::queue_type> &queue) {
+	std::unique_ptr<internal::state_type> state(new internal::state_type);
+	std::thread thread(&internal::run, queue, std::ref(*state));
+	return submitter_type(std::move(state), std::move(thread));
+}
+
+void submit(submitter_type &submitter,
+		const std::vector<queue::wait_semaphore> &wait_semaphores,
+		const std::vector<type::supplier<const command_buffer::command_buffer_type>> &command_buffers,
+		const std::vector<type::supplier<const semaphore::semaphore_type>> &signal_semaphores,
+		const type::supplier<const fence::fence_type> &fence) {
+	internal::rethrow(*submitter.state);
+	std::unique_ptr<internal::submission_type> submission(new internal::submission_type);
+	submission->wait_semaphores = wait_semaphores;
+	submission->command_buffers = command_buffers;
+	submission->signal_semaphores = signal_semaphores;
+	submission->fence = fence;
+	internal::push(*submitter.state, submission.release());
+}
+
+void present(submitter_type &submitter,
+		const std::vector<type::supplier<const semaphore::semaphore_type>> &semaphores,
+		const std::vector<type::supplier<const swapchain::swapchain_type>> &swapchains,
+		const std::vector<uint32_t> &image_indices, const present_callback_type &callback) {
+	if (swapchains.empty()) {
+		throw vcc_exception("present needs at least one swapchain");
+	}
+	internal::rethrow(*submitter.state);
+	std::unique_ptr<internal::submission_type> submission(new internal::submission_type);
+	submission->present_semaphores = semaphores;
+	submission->swapchains = swapchains;
+	submission->image_indices = image_indices;
+	submission->present_callback = callback;
+	internal::push(*submitter.state, submission.release());
+}
+
+void wait(submitter_type &submitter) {
+	internal::state_type &state(*submitter.state);
+	const uint64_t enqueued(state.enqueued.load(std::memory_order_relaxed));
+	{
+		std::unique_lock<std::mutex> lock(state.mutex);
+		state.idle.wait(lock, [&state, enqueued]() {
+			return state.completed >= enqueued;
+		});
+	}
+	internal::rethrow(state);
+}
+
+}  // namespace submitter
+}  // namespace vcc
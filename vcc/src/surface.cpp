@@ -33,7 +33,7 @@ surface_type create(const type::supplier<const instance::instance_type> &instanc
 	create.connection = connection;
 	create.window = window;
 	VKCHECK(vkCreateXcbSurfaceKHR(internal::get_instance(*instance), &create,
-			NULL, &surface));
+			internal::get_allocator(*instance), &surface));
 	return surface_type(surface, instance);
 }
 
@@ -48,7 +48,7 @@ surface_type create(const type::supplier<const instance::instance_type> &instanc
 		VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR, NULL, 0};
 	create.window = window;
 	VKCHECK(vkCreateAndroidSurfaceKHR(internal::get_instance(*instance), &create,
-			NULL, &surface));
+			internal::get_allocator(*instance), &surface));
 	return surface_type(surface, instance);
 }
 
@@ -62,7 +62,8 @@ surface_type create(const type::supplier<const instance::instance_type> &instanc
 	VkWin32SurfaceCreateInfoKHR create = {VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR, NULL, 0};
 	create.hinstance = hinstance;
 	create.hwnd = hwnd;
-	VKCHECK(vkCreateWin32SurfaceKHR(internal::get_instance(*instance), &create, NULL, &surface));
+	VKCHECK(vkCreateWin32SurfaceKHR(internal::get_instance(*instance), &create,
+		internal::get_allocator(*instance), &surface));
 	return surface_type(surface, instance);
 }
 
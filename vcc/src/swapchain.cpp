@@ -54,13 +54,13 @@ swapchain_type create(const type::supplier<const device::device_type> &device,
 				internal::get_mutex(*create_info.oldSwapchain), std::adopt_lock);
 			create.surface = internal::get_instance(*create_info.surface);
 			VKCHECK(vkCreateSwapchainKHR(internal::get_instance(*device), &create,
-				NULL, &swapchain));
+				internal::get_allocator(*device), &swapchain));
 		} else {
 			std::lock_guard<std::mutex> surface_lock(
 				internal::get_mutex(*create_info.surface));
 			create.surface = internal::get_instance(*create_info.surface);
 			VKCHECK(vkCreateSwapchainKHR(internal::get_instance(*device), &create,
-				NULL, &swapchain));
+				internal::get_allocator(*device), &swapchain));
 		}
 	}
 	return swapchain_type(swapchain, device, create_info.imageFormat);
@@ -0,0 +1,365 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <vcc/tracking.h>
+
+namespace vcc {
+namespace tracking {
+namespace internal {
+
+const VkAccessFlags write_access_mask(VK_ACCESS_SHADER_WRITE_BIT
+	| VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+	| VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+
+const access_state_type initial_state = { 0, 0, 0, 0, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+
+bool operator==(const access_state_type &lhs, const access_state_type &rhs) {
+	return lhs.write_stages == rhs.write_stages && lhs.write_access == rhs.write_access
+		&& lhs.read_stages == rhs.read_stages && lhs.visible_stages == rhs.visible_stages
+		&& lhs.visible_access == rhs.visible_access && lhs.ordered_stages == rhs.ordered_stages
+		&& lhs.layout == rhs.layout;
+}
+
+// Records the access itself, after any barrier it needed.
+void update(access_state_type &state, VkPipelineStageFlags stage, VkAccessFlags access,
+		VkImageLayout layout) {
+	if (access & write_access_mask) {
+		state = access_state_type{ stage, access & write_access_mask, 0, 0, 0, 0, layout };
+	} else {
+		state.read_stages |= stage;
+	}
+}
+
+// Layout transitions are writes, made visible by the barrier itself.
+void transition(access_state_type &state, VkPipelineStageFlags dst_stages,
+		VkAccessFlags dst_access, VkImageLayout layout) {
+	state = access_state_type{ dst_stages, 0, 0, dst_stages, dst_access, dst_stages, layout };
+}
+
+bool apply(access_state_type &state, VkPipelineStageFlags src_stages,
+		VkPipelineStageFlags dst_stages, VkAccessFlags src_access, VkAccessFlags dst_access) {
+	bool useful(false);
+	const VkPipelineStageFlags accessed(state.write_stages | state.read_stages);
+	// Dependencies chain through stages already ordered after the accesses.
+	if (accessed && (!(accessed & ~src_stages) || (state.ordered_stages & src_stages))) {
+		useful |= (state.ordered_stages & dst_stages) != dst_stages;
+		state.ordered_stages |= dst_stages;
+	}
+	if (state.write_stages && ((!(state.write_stages & ~src_stages)
+			&& !(state.write_access & ~src_access))
+			|| (state.visible_stages & src_stages))) {
+		useful |= (state.visible_stages & dst_stages) != dst_stages
+			|| (state.visible_access & dst_access) != dst_access;
+		state.visible_stages |= dst_stages;
+		state.visible_access |= dst_access;
+	}
+	return useful;
+}
+
+bool prepare(access_state_type &state, VkPipelineStageFlags stage, VkAccessFlags access,
+		VkImageLayout layout, VkPipelineStageFlags &src_stages, VkAccessFlags &src_access,
+		VkAccessFlags &dst_access) {
+	VkPipelineStageFlags needed_stages(0);
+	VkAccessFlags needed_access(0);
+	const bool transitions(layout != state.layout);
+	if (transitions) {
+		needed_stages = state.write_stages | state.read_stages;
+		needed_access = state.write_access;
+		dst_access |= access;
+	} else {
+		// Read or write after write.
+		if (state.write_stages && ((state.visible_stages & stage) != stage
+				|| (state.visible_access & access) != access)) {
+			needed_stages |= state.write_stages;
+			needed_access |= state.write_access;
+			dst_access |= access;
+		}
+		// Write after read.
+		if ((access & write_access_mask) && state.read_stages
+				&& (state.ordered_stages & stage) != stage) {
+			needed_stages |= state.read_stages;
+		}
+		if (!needed_stages) {
+			update(state, stage, access, layout);
+			return false;
+		}
+	}
+	src_stages |= needed_stages;
+	src_access |= needed_access;
+	if (transitions) {
+		transition(state, stage, access, layout);
+	} else {
+		apply(state, needed_stages, stage, needed_access, access);
+	}
+	update(state, stage, access, layout);
+	return true;
+}
+
+void split(std::map<VkDeviceSize, buffer_piece_type> &pieces, VkDeviceSize offset) {
+	auto piece(pieces.upper_bound(offset));
+	if (piece != pieces.begin() && (--piece)->first < offset && offset < piece->second.end) {
+		pieces.emplace(offset, buffer_piece_type{ piece->second.end, piece->second.state });
+		piece->second.end = offset;
+	}
+}
+
+void merge(std::map<VkDeviceSize, buffer_piece_type> &pieces, VkDeviceSize offset,
+		VkDeviceSize end) {
+	auto piece(pieces.upper_bound(offset));
+	if (piece != pieces.begin()) {
+		--piece;
+	}
+	while (piece != pieces.end() && piece->first <= end) {
+		auto next(std::next(piece));
+		if (next != pieces.end() && next->first == piece->second.end
+				&& next->second.state == piece->second.state) {
+			piece->second.end = next->second.end;
+			pieces.erase(next);
+		} else {
+			piece = next;
+		}
+	}
+}
+
+std::map<VkDeviceSize, buffer_piece_type> &get_pieces(tracker_type &tracker, VkBuffer buffer,
+		VkDeviceSize buffer_size) {
+	std::map<VkDeviceSize, buffer_piece_type> &pieces(tracker.buffers[buffer]);
+	if (pieces.empty()) {
+		pieces.emplace(0, buffer_piece_type{ buffer_size, initial_state });
+	}
+	return pieces;
+}
+
+image_state_type &get_image(tracker_type &tracker, VkImage image, uint32_t mip_levels,
+		uint32_t array_layers) {
+	auto state(tracker.images.find(image));
+	if (state == tracker.images.end()) {
+		state = tracker.images.emplace(image, image_state_type{ mip_levels, array_layers,
+			std::vector<access_state_type>(mip_levels * array_layers, initial_state) }).first;
+	}
+	return state->second;
+}
+
+// Calls function with every mip level and array layer in range.
+template<typename FunctionT>
+void for_each_subresource(image_state_type &image, const VkImageSubresourceRange &range,
+		FunctionT function) {
+	const uint32_t level_count(range.levelCount == VK_REMAINING_MIP_LEVELS
+			? image.mip_levels - range.baseMipLevel : range.levelCount),
+		layer_count(range.layerCount == VK_REMAINING_ARRAY_LAYERS
+			? image.array_layers - range.baseArrayLayer : range.layerCount);
+	for (uint32_t level = range.baseMipLevel; level < range.baseMipLevel + level_count;
+			++level) {
+		for (uint32_t layer = range.baseArrayLayer;
+				layer < range.baseArrayLayer + layer_count; ++layer) {
+			function(image.subresources[level * image.array_layers + layer], level, layer);
+		}
+	}
+}
+
+bool mergeable(const VkImageMemoryBarrier &lhs, const VkImageMemoryBarrier &rhs) {
+	return lhs.image == rhs.image && lhs.srcAccessMask == rhs.srcAccessMask
+		&& lhs.dstAccessMask == rhs.dstAccessMask && lhs.oldLayout == rhs.oldLayout
+		&& lhs.newLayout == rhs.newLayout
+		&& lhs.subresourceRange.aspectMask == rhs.subresourceRange.aspectMask;
+}
+
+void merge(std::vector<VkImageMemoryBarrier> &barriers) {
+	std::vector<VkImageMemoryBarrier> merged;
+	for (const VkImageMemoryBarrier &barrier : barriers) {
+		if (!merged.empty() && mergeable(merged.back(), barrier)) {
+			VkImageSubresourceRange &range(merged.back().subresourceRange);
+			if (range.levelCount == 1
+					&& range.baseMipLevel == barrier.subresourceRange.baseMipLevel
+					&& range.baseArrayLayer + range.layerCount
+						== barrier.subresourceRange.baseArrayLayer) {
+				range.layerCount += barrier.subresourceRange.layerCount;
+				continue;
+			}
+		}
+		merged.push_back(barrier);
+	}
+	barriers.clear();
+	for (const VkImageMemoryBarrier &barrier : merged) {
+		const auto previous(std::find_if(barriers.begin(), barriers.end(),
+			[&barrier](const VkImageMemoryBarrier &previous) {
+				return mergeable(previous, barrier)
+					&& previous.subresourceRange.baseArrayLayer
+						== barrier.subresourceRange.baseArrayLayer
+					&& previous.subresourceRange.layerCount
+						== barrier.subresourceRange.layerCount
+					&& previous.subresourceRange.baseMipLevel
+						+ previous.subresourceRange.levelCount
+						== barrier.subresourceRange.baseMipLevel;
+			}));
+		if (previous != barriers.end()) {
+			previous->subresourceRange.levelCount += barrier.subresourceRange.levelCount;
+		} else {
+			barriers.push_back(barrier);
+		}
+	}
+}
+
+void access(tracker_type &tracker, VkBuffer buffer, VkDeviceSize buffer_size,
+		VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags stage,
+		VkAccessFlags access) {
+	const VkDeviceSize end(size == VK_WHOLE_SIZE ? buffer_size : offset + size);
+	if (offset >= end) {
+		return;
+	}
+	std::map<VkDeviceSize, buffer_piece_type> &pieces(get_pieces(tracker, buffer, buffer_size));
+	split(pieces, offset);
+	split(pieces, end);
+	for (auto piece(pieces.find(offset)); piece != pieces.end() && piece->first < end;
+			++piece) {
+		if (prepare(piece->second.state, stage, access, VK_IMAGE_LAYOUT_UNDEFINED,
+				tracker.src_stages, tracker.src_access, tracker.dst_access)) {
+			tracker.dst_stages |= stage;
+		}
+	}
+	merge(pieces, offset, end);
+}
+
+void access(tracker_type &tracker, VkImage image, uint32_t mip_levels,
+		uint32_t array_layers, const VkImageSubresourceRange &range, VkPipelineStageFlags stage,
+		VkAccessFlags access, VkImageLayout layout) {
+	for_each_subresource(get_image(tracker, image, mip_levels, array_layers), range,
+		[&](access_state_type &state, uint32_t level, uint32_t layer) {
+			const VkImageLayout old_layout(state.layout);
+			VkPipelineStageFlags src_stages(0);
+			VkAccessFlags src_access(0), dst_access(0);
+			if (prepare(state, stage, access, layout, src_stages, src_access, dst_access)) {
+				tracker.src_stages |= src_stages;
+				tracker.dst_stages |= stage;
+				tracker.image_barriers.push_back(VkImageMemoryBarrier{
+					VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, NULL, src_access, dst_access,
+					old_layout, layout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+					image, VkImageSubresourceRange{ range.aspectMask, level, 1, layer, 1 } });
+			}
+		});
+}
+
+void declare(tracker_type &tracker, VkImage image, uint32_t mip_levels,
+		uint32_t array_layers, const VkImageSubresourceRange &range, VkPipelineStageFlags stage,
+		VkAccessFlags access, VkImageLayout layout) {
+	for_each_subresource(get_image(tracker, image, mip_levels, array_layers), range,
+		[&](access_state_type &state, uint32_t level, uint32_t layer) {
+			state = initial_state;
+			update(state, stage, access, layout);
+			state.layout = layout;
+		});
+}
+
+bool barrier(tracker_type &tracker, VkPipelineStageFlags src_stages,
+		VkPipelineStageFlags dst_stages, const VkMemoryBarrier &barrier) {
+	bool useful(false);
+	for (auto &buffer : tracker.buffers) {
+		for (auto &piece : buffer.second) {
+			useful |= apply(piece.second.state, src_stages, dst_stages, barrier.srcAccessMask,
+				barrier.dstAccessMask);
+		}
+	}
+	for (auto &image : tracker.images) {
+		for (access_state_type &state : image.second.subresources) {
+			useful |= apply(state, src_stages, dst_stages, barrier.srcAccessMask,
+				barrier.dstAccessMask);
+		}
+	}
+	return useful;
+}
+
+bool barrier(tracker_type &tracker, VkPipelineStageFlags src_stages,
+		VkPipelineStageFlags dst_stages, VkDeviceSize buffer_size,
+		const VkBufferMemoryBarrier &barrier) {
+	const VkDeviceSize end(barrier.size == VK_WHOLE_SIZE ? buffer_size
+		: barrier.offset + barrier.size);
+	if (barrier.offset >= end) {
+		return false;
+	}
+	std::map<VkDeviceSize, buffer_piece_type> &pieces(
+		get_pieces(tracker, barrier.buffer, buffer_size));
+	split(pieces, barrier.offset);
+	split(pieces, end);
+	bool useful(false);
+	for (auto piece(pieces.find(barrier.offset)); piece != pieces.end() && piece->first < end;
+			++piece) {
+		useful |= apply(piece->second.state, src_stages, dst_stages, barrier.srcAccessMask,
+			barrier.dstAccessMask);
+	}
+	merge(pieces, barrier.offset, end);
+	return useful;
+}
+
+bool barrier(tracker_type &tracker, VkPipelineStageFlags src_stages,
+		VkPipelineStageFlags dst_stages, uint32_t mip_levels, uint32_t array_layers,
+		const VkImageMemoryBarrier &barrier) {
+	bool useful(false), mismatch(false);
+	for_each_subresource(get_image(tracker, barrier.image, mip_levels, array_layers),
+		barrier.subresourceRange,
+		[&](access_state_type &state, uint32_t level, uint32_t layer) {
+			if (barrier.oldLayout == barrier.newLayout) {
+				useful |= apply(state, src_stages, dst_stages, barrier.srcAccessMask,
+					barrier.dstAccessMask);
+			} else {
+				mismatch |= barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED
+					&& barrier.oldLayout != state.layout;
+				useful |= barrier.newLayout != state.layout;
+				transition(state, dst_stages, barrier.dstAccessMask, barrier.newLayout);
+			}
+		});
+	if (mismatch && tracker.report) {
+		std::ostringstream message;
+		message << "image memory barrier transitions from layout " << barrier.oldLayout
+			<< " which does not match the tracked layout";
+		tracker.report(message.str());
+	}
+	return useful;
+}
+
+void flush(tracker_type &tracker, VkCommandBuffer command_buffer, const char *command) {
+	if (!tracker.dst_stages) {
+		return;
+	}
+	if (tracker.mode == validate || tracker.render_pass) {
+		if (tracker.report) {
+			std::ostringstream message;
+			message << (tracker.render_pass ? "barrier needed inside a render pass before "
+				: "missing barrier before ") << command << ": stages 0x" << std::hex
+				<< tracker.src_stages << " to 0x" << tracker.dst_stages << ", access 0x"
+				<< tracker.src_access << " to 0x" << tracker.dst_access << std::dec << ", "
+				<< tracker.image_barriers.size() << " image subresources";
+			tracker.report(message.str());
+		}
+	} else {
+		merge(tracker.image_barriers);
+		const VkMemoryBarrier memory_barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL,
+			tracker.src_access, tracker.dst_access };
+		VKTRACE(vkCmdPipelineBarrier(command_buffer,
+			tracker.src_stages ? tracker.src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			tracker.dst_stages, 0, tracker.src_access || tracker.dst_access ? 1 : 0,
+			&memory_barrier, 0, NULL, (uint32_t) tracker.image_barriers.size(),
+			tracker.image_barriers.empty() ? NULL : tracker.image_barriers.data()));
+	}
+	tracker.src_stages = tracker.dst_stages = 0;
+	tracker.src_access = tracker.dst_access = 0;
+	tracker.image_barriers.clear();
+}
+
+}  // namespace internal
+}  // namespace tracking
+}  // namespace vcc
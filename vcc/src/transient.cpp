@@ -0,0 +1,154 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <vcc/transient.h>
+
+namespace vcc {
+namespace transient {
+
+namespace internal {
+
+thread_exit_type::~thread_exit_type() {
+	const std::thread::id thread_id(std::this_thread::get_id());
+	for (const std::weak_ptr<device_pool_type> &device_pool : device_pools) {
+		const std::shared_ptr<device_pool_type> pool(device_pool.lock());
+		if (!pool) {
+			continue;
+		}
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		for (auto it(pool->thread_pools.begin()); it != pool->thread_pools.end();) {
+			if (it->first.first != thread_id) {
+				++it;
+			} else if (it->second.borrowed) {
+				// Command buffers refer to the pool, the last one returned releases it.
+				it->second.orphaned = true;
+				++it;
+			} else {
+				it = pool->thread_pools.erase(it);
+			}
+		}
+	}
+}
+
+// Registers the calling thread for release of its pools of device_pool.
+void register_thread(const std::shared_ptr<device_pool_type> &device_pool) {
+	static thread_local thread_exit_type thread_exit;
+	for (const std::weak_ptr<device_pool_type> &registered : thread_exit.device_pools) {
+		if (registered.lock() == device_pool) {
+			return;
+		}
+	}
+	thread_exit.device_pools.push_back(device_pool);
+}
+
+}  // namespace internal
+
+command_type::~command_type() {
+	// Moved from commands have no command buffer instance.
+	if (vcc::internal::get_instance(command_buffer)) {
+		internal::device_pool_type &pool(*device::internal::get_transient_pool(*device));
+		// Drop whatever the last recording kept alive, keeping the memory.
+		command_buffer::internal::get_references(command_buffer).clear();
+		command_buffer::internal::get_pre_execute_hook(command_buffer).clear();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		const auto thread_pool(pool.thread_pools.find(
+			std::make_pair(thread_id, queue_family_index)));
+		--thread_pool->second.borrowed;
+		if (thread_pool->second.orphaned && !thread_pool->second.borrowed) {
+			// Freed before the pool it was allocated from.
+			command_buffer = command_buffer::command_buffer_type();
+			pool.thread_pools.erase(thread_pool);
+		} else {
+			thread_pool->second.command_buffers.push_back(std::move(command_buffer));
+		}
+		if (!fence_pending) {
+			pool.fences.push_back(std::move(fence));
+		}
+	}
+}
+
+command_type acquire(const device::device_type &device, uint32_t queue_family_index) {
+	const std::shared_ptr<internal::device_pool_type> &device_pool(
+		device::internal::get_transient_pool(device));
+	internal::device_pool_type &pool(*device_pool);
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	pool.used = true;
+	const auto key(std::make_pair(std::this_thread::get_id(), queue_family_index));
+	auto thread_pool(pool.thread_pools.find(key));
+	if (thread_pool == pool.thread_pools.end()) {
+		// The pool is owned by the device, a reference avoids a cycle.
+		thread_pool = pool.thread_pools.emplace(key, internal::thread_pool_type(
+			command_pool::create(std::cref(device),
+				VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+					| VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+				queue_family_index))).first;
+		internal::register_thread(device_pool);
+	}
+	command_buffer::command_buffer_type command_buffer;
+	if (thread_pool->second.command_buffers.empty()) {
+		command_buffer = std::move(command_buffer::allocate(std::cref(device),
+			std::cref(thread_pool->second.command_pool), VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			1).front());
+	} else {
+		command_buffer = std::move(thread_pool->second.command_buffers.back());
+		thread_pool->second.command_buffers.pop_back();
+	}
+	++thread_pool->second.borrowed;
+	fence::fence_type fence;
+	if (pool.fences.empty()) {
+		fence = fence::create(std::cref(device));
+	} else {
+		fence = std::move(pool.fences.back());
+		pool.fences.pop_back();
+	}
+	return command_type(device, queue_family_index, std::move(command_buffer),
+		std::move(fence));
+}
+
+void submit_and_wait(const queue::queue_type &queue, const command_type &command) {
+	try {
+		queue::submit(queue, {}, { command.command_buffer }, {}, command.fence);
+		fence::wait(*command.device, { command.fence }, true);
+	} catch (...) {
+		// The fence may still be pending, it must not be handed out again.
+		command.fence_pending = true;
+		throw;
+	}
+	// Leave the fence unsignaled so the command can be submitted again.
+	fence::reset(*command.device, { command.fence });
+}
+
+semaphore::semaphore_type acquire_semaphore(const device::device_type &device) {
+	internal::device_pool_type &pool(*device::internal::get_transient_pool(device));
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.used = true;
+		if (!pool.semaphores.empty()) {
+			semaphore::semaphore_type semaphore(std::move(pool.semaphores.back()));
+			pool.semaphores.pop_back();
+			return semaphore;
+		}
+	}
+	return semaphore::create(std::cref(device));
+}
+
+void recycle(const device::device_type &device, semaphore::semaphore_type &&semaphore) {
+	internal::device_pool_type &pool(*device::internal::get_transient_pool(device));
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	pool.semaphores.push_back(std::move(semaphore));
+}
+
+}  // namespace transient
+}  // namespace vcc
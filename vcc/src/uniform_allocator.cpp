@@ -0,0 +1,72 @@
+/*
+* Copyright 2016 Google Inc. All Rights Reserved.
+
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <vcc/uniform_allocator.h>
+
+namespace vcc {
+namespace uniform_allocator {
+
+namespace internal {
+
+uint32_t write(uniform_allocator_type &allocator, const type::serialize_type &serialize) {
+	const VkDeviceSize size(type::size(serialize));
+	// Rounded up so the offset of the next allocation stays aligned.
+	const VkDeviceSize aligned_size((size + allocator.alignment - 1)
+		/ allocator.alignment * allocator.alignment);
+	const VkDeviceSize offset(allocator.state->offset.fetch_add(aligned_size));
+	if (offset + size > allocator.size) {
+		throw vcc_exception("uniform allocator is full");
+	}
+	const buffer::buffer_type &buffer(*allocator.buffer);
+	const memory::map_type map(memory::map(vcc::internal::get_memory(buffer),
+		vcc::internal::get_offset(buffer) + offset, size));
+	type::flush(serialize, map.data);
+	return uint32_t(offset);
+}
+
+}  // namespace internal
+
+uniform_allocator_type create(const type::supplier<const device::device_type> &device,
+		VkDeviceSize size) {
+	std::shared_ptr<buffer::buffer_type> buffer(std::make_shared<buffer::buffer_type>(
+		buffer::create(device, 0, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_SHARING_MODE_EXCLUSIVE, {})));
+	memory::bind(device, memory::cpu_to_gpu, *buffer);
+	const VkDeviceSize alignment(physical_device::properties(
+		device::get_physical_device(*device)).limits.minUniformBufferOffsetAlignment);
+	return uniform_allocator_type(buffer, size, alignment ? alignment : 1);
+}
+
+const type::supplier<const buffer::buffer_type> &get_buffer(
+		const uniform_allocator_type &allocator) {
+	return allocator.buffer;
+}
+
+void reset(uniform_allocator_type &allocator) {
+	allocator.state->offset = 0;
+}
+
+#if defined(VK_KHR_timeline_semaphore)
+
+void reset(uniform_allocator_type &allocator, const progress::progress_type &progress,
+		uint64_t value) {
+	progress::wait(progress, value);
+	reset(allocator);
+}
+
+#endif // VK_KHR_timeline_semaphore
+
+}  // namespace uniform_allocator
+}  // namespace vcc
@@ -20,6 +20,7 @@
 #include <vcc/command.h>
 #include <vcc/physical_device.h>
 #include <vcc/surface.h>
+#include <vcc/transient.h>
 #include <vcc/window.h>
 #ifdef _WIN32
 #include <windowsx.h>
@@ -144,12 +145,11 @@ swapchain::swapchain_type resize(window_type &window, VkExtent2D extent,
 	std::vector<std::shared_ptr<vcc::image::image_type>> swapchain_images;
 	swapchain_images.reserve(images.size());
 
-	vcc::command_buffer::command_buffer_type command_buffer(std::move(
-		vcc::command_buffer::allocate(window.device, std::ref(window.cmd_pool),
-			VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1).front()));
+	vcc::transient::command_type command(vcc::transient::acquire(window.present_queue));
 	{
-		vcc::command::build_type build(
-			vcc::command::build(std::ref(command_buffer), 0, VK_FALSE, 0, 0));
+		vcc::command::build_type build(vcc::command::build(
+			std::ref(vcc::transient::get_command_buffer(command)),
+			VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, VK_FALSE, 0, 0));
 		for (vcc::image::image_type &si : images) {
 			std::shared_ptr<vcc::image::image_type> swapchain_image(
 				std::make_shared<vcc::image::image_type>(std::move(si)));
@@ -171,9 +171,7 @@ swapchain::swapchain_type resize(window_type &window, VkExtent2D extent,
 			swapchain_images.push_back(std::move(swapchain_image));
 		}
 	}
-	vcc::fence::fence_type fence(vcc::fence::create(window.device));
-	vcc::queue::submit(window.present_queue, {}, { command_buffer }, {}, fence);
-	vcc::fence::wait(*window.device, { fence }, true);
+	vcc::transient::submit_and_wait(window.present_queue, command);
 
 	swapchain_create_callback(extent, window.format, std::move(swapchain_images));
 	return swapchain;
@@ -258,9 +256,6 @@ void initialize(window_type &window,
 
 	window.present_queue = queue::get_present_queue(window.device, window.surface);
 
-	window.cmd_pool = vcc::command_pool::create(window.device, 0,
-		vcc::queue::get_family_index(window.present_queue));
-
 	// Get the list of VkFormat's that are supported:
 	const VkPhysicalDevice physical_device(device::get_physical_device(*window.device));
 	const std::vector<VkSurfaceFormatKHR> surface_formats(